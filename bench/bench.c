@@ -0,0 +1,563 @@
+//
+// Created by Davide on 16/10/2026.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "csv.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_CYCLES
+#endif
+
+#define DEFAULT_SIZE (64 << 20)
+#define DEFAULT_RUNS 5
+#define DEFAULT_WARMUP 1
+#define SEED 0x9E3779B97F4A7C15ULL
+#define CACHE_PATH "/tmp/c-csv-bench.csv"
+
+/**
+ * A generated dataset
+ * name identifies the shape of the data, data holds length bytes
+ */
+typedef struct {
+        const char *name;
+        char *data;
+        size_t length;
+} Dataset;
+
+/**
+ * Counters updated by the callbacks and by the allocator.
+ * writer receives the records in write mode
+ */
+typedef struct {
+        size_t records;
+        size_t fields;
+        size_t bytes;
+        size_t allocations;
+        CsvWriter *writer;
+} Counters;
+
+/**
+ * The result of a benchmark: the median of the runs
+ */
+typedef struct {
+        double seconds;
+        double cycles;
+        size_t records;
+        size_t allocations;
+} Measure;
+
+/**
+ * The way the input is parsed
+ */
+typedef enum {
+        MODE_VIEW,
+        MODE_RECORD,
+        MODE_BATCH,
+        MODE_STREAM,
+        MODE_PREFETCH,
+        MODE_PARALLEL,
+        MODE_WRITE,
+        MODE_SCAN,
+        MODE_CACHE,
+        MODE_COUNT
+} Mode;
+
+const char *modeNames[MODE_COUNT] = {"view", "record", "batch", "stream", "prefetch", "parallel", "write", "count",
+                                     "cache"};
+const char *shapeNames[] = {"narrow", "wide", "quoted", "multiline", "long", "crlf"};
+
+#define SHAPE_COUNT (sizeof shapeNames / sizeof *shapeNames)
+
+// Private prototypes
+
+/**
+ * A xorshift generator, so that the datasets are the same on every machine
+ * @param state the state of the generator
+ * @return the next random number
+ */
+uint64_t next_random(uint64_t *state);
+
+/**
+ * Generate a dataset of about size bytes
+ * @param shape the name of the shape
+ * @param size the size of the dataset
+ * @param dataset output, the dataset
+ * @return 0 on success, -1 if the shape is unknown
+ */
+int generate(const char *shape, size_t size, Dataset *dataset);
+
+/**
+ * Append a number to a buffer
+ * @param buffer the buffer
+ * @param state the state of the generator
+ * @param real 1 to append a number with decimals
+ */
+void append_number(Buffer *buffer, uint64_t *state, int real);
+
+/**
+ * Append a random text to a buffer
+ * @param buffer the buffer
+ * @param state the state of the generator
+ * @param length the length of the text
+ * @param special characters which may appear in the text, besides letters
+ */
+void append_text(Buffer *buffer, uint64_t *state, size_t length, const char *special);
+
+/**
+ * Parse a dataset once
+ * @param dataset the dataset
+ * @param mode the parsing mode
+ * @param threads the number of threads of the parallel mode
+ * @param counters output, the counters of the run
+ * @param cycles output, the elapsed time stamp counter cycles, 0 if the
+ *               counter is not available
+ * @return the elapsed time in seconds
+ */
+double run(const Dataset *dataset, Mode mode, int threads, Counters *counters, double *cycles);
+
+/**
+ * Parse a dataset several times, after some warmup runs. In cache mode
+ * the dataset is written to CACHE_PATH, and its cache is written by the
+ * first warmup run
+ * @param dataset the dataset
+ * @param mode the parsing mode
+ * @param threads the number of threads of the parallel mode
+ * @param runs the number of measured runs
+ * @param warmup the number of runs which are not measured
+ * @return the median of the runs
+ */
+Measure measure(const Dataset *dataset, Mode mode, int threads, int runs, int warmup);
+
+/**
+ * Compare two doubles, for qsort
+ */
+int compare_double(const void *a, const void *b);
+
+/**
+ * @return the time of a monotonic clock, in seconds
+ */
+double now(void);
+
+/**
+ * @return the time stamp counter, 0 if it is not available
+ */
+uint64_t cycles_now(void);
+
+/**
+ * Allocator of the readers, counting the allocations in the Counters
+ * passed as context
+ */
+void *counting_alloc(void *context, size_t size);
+void counting_free(void *context, void *ptr);
+
+/**
+ * Callbacks of the readers, counting the records in the Counters passed
+ * as context
+ */
+void header_view(void *context, RecordView *header);
+void record_view(void *context, RecordView *header, RecordView *record);
+void record_copy(void *context, Record *header, Record *record);
+void record_write(void *context, RecordView *header, RecordView *record);
+void record_batch(void *context, RecordView *header, RecordBatch *batch);
+
+
+int main(int argc, char **argv)
+{
+        size_t size = DEFAULT_SIZE;
+        int runs = DEFAULT_RUNS;
+        int warmup = DEFAULT_WARMUP;
+        int threads = 4;
+        int machine = 0;
+        const char *shape = NULL;
+        const char *mode = NULL;
+        Dataset dataset;
+        Measure result;
+        double megabytes;
+        size_t i;
+        int m;
+
+        for (m = 1; m < argc; m++) {
+                if (strcmp(argv[m], "--size") == 0 && m + 1 < argc)
+                        size = (size_t) strtoul(argv[++m], NULL, 10) << 20;
+                else if (strcmp(argv[m], "--runs") == 0 && m + 1 < argc)
+                        runs = atoi(argv[++m]);
+                else if (strcmp(argv[m], "--warmup") == 0 && m + 1 < argc)
+                        warmup = atoi(argv[++m]);
+                else if (strcmp(argv[m], "--threads") == 0 && m + 1 < argc)
+                        threads = atoi(argv[++m]);
+                else if (strcmp(argv[m], "--shape") == 0 && m + 1 < argc)
+                        shape = argv[++m];
+                else if (strcmp(argv[m], "--mode") == 0 && m + 1 < argc)
+                        mode = argv[++m];
+                else if (strcmp(argv[m], "--csv") == 0)
+                        machine = 1;
+                else {
+                        fprintf(stderr, "Usage: %s [--size MiB] [--runs n] [--warmup n] [--threads n] "
+                                        "[--shape narrow|wide|quoted|multiline|long|crlf] "
+                                        "[--mode view|record|batch|stream|prefetch|parallel|write|count|cache] [--csv]\n",
+                                argv[0]);
+                        return 1;
+                }
+        }
+
+        if (runs < 1)
+                runs = 1;
+
+        if (machine)
+                printf("shape,mode,bytes,records,seconds,mb_per_s,records_per_s,allocations_per_record,cycles_per_byte\n");
+        else
+                printf("%-10s %-9s %10s %12s %14s %12s %14s\n",
+                       "shape", "mode", "MB/s", "records/s", "allocs/record", "cycles/byte", "records");
+
+        for (i = 0; i < SHAPE_COUNT; i++) {
+                if (shape != NULL && strcmp(shape, shapeNames[i]) != 0)
+                        continue;
+
+                generate(shapeNames[i], size, &dataset);
+                megabytes = (double) dataset.length / (1 << 20);
+
+                for (m = 0; m < MODE_COUNT; m++) {
+                        if (mode != NULL && strcmp(mode, modeNames[m]) != 0)
+                                continue;
+
+                        result = measure(&dataset, (Mode) m, threads, runs, warmup);
+
+                        if (machine) {
+                                printf("%s,%s,%zu,%zu,%.6f,%.2f,%.0f,%.4f,%.3f\n",
+                                       dataset.name, modeNames[m], dataset.length, result.records, result.seconds,
+                                       megabytes / result.seconds, (double) result.records / result.seconds,
+                                       result.records ? (double) result.allocations / (double) result.records : 0.0,
+                                       result.cycles / (double) dataset.length);
+                        } else {
+                                printf("%-10s %-9s %10.1f %12.0f %14.4f %12.3f %14zu\n",
+                                       dataset.name, modeNames[m], megabytes / result.seconds,
+                                       (double) result.records / result.seconds,
+                                       result.records ? (double) result.allocations / (double) result.records : 0.0,
+                                       result.cycles / (double) dataset.length, result.records);
+                        }
+                        fflush(stdout);
+                }
+
+                free(dataset.data);
+        }
+
+        return 0;
+}
+
+// Private Implementation
+
+uint64_t next_random(uint64_t *state)
+{
+        uint64_t x = *state;
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        *state = x;
+        return x;
+}
+
+int generate(const char *shape, size_t size, Dataset *dataset)
+{
+        Buffer *buffer = buffer_alloc(size + (1 << 20));
+        uint64_t state = SEED;
+        const char *lineEnding = strcmp(shape, "crlf") == 0 ? "\r\n" : "\n";
+        size_t columns;
+        size_t i;
+
+        if (buffer == NULL) {
+                perror("Cannot alloc memory buffer for the dataset");
+                abort();
+        }
+
+        if (strcmp(shape, "wide") == 0)
+                columns = 512;
+        else if (strcmp(shape, "long") == 0)
+                columns = 3;
+        else if (strcmp(shape, "quoted") == 0 || strcmp(shape, "multiline") == 0)
+                columns = 6;
+        else
+                columns = 8;
+
+        for (i = 0; i < columns; i++) {
+                char name[32];
+                snprintf(name, sizeof name, "%scolumn%zu", i ? "," : "", i);
+                buffer_append_str(buffer, name, strlen(name));
+        }
+        buffer_append_str(buffer, lineEnding, strlen(lineEnding));
+
+        while (buffer->stringLength < size) {
+                for (i = 0; i < columns; i++) {
+                        if (i > 0)
+                                buffer_append(buffer, ',');
+
+                        if (strcmp(shape, "quoted") == 0) {
+                                buffer_append(buffer, '"');
+                                append_text(buffer, &state, 4 + next_random(&state) % 24, ",\"");
+                                buffer_append(buffer, '"');
+                        } else if (strcmp(shape, "multiline") == 0) {
+                                buffer_append(buffer, '"');
+                                append_text(buffer, &state, 8 + next_random(&state) % 56, "\n,");
+                                buffer_append(buffer, '"');
+                        } else if (strcmp(shape, "long") == 0) {
+                                append_text(buffer, &state, 16384 + next_random(&state) % 49152, NULL);
+                        } else if (strcmp(shape, "wide") == 0) {
+                                append_number(buffer, &state, 0);
+                        } else {
+                                append_number(buffer, &state, i % 2);
+                        }
+                }
+                buffer_append_str(buffer, lineEnding, strlen(lineEnding));
+        }
+
+        dataset->name = shape;
+        dataset->length = buffer->stringLength;
+        dataset->data = buffer->buffer;
+        free(buffer);
+        return 0;
+}
+
+void append_number(Buffer *buffer, uint64_t *state, int real)
+{
+        char number[32];
+        uint64_t value = next_random(state);
+
+        if (real)
+                snprintf(number, sizeof number, "%lld.%03d", (long long) (value % 200000) - 100000, (int) (value >> 40) % 1000);
+        else
+                snprintf(number, sizeof number, "%lld", (long long) (value % 100000));
+        buffer_append_str(buffer, number, strlen(number));
+}
+
+void append_text(Buffer *buffer, uint64_t *state, size_t length, const char *special)
+{
+        uint64_t value = 0;
+        size_t i;
+        char c;
+
+        for (i = 0; i < length; i++) {
+                if (i % 8 == 0)
+                        value = next_random(state);
+
+                c = (char) ('a' + (value & 0xFF) % 26);
+                if (special != NULL && (value & 0xFF) % 29 == 0) {
+                        c = special[(value >> 8) % strlen(special)];
+                        // Double quotes are escaped
+                        if (c == '"')
+                                buffer_append(buffer, '"');
+                }
+
+                buffer_append(buffer, c);
+                value >>= 8;
+        }
+}
+
+double run(const Dataset *dataset, Mode mode, int threads, Counters *counters, double *cycles)
+{
+        CsvReader *reader;
+        FILE *stream = NULL;
+        double start;
+        uint64_t startCycles;
+
+        memset(counters, 0, sizeof *counters);
+
+        if (mode == MODE_RECORD)
+                reader = csv_reader_alloc(NULL, &record_copy, counters);
+        else if (mode == MODE_WRITE)
+                reader = csv_reader_alloc_view(&header_view, &record_write, counters);
+        else if (mode == MODE_BATCH)
+                reader = csv_reader_alloc_view(&header_view, NULL, counters);
+        else
+                reader = csv_reader_alloc_view(&header_view, &record_view, counters);
+
+        csv_reader_set_allocator(reader, &counting_alloc, &counting_free, counters);
+
+        if (mode == MODE_BATCH)
+                csv_reader_set_record_batch(reader, &record_batch, 0);
+
+        // The stream is read ahead by a background thread in prefetch mode
+        if (mode == MODE_PREFETCH)
+                csv_reader_set_read_ahead(reader, 4);
+
+        if (mode == MODE_CACHE)
+                csv_reader_set_cache(reader, 1);
+
+        if (mode == MODE_STREAM || mode == MODE_PREFETCH) {
+                stream = tmpfile();
+                if (stream == NULL || fwrite(dataset->data, 1, dataset->length, stream) != dataset->length) {
+                        perror("Cannot write the dataset");
+                        abort();
+                }
+                rewind(stream);
+        }
+
+        // The records are read and written back to /dev/null
+        if (mode == MODE_WRITE) {
+                counters->writer = csv_writer_open_path("/dev/null");
+                if (counters->writer == NULL) {
+                        perror("Cannot open /dev/null");
+                        abort();
+                }
+        }
+
+        start = now();
+        startCycles = cycles_now();
+
+        switch (mode) {
+                case MODE_STREAM:
+                case MODE_PREFETCH:
+                        csv_reader_parse(reader, stream);
+                        break;
+                case MODE_PARALLEL:
+                        csv_reader_parse_memory_parallel(reader, dataset->data, dataset->length, threads, 0);
+                        break;
+                case MODE_SCAN:
+                        csv_count_records_memory(reader, dataset->data, dataset->length, &counters->records);
+                        break;
+                case MODE_CACHE:
+                        csv_reader_parse_path(reader, CACHE_PATH);
+                        break;
+                default:
+                        csv_reader_parse_memory(reader, dataset->data, dataset->length);
+                        break;
+        }
+
+        if (counters->writer != NULL)
+                csv_writer_close(counters->writer);
+
+        *cycles = (double) (cycles_now() - startCycles);
+        start = now() - start;
+
+        if (stream != NULL)
+                fclose(stream);
+        csv_reader_free(reader);
+        return start;
+}
+
+Measure measure(const Dataset *dataset, Mode mode, int threads, int runs, int warmup)
+{
+        double *seconds = malloc(sizeof(double) * (size_t) runs);
+        double *cycles = malloc(sizeof(double) * (size_t) runs);
+        Counters counters;
+        Measure result;
+        FILE *stream;
+        double ignored;
+        int i;
+
+        if (seconds == NULL || cycles == NULL) {
+                perror("Cannot alloc memory buffer for the benchmark");
+                abort();
+        }
+
+        if (mode == MODE_CACHE) {
+                stream = fopen(CACHE_PATH, "wb");
+                if (stream == NULL || fwrite(dataset->data, 1, dataset->length, stream) != dataset->length ||
+                    fclose(stream) != 0) {
+                        perror("Cannot write the dataset");
+                        abort();
+                }
+
+                // The cache is never written by a measured run
+                if (warmup < 1)
+                        warmup = 1;
+        }
+
+        for (i = 0; i < warmup; i++) {
+                run(dataset, mode, threads, &counters, &ignored);
+        }
+
+        for (i = 0; i < runs; i++) {
+                seconds[i] = run(dataset, mode, threads, &counters, &cycles[i]);
+        }
+
+        qsort(seconds, (size_t) runs, sizeof(double), &compare_double);
+        qsort(cycles, (size_t) runs, sizeof(double), &compare_double);
+
+        result.seconds = seconds[runs / 2];
+        result.cycles = cycles[runs / 2];
+        result.records = counters.records;
+        result.allocations = counters.allocations;
+
+        if (mode == MODE_CACHE) {
+                remove(CACHE_PATH);
+                remove(CACHE_PATH CSV_CACHE_SUFFIX);
+        }
+
+        free(seconds);
+        free(cycles);
+        return result;
+}
+
+int compare_double(const void *a, const void *b)
+{
+        double x = *(const double *) a;
+        double y = *(const double *) b;
+        return (x > y) - (x < y);
+}
+
+double now(void)
+{
+        struct timespec time;
+        clock_gettime(CLOCK_MONOTONIC, &time);
+        return (double) time.tv_sec + (double) time.tv_nsec / 1e9;
+}
+
+uint64_t cycles_now(void)
+{
+#ifdef HAVE_CYCLES
+        return __rdtsc();
+#else
+        return 0;
+#endif
+}
+
+void *counting_alloc(void *context, size_t size)
+{
+        Counters *counters = context;
+        // The parallel workers allocate concurrently
+        __atomic_fetch_add(&counters->allocations, 1, __ATOMIC_RELAXED);
+        return malloc(size);
+}
+
+void counting_free(void *context, void *ptr)
+{
+        free(ptr);
+}
+
+void header_view(void *context, RecordView *header)
+{
+}
+
+void record_view(void *context, RecordView *header, RecordView *record)
+{
+        Counters *counters = context;
+        __atomic_fetch_add(&counters->records, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&counters->fields, record->arraySize, __ATOMIC_RELAXED);
+}
+
+void record_copy(void *context, Record *header, Record *record)
+{
+        Counters *counters = context;
+        counters->records += 1;
+        counters->fields += record->arraySize;
+}
+
+void record_write(void *context, RecordView *header, RecordView *record)
+{
+        Counters *counters = context;
+        counters->records += 1;
+        counters->fields += record->arraySize;
+        csv_writer_write_view(counters->writer, record);
+}
+
+void record_batch(void *context, RecordView *header, RecordBatch *batch)
+{
+        Counters *counters = context;
+        counters->records += batch->length;
+        counters->fields += batch->fieldCount;
+}
@@ -9,14 +9,131 @@
 
 #include "../src/record.h"
 #include "../src/buffer.h"
+#include "../src/schema.h"
+#include "../src/batch.h"
+#include "../src/predicate.h"
+#include "../src/index.h"
+#include "../src/dialect.h"
+#include "../src/dictionary.h"
+
+#define CSV_END 0
+#define CSV_STOPPED 1
+#define CSV_PAUSED 2
+
+#define CSV_CACHE_SUFFIX ".cache"
+
+/**
+ * A column selected with csv_reader_select_column (name is a copy of the
+ * name) or with csv_reader_select_index (name is NULL)
+ */
+typedef struct ColumnSelection_s {
+        char *name;
+        size_t index;
+} ColumnSelection;
+
+/**
+ * A column whose values are interned in dictionary (see
+ * csv_reader_intern_column), name is a copy of the name of the column
+ */
+typedef struct InternedColumn_s {
+        char *name;
+        Dictionary *dictionary;
+} InternedColumn;
+
+/**
+ * Statistics collected by the parser (see csv_reader_stats)
+ *
+ * @param bytes number of bytes parsed
+ * @param records number of records parsed, the header included
+ * @param skippedRecords records not delivered because they do not satisfy
+ *                       the predicates of the reader
+ * @param fields number of fields parsed, including those of the columns
+ *               which are not selected
+ * @param quotedFields number of fields enclosed in double quotes
+ * @param multilineRecords number of records containing a new line inside
+ *                         a quoted field
+ * @param bufferGrowths number of times the input buffer has been enlarged
+ *                      because a record was longer than a block
+ * @param largestRecord size in bytes of the longest record
+ * @param totalTime seconds spent parsing, callbacks included (summed over
+ *                  the threads when parsing in parallel)
+ * @param callbackTime seconds spent in the callbacks
+ */
+typedef struct CsvStats_s {
+        size_t bytes;
+        size_t records;
+        size_t skippedRecords;
+        size_t fields;
+        size_t quotedFields;
+        size_t multilineRecords;
+        size_t bufferGrowths;
+        size_t largestRecord;
+        double totalTime;
+        double callbackTime;
+} CsvStats;
 
 /**
  * CsvReader data structure
+ * Callbacks receiving a Record get a copy of each field, callbacks receiving
+ * a RecordView get views on the parser buffers (see csv_reader_alloc_view).
+ * Both kinds of callbacks can be set on the same reader.
+ * allocator provides the memory used by the parser, by default malloc
+ * (see csv_reader_set_allocator).
+ * blockSize is the number of bytes read at a time from streams
+ * (see csv_reader_set_block_size), readAhead the number of blocks read in
+ * advance by a background thread (see csv_reader_set_read_ahead).
+ * feed is the state of the parser between calls to csv_reader_feed.
+ * batch receives the records in column major batches of batchSize rows,
+ * whose columns have the types of schema (see csv_reader_set_batch).
+ * recordBatch receives the records in row major batches of recordBatchSize
+ * records (see csv_reader_set_record_batch).
+ * selection holds the selectionCount columns to read, if none is selected
+ * all the columns are read (see csv_reader_select_column).
+ * predicates holds the predicateCount conditions the records must satisfy
+ * to be delivered (see csv_reader_filter_equals).
+ * interned holds the internedCount columns whose values are stored once in
+ * a dictionary (see csv_reader_intern_column).
+ * Parsing starts from record startRecord, which is reached using index if
+ * it is not NULL (see csv_reader_seek_record).
+ * stats accumulates the statistics of the parsing, times are measured only
+ * if statsTiming is 1 (see csv_reader_stats).
+ * dialect is the syntax of the input, CSV by default
+ * (see csv_reader_set_dialect).
+ * control holds the requests of the callbacks to the parser, offset the
+ * position where the last parsing stopped, and paused the state of a paused
+ * parsing (see csv_reader_stop).
+ * cache is 1 if files are read from their cache (see csv_reader_set_cache)
  */
 typedef struct CsvReader_s {
         void *context;
+        Allocator allocator;
+        size_t blockSize;
+        size_t readAhead;
         void (*header)(void *, Record *);
         void (*record)(void *, Record *, Record *);
+        void (*headerView)(void *, RecordView *);
+        void (*recordView)(void *, RecordView *, RecordView *);
+        void (*batch)(void *, RecordView *, Batch *);
+        const Schema *schema;
+        size_t batchSize;
+        void (*recordBatch)(void *, RecordView *, RecordBatch *);
+        size_t recordBatchSize;
+        ColumnSelection *selection;
+        size_t selectionCount;
+        Predicate *predicates;
+        size_t predicateCount;
+        InternedColumn *interned;
+        size_t internedCount;
+        const RecordIndex *index;
+        size_t startRecord;
+        CsvStats stats;
+        int statsTiming;
+        Dialect dialect;
+        struct ParsingContext_s *feed;
+        int control;
+        size_t offset;
+        struct ParsingContext_s *paused;
+        int cache;
 } CsvReader;
 
 /**
@@ -44,12 +161,900 @@ CsvReader *csv_reader_alloc(void (*headerCallback)(void *, Record *),
                             void (*recordCallback)(void *, Record *, Record *),
                             void *context);
 
+/**
+ * Allocate a CsvReader Instance which does not copy the fields
+ * @param headerCallback a pointer to a function with signature
+ *                       void (void *context, RecordView *header).
+ *                       The header is copied by the parser, so its views
+ *                       are valid until the end of the parsing. If null,
+ *                       no function will be invoked
+ * @param recordCallback a pointer to a function with signature
+ *                       void (void *context, RecordView *header, RecordView *record).
+ *                       The fields of record point inside the parser buffers:
+ *                       they are not null terminated and they are valid
+ *                       only until the callback returns. Only quoted fields
+ *                       containing escaped double quotes are copied.
+ *                       If NULL, no function will be invoked
+ * @param context Context object passed to the callback functions
+ * @return A CsvReader Instance
+ */
+CsvReader *csv_reader_alloc_view(void (*headerCallback)(void *, RecordView *),
+                                 void (*recordCallback)(void *, RecordView *, RecordView *),
+                                 void *context);
+
+/**
+ * Set the allocator used by the parser for its buffers and for the records.
+ * The fields of the records are stored in per-parse arenas whose chunks
+ * are obtained from the allocator, so in steady state parsing a record
+ * does not allocate
+ * @param reader the CsvReader instance
+ * @param alloc a function with the semantic of malloc, with signature
+ *              void *(void *context, size_t size). If NULL, malloc and free
+ *              are used
+ * @param free a function with the semantic of free, with signature
+ *             void (void *context, void *ptr)
+ * @param context passed as first argument to alloc and free
+ * @return 0 on success, -1 with errno set to EBUSY if a parsing is paused
+ *         or input is being fed, whose memory comes from the previous
+ *         allocator (see csv_reader_filter_equals)
+ */
+int csv_reader_set_allocator(CsvReader *reader,
+                             void *(*alloc)(void *, size_t),
+                             void (*free)(void *, void *),
+                             void *context);
+
+/**
+ * Set the number of bytes read at a time when parsing a stream.
+ * The parser never keeps more than a block plus the longest record in memory
+ * @param reader the CsvReader instance
+ * @param blockSize the size of a block, 1 MiB by default. If 0 the default
+ *                  size is used
+ */
+void csv_reader_set_block_size(CsvReader *reader, size_t blockSize);
+
+/**
+ * Read streams in advance on a background thread, so that reading and
+ * parsing overlap: the time spent waiting for a slow device or a cold page
+ * cache is hidden behind the parsing of the previous blocks.
+ * The thread reads up to blocks blocks ahead of the parser, which takes
+ * them without copying them (only a record split between two blocks is
+ * copied). It applies to csv_reader_parse, csv_reader_parse_fd and to the
+ * iterators on streams; the stream is read past the record the parser has
+ * reached, up to the end of the input.
+ * Only available on POSIX systems, elsewhere the stream is read by the
+ * parser
+ * @param reader the CsvReader instance
+ * @param blocks the number of blocks read in advance, 0 (the default) to
+ *               read the stream on the calling thread
+ */
+void csv_reader_set_read_ahead(CsvReader *reader, size_t blocks);
+
+/**
+ * Read the files parsed by path from a binary cache, stored next to each
+ * file with the name of the file followed by CSV_CACHE_SUFFIX.
+ * The cache holds the fields of all the records, unescaped, and the values
+ * of the numeric columns already converted: a file read from its cache is
+ * not parsed, its fields are views on the mapped cache. The records are
+ * delivered to the callbacks as if the file had been parsed, selection,
+ * predicates and starting record included; the columns of the batches
+ * (see csv_reader_set_batch) take the converted values when their type
+ * matches. Statistics count the records, fields and bytes read, not the
+ * quoted fields nor the multiline records.
+ * The first time a file is read, and whenever the cache does not match
+ * the file any more, the file is parsed to write its cache. The cache
+ * matches a file if its size, its inode, the times of its last
+ * modification and of the last change of its status, in nanoseconds, the
+ * hash of its first and last 64 KiB and the dialect of the reader are the
+ * same as when the cache was written. If the cache cannot be written, the file is parsed.
+ * It applies to csv_reader_parse_path, csv_iterator_open_path and
+ * csv_count_records. Only available on POSIX systems
+ * @param reader the CsvReader instance
+ * @param enabled 1 to read the files from their cache, 0 (the default) to
+ *                parse them
+ */
+void csv_reader_set_cache(CsvReader *reader, int enabled);
+
+/**
+ * Set the syntax of the input (see Dialect), e.g. for a TSV file:
+ *      Dialect dialect;
+ *      dialect_init(&dialect, '\t');
+ *      csv_reader_set_dialect(reader, &dialect);
+ * Dialects with an escape character different from the quote are parsed
+ * sequentially by csv_reader_parse_parallel
+ * @param reader the CsvReader
+ * @param dialect the dialect, it is copied
+ * @return 0 on success, -1 if the dialect is not valid (errno is set to
+ *         EINVAL)
+ */
+int csv_reader_set_dialect(CsvReader *reader, const Dialect *dialect);
+
+/**
+ * Deliver the records in column major batches, in addition to the
+ * other callbacks. Numeric columns are stored in int64_t and double arrays,
+ * string columns in a single buffer with an array of offsets, and each
+ * column has a validity bitmap (see Batch).
+ * A batch is delivered when it holds batchSize records, and at the end of
+ * the file. When parsing in parallel each worker fills its own batches,
+ * which are delivered like the records (see csv_reader_parse_memory_parallel);
+ * in ordered mode a batch never holds the records of two chunks
+ * @param reader the CsvReader instance
+ * @param batchCallback a pointer to a function with signature
+ *                      void (void *context, RecordView *header, Batch *batch).
+ *                      The batch is reused once the callback returns
+ * @param schema the types of the columns, usually inferred with
+ *               csv_reader_infer_schema. It must outlive the parsing. If
+ *               NULL, all the columns of the header are stored as strings
+ * @param batchSize the number of records of a batch
+ */
+void csv_reader_set_batch(CsvReader *reader,
+                          void (*batchCallback)(void *, RecordView *, Batch *),
+                          const Schema *schema,
+                          size_t batchSize);
+
+/**
+ * Deliver the records in row major batches, in addition to the other
+ * callbacks: the callback is invoked once for up to batchSize records,
+ * instead of once per record. The fields of the records of a batch are
+ * copied in a single block, and the same block is reused by all the
+ * batches of a parse (see RecordBatch).
+ * A batch is delivered when it holds batchSize records, and at the end of
+ * the file. When parsing in parallel each worker fills its own batches, as
+ * with csv_reader_set_batch
+ * @param reader the CsvReader instance
+ * @param batchCallback a pointer to a function with signature
+ *                      void (void *context, RecordView *header, RecordBatch *batch).
+ *                      The batch is valid until the callback returns.
+ *                      If NULL, no batch is delivered
+ * @param batchSize the maximum number of records of a batch, if 0 the
+ *                  records are delivered 1024 at a time
+ */
+void csv_reader_set_record_batch(CsvReader *reader,
+                                 void (*batchCallback)(void *, RecordView *, RecordBatch *),
+                                 size_t batchSize);
+
+/**
+ * Select a column by name: only the selected columns are read, and the
+ * others are skipped by the parser without being copied or unescaped.
+ * The header and the records passed to the callbacks hold the selected
+ * columns, in the order they have been selected. Names are resolved
+ * against the header when the parsing starts: if no column of the header
+ * has the given name, the header holds the name and the field is always
+ * empty
+ * @param reader the CsvReader instance
+ * @param name the name of the column, it is copied
+ * @return 0 on success, -1 on error
+ */
+int csv_reader_select_column(CsvReader *reader, const char *name);
+
+/**
+ * Select a column by index (see csv_reader_select_column). If the header
+ * has fewer columns, the name of the column is empty
+ * @param reader the CsvReader instance
+ * @param index the index of the column, starting from 0
+ * @return 0 on success, -1 on error
+ */
+int csv_reader_select_index(CsvReader *reader, size_t index);
+
+/**
+ * Remove all the selected columns, so that all the columns are read
+ * @param reader the CsvReader instance
+ */
+void csv_reader_select_all(CsvReader *reader);
+
+/**
+ * Deliver only the records whose field in the given column is equal to
+ * value. Predicates are checked on the fields as soon as they are read,
+ * before the records are copied: the records which do not satisfy all the
+ * predicates are skipped, and no callback is invoked for them. They are
+ * skipped by the iterators too.
+ * The column does not need to be selected (see csv_reader_select_column);
+ * if the header has no column with the given name, its fields are empty.
+ * The parsings use the predicates until they end, so they cannot be
+ * changed while a parsing is paused (see csv_reader_pause) or input is
+ * being fed (until csv_reader_finish): end it first with csv_reader_stop or
+ * csv_reader_finish. Nor can they be changed from a callback, or while an
+ * iterator of the reader is open
+ * @param reader the CsvReader instance
+ * @param column the name of the column, it is copied
+ * @param value the value, it is copied
+ * @return 0 on success, -1 on error: errno is EBUSY if a parsing is paused
+ *         or input is being fed
+ */
+int csv_reader_filter_equals(CsvReader *reader, const char *column, const char *value);
+
+/**
+ * Deliver only the records whose field in the given column begins with
+ * prefix (see csv_reader_filter_equals)
+ * @param reader the CsvReader instance
+ * @param column the name of the column, it is copied
+ * @param prefix the prefix, it is copied
+ * @return 0 on success, -1 on error (see csv_reader_filter_equals)
+ */
+int csv_reader_filter_prefix(CsvReader *reader, const char *column, const char *prefix);
+
+/**
+ * Deliver only the records whose field in the given column is a number
+ * between min and max, included (see csv_reader_filter_equals)
+ * @param reader the CsvReader instance
+ * @param column the name of the column, it is copied
+ * @param min the lower bound
+ * @param max the upper bound
+ * @return 0 on success, -1 on error (see csv_reader_filter_equals)
+ */
+int csv_reader_filter_range(CsvReader *reader, const char *column, double min, double max);
+
+/**
+ * Deliver only the records whose field in the given column is empty, or
+ * not empty (see csv_reader_filter_equals). A field containing only spaces
+ * is empty
+ * @param reader the CsvReader instance
+ * @param column the name of the column, it is copied
+ * @param empty 1 to keep the records whose field is empty, 0 to keep the
+ *              records whose field is not empty
+ * @return 0 on success, -1 on error (see csv_reader_filter_equals)
+ */
+int csv_reader_filter_empty(CsvReader *reader, const char *column, int empty);
+
+/**
+ * Remove all the predicates, so that all the records are delivered
+ * @param reader the CsvReader instance
+ * @return 0 on success, -1 with errno set to EBUSY if a parsing is paused
+ *         or input is being fed (see csv_reader_filter_equals)
+ */
+int csv_reader_filter_clear(CsvReader *reader);
+
+/**
+ * Intern the values of a column: each distinct value is stored once in the
+ * dictionary of the column, and the fields of the Record delivered to the
+ * callbacks and by csv_iterator_next_record point to it instead of being
+ * copied. Each value has a code, stable across the parsings of the reader,
+ * which is stored in the record (see csv_record_code).
+ * Meant for low cardinality columns: when the column has more than
+ * maxValues distinct values, it is spilled: from then on its values are
+ * no longer looked up, they are copied as usual and have no code, even
+ * the ones stored in the dictionary. RecordView fields are never interned.
+ * Interning forces csv_reader_parse_parallel to parse sequentially
+ * @param reader the CsvReader instance
+ * @param name the name of the column in the header, it is copied
+ * @param maxValues the maximum number of distinct values, 0 for
+ *                  DICTIONARY_SIZE
+ * @return 0 on success, -1 on error: errno is EBUSY if a parsing is paused
+ *         or input is being fed (see csv_reader_filter_equals)
+ */
+int csv_reader_intern_column(CsvReader *reader, const char *name, size_t maxValues);
+
+/**
+ * Get the dictionary of an interned column: values[code] is the value whose
+ * code is code. The dictionary is valid until csv_reader_intern_clear or
+ * csv_reader_free
+ * @param reader the CsvReader instance
+ * @param name the name of the column
+ * @return the dictionary, NULL if the column is not interned
+ */
+const Dictionary *csv_reader_dictionary(const CsvReader *reader, const char *name);
+
+/**
+ * Stop interning the columns and free their dictionaries. The fields of
+ * the records already delivered are no longer valid
+ * @param reader the CsvReader instance
+ * @return 0 on success, -1 with errno set to EBUSY if a parsing is paused
+ *         or input is being fed, whose records point to the dictionaries
+ *         (see csv_reader_filter_equals)
+ */
+int csv_reader_intern_clear(CsvReader *reader);
+
+/**
+ * Index the records of a csv file: the byte offset of one record every
+ * stride records is stored, so that parsing can start from any record
+ * (see csv_reader_seek_record). The offsets are found by the parser, so
+ * quoted fields containing new lines are handled.
+ * The configuration of the reader (selected columns, predicates, starting
+ * record) is ignored: all the records of the file are indexed
+ * @param reader the CsvReader instance
+ * @param path the path of the csv file
+ * @param stride the number of records between two stored offsets
+ * @return the index, to be released with csv_index_free, or NULL on error
+ *         (errno is set accordingly)
+ */
+RecordIndex *csv_index_build(CsvReader *reader, const char *path, size_t stride);
+
+/**
+ * Index the records of a csv file stored in memory (see csv_index_build)
+ * @param reader the CsvReader instance
+ * @param data the content of the csv file
+ * @param len the length of data
+ * @param stride the number of records between two stored offsets
+ * @return the index, to be released with csv_index_free, or NULL on error
+ */
+RecordIndex *csv_index_build_memory(CsvReader *reader, const char *data, size_t len, size_t stride);
+
+/**
+ * Save an index to a sidecar file. Numbers are stored as 64 bit integers
+ * in the byte order of the machine
+ * @param index the index
+ * @param path the path of the index file
+ * @return 0 on success, -1 on error (errno is set accordingly)
+ */
+int csv_index_save(const RecordIndex *index, const char *path);
+
+/**
+ * Load an index saved with csv_index_save
+ * @param path the path of the index file
+ * @return the index, to be released with csv_index_free, or NULL on error
+ *         (errno is set accordingly)
+ */
+RecordIndex *csv_index_load(const char *path);
+
+/**
+ * Free an index
+ * @param index the index
+ */
+void csv_index_free(RecordIndex *index);
+
+/**
+ * Set the index used to reach the starting record (see
+ * csv_reader_seek_record). The index must have been built on the file
+ * which is parsed: the parsing fails with EINVAL if the length of the
+ * input differs from the length of the indexed file (streams which are
+ * not regular files are not checked)
+ * @param reader the CsvReader instance
+ * @param index the index, it must outlive the reader. NULL to remove it
+ */
+void csv_reader_set_index(CsvReader *reader, const RecordIndex *index);
+
+/**
+ * Start parsing from a record, the header excluded: the header is read and
+ * delivered as usual, then the parser jumps to the record. With an index
+ * (see csv_reader_set_index) the parser moves to the nearest indexed
+ * offset and skips the records which follow it, without an index it skips
+ * all the records which precede the starting one. Skipped records are not
+ * parsed, their ends are found as by csv_count_records.
+ * Streams are repositioned with fseek or lseek; if they do not support it,
+ * the records are skipped. Input pushed with csv_reader_feed is always
+ * read from its beginning.
+ * If the record cannot be reached no record is delivered
+ * @param reader the CsvReader instance
+ * @param record the index of the first record to read, starting from 0.
+ *               0 to read the file from the beginning
+ * @return 0 on success, -1 if the record is past the end of the indexed
+ *         file (errno is set to ERANGE)
+ */
+int csv_reader_seek_record(CsvReader *reader, size_t record);
+
+/**
+ * Count the records of a csv file, the header excluded, without parsing
+ * them: only the line endings and the quotes are looked for, 64 bytes at a
+ * time, so the count runs much faster than a parsing. The dialect of the
+ * reader is used, the rest of its configuration is ignored. The count is
+ * the same as the number of records delivered by the parser, unless quotes
+ * follow the closing quote of a field. If the reader uses a cache (see
+ * csv_reader_set_cache), the count is read from the cache
+ * @param reader the CsvReader instance
+ * @param path the path of the csv file
+ * @param count output, the number of records
+ * @return 0 on success, -1 on error (errno is set accordingly)
+ */
+int csv_count_records(CsvReader *reader, const char *path, size_t *count);
+
+/**
+ * Count the records of a csv file stored in memory (see csv_count_records)
+ * @param reader the CsvReader instance
+ * @param data the content of the csv file
+ * @param len the length of data
+ * @param count output, the number of records
+ * @return 0 on success
+ */
+int csv_count_records_memory(CsvReader *reader, const char *data, size_t len, size_t *count);
+
+/**
+ * Get the statistics collected while parsing with the reader, accumulated
+ * since it has been allocated or since the last call to
+ * csv_reader_stats_reset. The statistics of a parsing are added when it
+ * ends (for iterators, when they are closed).
+ * Statistics are collected only if the library is compiled with CSV_STATS
+ * defined (the C_CSV_STATS CMake option), otherwise they are all 0
+ * @param reader the CsvReader instance
+ * @param stats output, the statistics
+ */
+void csv_reader_stats(const CsvReader *reader, CsvStats *stats);
+
+/**
+ * Reset the statistics of a reader
+ * @param reader the CsvReader instance
+ */
+void csv_reader_stats_reset(CsvReader *reader);
+
+/**
+ * Measure the time spent parsing and in the callbacks. The clock is read
+ * before and after each callback, so timing is disabled by default
+ * @param reader the CsvReader instance
+ * @param enabled 1 to measure times, 0 otherwise
+ */
+void csv_reader_stats_timing(CsvReader *reader, int enabled);
+
 /**
  * Reads a csv file
+ * The file is read in blocks (see csv_reader_set_block_size)
  * @param reader the CsvReader instance
  * @param csvFile a FILE * pointer opened with mode 'r' pointing to the csv file
+ * @return CSV_END if the whole file has been read, CSV_STOPPED or
+ *         CSV_PAUSED if a callback has stopped or paused the parsing (see
+ *         csv_reader_stop), -1 if a starting record is set and the index
+ *         was not built on the file (errno is set to EINVAL, see
+ *         csv_reader_set_index)
+ */
+int csv_reader_parse(CsvReader *reader, FILE *csvFile);
+
+/**
+ * Reads a csv file from a file descriptor, such as a pipe, a socket or stdin.
+ * The file is read in blocks with read(2), bypassing stdio.
+ * Only available on POSIX systems
+ * @param reader the CsvReader instance
+ * @param fd a file descriptor opened for reading
+ * @return CSV_END, CSV_STOPPED, CSV_PAUSED or -1 (see csv_reader_parse)
+ */
+int csv_reader_parse_fd(CsvReader *reader, int fd);
+
+/**
+ * Reads a csv file stored in memory.
+ * Fields are read directly from data, which is never copied: only quoted
+ * fields containing escaped double quotes are
+ * @param reader the CsvReader instance
+ * @param data the content of the csv file, it is not modified
+ * @param len the length of data
+ * @return CSV_END, CSV_STOPPED, CSV_PAUSED or -1 (see csv_reader_parse)
+ */
+int csv_reader_parse_memory(CsvReader *reader, const char *data, size_t len);
+
+/**
+ * Reads a csv file mapping it in memory (see csv_reader_parse_memory),
+ * or from its cache (see csv_reader_set_cache).
+ * On systems without mmap the file is read with csv_reader_parse.
+ * A paused parsing keeps the file open until it ends
+ * @param reader the CsvReader instance
+ * @param path the path of the csv file
+ * @return CSV_END, CSV_STOPPED or CSV_PAUSED (see csv_reader_parse), -1
+ *         if the file cannot be opened or mapped, or if the index does not
+ *         match it (errno is set accordingly)
+ */
+int csv_reader_parse_path(CsvReader *reader, const char *path);
+
+/**
+ * Stop the parsing. To be invoked from a callback: no record is parsed after
+ * it returns, the records already delivered which are waiting in a batch are
+ * flushed, and the parsing function returns CSV_STOPPED. Input fed after
+ * the stop is ignored until csv_reader_finish.
+ * If the reader is paused, the paused parsing is ended instead.
+ * The position where the parsing stopped is given by csv_reader_offset.
+ * Not supported while parsing in parallel
+ * @param reader the CsvReader instance
+ */
+void csv_reader_stop(CsvReader *reader);
+
+/**
+ * Skip the current record. To be invoked from a callback: the record is
+ * not delivered to the callbacks which follow it (a Record is not built
+ * for the record callback, and the record is not added to the batches).
+ * Callbacks are invoked in this order: recordView, record, batch,
+ * recordBatch. Not supported while parsing in parallel
+ * @param reader the CsvReader instance
+ */
+void csv_reader_skip_record(CsvReader *reader);
+
+/**
+ * Pause the parsing. To be invoked from a callback: once the current
+ * record has been delivered to all the callbacks, the parsing function
+ * returns CSV_PAUSED, and the parsing can be continued with
+ * csv_reader_resume. The input must stay valid until the parsing ends:
+ * the FILE *, the file descriptor or the memory it is read from.
+ * Starting another parsing, or stopping the reader, ends the paused one.
+ * When the input is fed, csv_reader_feed returns CSV_PAUSED and the rest of
+ * the data is parsed by the next call to csv_reader_feed, csv_reader_resume
+ * or csv_reader_finish. Not supported while parsing in parallel
+ * @param reader the CsvReader instance
+ */
+void csv_reader_pause(CsvReader *reader);
+
+/**
+ * Continue a paused parsing
+ * @param reader the CsvReader instance
+ * @return CSV_END, CSV_STOPPED or CSV_PAUSED (see csv_reader_parse).
+ *         CSV_END if no parsing is paused
+ */
+int csv_reader_resume(CsvReader *reader);
+
+/**
+ * Get the position where the last parsing ended, was stopped or paused
+ * @param reader the CsvReader instance
+ * @return the offset in the input of the first byte after the last record
+ *         parsed
+ */
+size_t csv_reader_offset(const CsvReader *reader);
+
+/**
+ * Reads a csv file stored in memory using several threads.
+ * The input is split in chunks which are parsed concurrently; the beginning
+ * of the first record of each chunk is found by counting the double quotes
+ * which precede it, so new lines inside quoted fields are handled.
+ * The header is read first, and the header callback is invoked on the
+ * calling thread.
+ * The boundaries are found correctly only in well formed files: a double
+ * quote following the closing double quote of a field (which the parser
+ * discards) can make a worker start in the middle of a record.
+ * Record callbacks are invoked on the worker threads:
+ *  - if ordered is 0, records are delivered as soon as they are parsed, in
+ *    no particular order, and the callbacks are invoked concurrently;
+ *  - if ordered is 1, records are delivered in file order and the callbacks
+ *    are never invoked concurrently. Each worker keeps the positions of the
+ *    fields of one chunk in memory until it is its turn to deliver them.
+ * @param reader the CsvReader instance
+ * @param data the content of the csv file, it is not modified
+ * @param len the length of data
+ * @param threads the number of worker threads. If less than 2 the file is
+ *                read with csv_reader_parse_memory
+ * @param ordered 1 to receive the records in file order, 0 otherwise
+ */
+void csv_reader_parse_memory_parallel(CsvReader *reader, const char *data, size_t len, int threads, int ordered);
+
+/**
+ * Reads a csv file using several threads, mapping it in memory
+ * (see csv_reader_parse_memory_parallel).
+ * On systems without mmap the file is read with csv_reader_parse_path
+ * @param reader the CsvReader instance
+ * @param path the path of the csv file
+ * @param threads the number of worker threads
+ * @param ordered 1 to receive the records in file order, 0 otherwise
+ * @return 0 on success, -1 if the file cannot be opened or mapped
+ *         (errno is set accordingly)
+ */
+int csv_reader_parse_parallel(CsvReader *reader, const char *path, int threads, int ordered);
+
+/**
+ * Push a piece of a csv file to the parser.
+ * The input can be split anywhere, even inside a quoted field or between
+ * a carriage return and a new line: the callbacks are invoked for each
+ * record completed by data, and the incomplete record at its end is kept
+ * until the next call. data is copied, it can be released as soon as
+ * the function returns
+ * @param reader the CsvReader instance
+ * @param data the next bytes of the csv file
+ * @param len the length of data
+ * @return CSV_END once the data has been parsed, CSV_STOPPED or CSV_PAUSED
+ *         if a callback has stopped or paused the parsing
+ */
+int csv_reader_feed(CsvReader *reader, const char *data, size_t len);
+
+/**
+ * Signal the end of the input pushed with csv_reader_feed: the last
+ * record is parsed even if it is not followed by a new line, and the state
+ * of the parser is released, so that a new file can be fed.
+ * If a callback pauses the parsing, the state is kept: csv_reader_finish
+ * must be invoked again
+ * @param reader the CsvReader instance
+ * @return CSV_END, CSV_STOPPED or CSV_PAUSED
+ */
+int csv_reader_finish(CsvReader *reader);
+
+/**
+ * A pull parser, which returns one record at a time instead of invoking
+ * the callbacks of the reader (see csv_iterator_next)
+ */
+typedef struct CsvIterator_s CsvIterator;
+
+/**
+ * Open an iterator on a csv file.
+ * The reader provides the configuration (allocator, block size), its
+ * callbacks are never invoked. The reader must outlive the iterator
+ * @param reader the CsvReader instance
+ * @param csvFile a FILE * pointer opened with mode 'r' pointing to the csv file
+ * @return the iterator, or NULL on error
+ */
+CsvIterator *csv_iterator_open(CsvReader *reader, FILE *csvFile);
+
+/**
+ * Open an iterator on a file descriptor (see csv_reader_parse_fd)
+ * @param reader the CsvReader instance
+ * @param fd a file descriptor opened for reading
+ * @return the iterator, or NULL on error
+ */
+CsvIterator *csv_iterator_open_fd(CsvReader *reader, int fd);
+
+/**
+ * Open an iterator on a csv file stored in memory
+ * @param reader the CsvReader instance
+ * @param data the content of the csv file, it must outlive the iterator
+ * @param len the length of data
+ * @return the iterator, or NULL on error
+ */
+CsvIterator *csv_iterator_open_memory(CsvReader *reader, const char *data, size_t len);
+
+/**
+ * Open an iterator on a csv file, mapping it in memory, or on its cache
+ * (see csv_reader_set_cache). The mapping is released by
+ * csv_iterator_close
+ * @param reader the CsvReader instance
+ * @param path the path of the csv file
+ * @return the iterator, or NULL on error (errno is set accordingly)
+ */
+CsvIterator *csv_iterator_open_path(CsvReader *reader, const char *path);
+
+/**
+ * Read the next record. The first record of the file is the header, and it
+ * is never returned as a record
+ * @param iterator the iterator
+ * @param header if not NULL, it is set to the header; its views are valid
+ *               until the iterator is closed
+ * @param record if not NULL, it is set to the record; its views are valid
+ *               until the next call on the iterator
+ * @return 1 if a record has been read, 0 at the end of the file
+ */
+int csv_iterator_next(CsvIterator *iterator, RecordView **header, RecordView **record);
+
+/**
+ * Same as csv_iterator_next, but the fields of the record are copied in a
+ * Record, which is valid until the next call on the iterator
+ * @param iterator the iterator
+ * @param header if not NULL, it is set to the header
+ * @param record if not NULL, it is set to the record
+ * @return 1 if a record has been read, 0 at the end of the file
+ */
+int csv_iterator_next_record(CsvIterator *iterator, Record **header, Record **record);
+
+/**
+ * Read the header, if it has not been read yet
+ * @param iterator the iterator
+ * @return the header, or NULL if the file is empty
+ */
+RecordView *csv_iterator_header(CsvIterator *iterator);
+
+/**
+ * Move an iterator to a record, the header excluded: the next call to
+ * csv_iterator_next returns it. The index of the reader is used if set
+ * (see csv_reader_seek_record); iterators on memory and on seekable
+ * streams can move backwards
+ * @param iterator the iterator
+ * @param record the index of the record, starting from 0
+ * @return 0 on success, -1 on error (errno is set accordingly, EINVAL if
+ *         the index was not built on the input of the iterator)
+ */
+int csv_iterator_seek_record(CsvIterator *iterator, size_t record);
+
+/**
+ * Skip the next records of an iterator without parsing them, as
+ * csv_count_records does. The header is read first if needed. Skipped
+ * records are not checked against the predicates
+ * @param iterator the iterator
+ * @param count the number of records to skip
+ * @return the number of records skipped, fewer than count at the end of
+ *         the file
+ */
+size_t csv_iterator_skip_records(CsvIterator *iterator, size_t count);
+
+/**
+ * Close an iterator
+ * @param iterator the iterator
+ */
+void csv_iterator_close(CsvIterator *iterator);
+
+/**
+ * Infer the schema of a csv file from a sample of its records: each column
+ * is classified as int, float or text, and its nullability and the widths
+ * of its fields are recorded (see Schema). The classification does not
+ * depend on the locale.
+ * The sampled records are consumed from the iterator
+ * @param iterator the iterator
+ * @param samples maximum number of records to sample, 0 to sample the
+ *                whole file
+ * @param stride sample one record every stride records, 0 or 1 to sample
+ *               consecutive records
+ * @return the schema, to be released with schema_free, or NULL if the file
+ *         is empty or on error
+ */
+Schema *csv_iterator_infer_schema(CsvIterator *iterator, size_t samples, size_t stride);
+
+/**
+ * Infer the schema of a csv file (see csv_iterator_infer_schema)
+ * @param reader the CsvReader instance
+ * @param path the path of the csv file
+ * @param samples maximum number of records to sample, 0 to sample the
+ *                whole file
+ * @param stride sample one record every stride records
+ * @return the schema, to be released with schema_free, or NULL if the file
+ *         is empty or on error (errno is set accordingly)
+ */
+Schema *csv_reader_infer_schema(CsvReader *reader, const char *path, size_t samples, size_t stride);
+
+/**
+ * Find the column of a field by its name in the header.
+ * The records delivered by a reader, and its header, carry a hash table of
+ * the names of the header, built once when the header is read: a lookup
+ * hashes the name and compares it with a single column in the common case,
+ * instead of scanning the header. If columns are selected, the index is
+ * the position of the column among the selected ones.
+ * In hot loops, the index can be found once (e.g. in the header callback)
+ * and the fields read with csv_record_field
+ * @param record a record or the header delivered by a reader
+ * @param name the name of the column
+ * @return the index of the column, CSV_NO_COLUMN if the header does not
+ *         contain name or if the record has not been delivered by a reader
+ */
+size_t csv_record_column(const Record *record, const char *name);
+
+/**
+ * Find the column of a field by its name in the header (see
+ * csv_record_column)
+ * @param record a record view or the header view delivered by a reader
+ * @param name the name of the column
+ * @return the index of the column, CSV_NO_COLUMN if the header does not
+ *         contain name or if the record has not been delivered by a reader
+ */
+size_t csv_record_view_column(const RecordView *record, const char *name);
+
+/**
+ * Get a field by the name of its column (see csv_record_column), e.g.
+ *      const char *rpm = csv_record_get(record, "EngineRPM");
+ * @param record a record delivered by a reader
+ * @param name the name of the column
+ * @return the field, NULL if the header does not contain name or if the
+ *         record has fewer fields
+ */
+const char *csv_record_get(const Record *record, const char *name);
+
+/**
+ * Get a field by the name of its column (see csv_record_column)
+ * @param record a record view delivered by a reader
+ * @param name the name of the column
+ * @return the field, NULL if the header does not contain name or if the
+ *         record has fewer fields
+ */
+const FieldView *csv_record_view_get(const RecordView *record, const char *name);
+
+/**
+ * Get a field by the index of its column, found with csv_record_column
+ * @param record the record
+ * @param column the index of the column
+ * @return the field, NULL if column is CSV_NO_COLUMN or if the record has
+ *         fewer fields
+ */
+const char *csv_record_field(const Record *record, size_t column);
+
+/**
+ * Get a field by the index of its column, found with
+ * csv_record_view_column
+ * @param record the record view
+ * @param column the index of the column
+ * @return the field, NULL if column is CSV_NO_COLUMN or if the record has
+ *         fewer fields
+ */
+const FieldView *csv_record_view_field(const RecordView *record, size_t column);
+
+/**
+ * Get the code of a field in the dictionary of its column (see
+ * csv_reader_intern_column)
+ * @param record the record
+ * @param column the index of the column
+ * @return the code, CSV_NO_CODE if the field is not interned or if the
+ *         record has fewer fields
+ */
+uint32_t csv_record_code(const Record *record, size_t column);
+
+/**
+ * A buffered writer, which writes records in the syntax of a dialect
+ * (see csv_writer_open)
+ */
+typedef struct CsvWriter_s CsvWriter;
+
+/**
+ * Open a writer on a FILE *. The output is buffered by the writer, then
+ * written with fwrite
+ * @param csvFile a FILE * opened for writing, it must outlive the writer
+ * @return the writer, or NULL on error
+ */
+CsvWriter *csv_writer_open(FILE *csvFile);
+
+/**
+ * Open a writer on a file descriptor. The output is buffered by the
+ * writer, then written with write, or with writev along with the fields
+ * larger than the buffer
+ * @param fd a file descriptor opened for writing
+ * @return the writer, or NULL on error
+ */
+CsvWriter *csv_writer_open_fd(int fd);
+
+/**
+ * Create (or truncate) a file and open a writer on it. The file is closed
+ * by csv_writer_close
+ * @param path the path of the file
+ * @return the writer, or NULL on error (errno is set accordingly)
+ */
+CsvWriter *csv_writer_open_path(const char *path);
+
+/**
+ * Set the syntax of the output, CSV by default (see Dialect). Records are
+ * terminated by "\r" if the line ending of the dialect is DIALECT_LINE_CR,
+ * by "\n" otherwise
+ * @param writer the writer
+ * @param dialect the dialect, it is copied
+ * @return 0 on success, -1 if the dialect is not valid (errno is set to
+ *         EINVAL)
+ */
+int csv_writer_set_dialect(CsvWriter *writer, const Dialect *dialect);
+
+/**
+ * Append a field to the current record. The field is quoted only if it
+ * contains a delimiter, a quote, a line ending or an escape character (or
+ * if it begins or ends with a blank and the dialect trims the fields).
+ * If the dialect has no quote, those characters are escaped instead.
+ * A field which the dialect cannot represent (it needs quotes and the
+ * dialect has neither a quote nor an escape, or it contains a quote and
+ * the dialect has no escape) is not written and the writer fails with
+ * EINVAL, as the record could not be read back
+ * @param writer the writer
+ * @param field the field, it may not be null terminated
+ * @param len length of the field
+ * @return 0 on success, -1 if a write failed or the field cannot be
+ *         represented (errno is set accordingly). Once a call fails, all
+ *         the following calls fail
+ */
+int csv_writer_field(CsvWriter *writer, const char *field, size_t len);
+
+/**
+ * Append an integer field to the current record, formatted without printf
+ * @param writer the writer
+ * @param value the value
+ * @return 0 on success, -1 if a write failed (errno is set accordingly)
+ */
+int csv_writer_field_int64(CsvWriter *writer, int64_t value);
+
+/**
+ * Append a real field to the current record (see double_to_string)
+ * @param writer the writer
+ * @param value the value
+ * @param decimals number of digits after the decimal point, or
+ *                 DOUBLE_SHORTEST for the shortest representation which
+ *                 reads back as the same value
+ * @return 0 on success, -1 if a write failed (errno is set accordingly)
+ */
+int csv_writer_field_double(CsvWriter *writer, double value, int decimals);
+
+/**
+ * Terminate the current record
+ * @param writer the writer
+ * @return 0 on success, -1 if a write failed (errno is set accordingly)
+ */
+int csv_writer_end_record(CsvWriter *writer);
+
+/**
+ * Write a whole record
+ * @param writer the writer
+ * @param record the record
+ * @return 0 on success, -1 if a write failed (errno is set accordingly)
+ */
+int csv_writer_write_record(CsvWriter *writer, const Record *record);
+
+/**
+ * Write a whole record from its views, e.g. the record received by a view
+ * callback of a reader
+ * @param writer the writer
+ * @param record the record
+ * @return 0 on success, -1 if a write failed (errno is set accordingly)
+ */
+int csv_writer_write_view(CsvWriter *writer, const RecordView *record);
+
+/**
+ * Write the buffered data to the output
+ * @param writer the writer
+ * @return 0 on success, -1 if a write failed (errno is set accordingly)
+ */
+int csv_writer_flush(CsvWriter *writer);
+
+/**
+ * Flush and destroy a writer, closing the file opened by
+ * csv_writer_open_path
+ * @param writer the writer
+ * @return 0 on success, -1 if a write failed (errno is set accordingly)
  */
-void csv_reader_parse(CsvReader *reader, FILE *csvFile);
+int csv_writer_close(CsvWriter *writer);
 
 /**
  * Destroy a CsvReader Instance
@@ -5,10 +5,16 @@
 #ifndef C_CSV__UTILS_H
 #define C_CSV__UTILS_H
 
+#define STRING_TYPE_EMPTY 0
 #define STRING_TYPE_INT 1
 #define STRING_TYPE_FLOAT 2
 #define STRING_TYPE_TEXT 3
 
+#define NUMBER_STRING_LENGTH 352
+#define DOUBLE_SHORTEST (-1)
+#define DOUBLE_MAX_DECIMALS 17
+
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
@@ -24,8 +30,82 @@ char *string_duplicate(const char *string, size_t len);
 
 /**
  * Return the type stored in the string
- * @return TYPE_TEXT, TYPE_FLOAT or TYPE_INT accordingly to the data of the string
+ * @return TYPE_TEXT, TYPE_FLOAT or TYPE_INT accordingly to the data of the string,
+ *         TYPE_EMPTY if the string is empty or contains only spaces
  */
 char string_type(const char *str);
 
+/**
+ * Return the type stored in a string which may not be null terminated.
+ * The classification does not depend on the locale: spaces are ' ', '\t',
+ * '\n', '\v', '\f' and '\r', an int is an optional sign followed by
+ * decimal digits, a float may also have a decimal point and an exponent.
+ * Surrounding spaces are ignored. Digits are checked 8 at a time
+ * @param str the string
+ * @param len length of the string
+ * @return TYPE_TEXT, TYPE_FLOAT, TYPE_INT or TYPE_EMPTY
+ */
+char string_type_len(const char *str, size_t len);
+
+/**
+ * Convert a string which may not be null terminated to an integer, without
+ * copying it and independently of the locale. The string is accepted iff
+ * string_type_len classifies it as STRING_TYPE_INT. Digits are converted 8
+ * at a time
+ * @param str the string
+ * @param len length of the string
+ * @param value output, the value
+ * @return 0 on success, -1 with errno set to ERANGE if the value is out of
+ *         range or to EINVAL if the string is not an int
+ */
+int string_to_int64(const char *str, size_t len, int64_t *value);
+
+/**
+ * Convert a string which may not be null terminated to the nearest double,
+ * without copying it. The string is accepted iff string_type_len classifies
+ * it as STRING_TYPE_INT or STRING_TYPE_FLOAT. Mantissas of up to 19
+ * significant digits are converted with the Eisel-Lemire algorithm, longer
+ * ones (and the rare values it cannot round) with strtod, which depends on
+ * the decimal point of the locale
+ * @param str the string
+ * @param len length of the string
+ * @param value output, the value
+ * @return 0 on success, -1 with errno set to ERANGE if the value overflows
+ *         or underflows to zero, or to EINVAL if the string is not a number
+ */
+int string_to_double(const char *str, size_t len, double *value);
+
+/**
+ * Convert an integer to a string, without printf
+ * @param value the value
+ * @param str output, at least NUMBER_STRING_LENGTH bytes. It is null
+ *            terminated
+ * @return the length of the string
+ */
+size_t int64_to_string(int64_t value, char *str);
+
+/**
+ * Convert a double to a string. The digits are computed without printf
+ * when the value, scaled by 10^decimals, is smaller than 2^53: the value
+ * is then rounded after the multiplication, so halfway cases may differ
+ * from printf in the last digit
+ * @param value the value
+ * @param decimals number of digits after the decimal point (at most
+ *                 DOUBLE_MAX_DECIMALS), or DOUBLE_SHORTEST for the
+ *                 shortest string which reads back as the same value
+ * @param str output, at least NUMBER_STRING_LENGTH bytes. It is null
+ *            terminated
+ * @return the length of the string
+ */
+size_t double_to_string(double value, int decimals, char *str);
+
+/**
+ * Hash a string which may not be null terminated (FNV-1a)
+ * @param str the string
+ * @param len length of the string
+ * @param seed the seed, different seeds give unrelated hashes
+ * @return the hash
+ */
+uint64_t string_hash(const char *str, size_t len, uint64_t seed);
+
 #endif //C_CSV__UTILS_H
@@ -0,0 +1,149 @@
+//
+// Created by Davide on 16/10/2026.
+//
+
+#include <stdint.h>
+#include <string.h>
+
+#include "arena.h"
+
+#define ARENA_ALIGNMENT 16
+
+ArenaChunk *arena_chunk_alloc(Arena *arena, ArenaChunk *last, size_t size);
+void *arena_get(Arena *arena, size_t size, size_t alignment);
+
+void *allocator_malloc(const Allocator *allocator, size_t size)
+{
+        if (allocator == NULL)
+                return malloc(size);
+        return allocator->alloc(allocator->context, size);
+}
+
+void allocator_free(const Allocator *allocator, void *ptr)
+{
+        if (allocator == NULL)
+                free(ptr);
+        else if (ptr != NULL)
+                allocator->free(allocator->context, ptr);
+}
+
+void *allocator_realloc(const Allocator *allocator, void *ptr, size_t oldSize, size_t newSize)
+{
+        void *result;
+
+        if (allocator == NULL)
+                return realloc(ptr, newSize);
+
+        result = allocator->alloc(allocator->context, newSize);
+        if (result == NULL)
+                return NULL;
+
+        if (ptr != NULL) {
+                memcpy(result, ptr, oldSize < newSize ? oldSize : newSize);
+                allocator->free(allocator->context, ptr);
+        }
+        return result;
+}
+
+Arena *arena_alloc(size_t size, const Allocator *allocator)
+{
+        Arena *result = allocator_malloc(allocator, sizeof(Arena));
+
+        if (result == NULL)
+                return NULL;
+
+        result->allocator = allocator;
+        result->chunkSize = size < ARENA_ALIGNMENT ? ARENA_ALIGNMENT : size;
+        result->allocated = 0;
+        result->first = arena_chunk_alloc(result, NULL, result->chunkSize);
+        result->chunk = result->first;
+
+        if (result->first == NULL) {
+                allocator_free(allocator, result);
+                return NULL;
+        }
+
+        return result;
+}
+
+void arena_free(Arena *arena)
+{
+        ArenaChunk *next;
+
+        while (arena->first != NULL) {
+                next = arena->first->next;
+                allocator_free(arena->allocator, arena->first);
+                arena->first = next;
+        }
+
+        allocator_free(arena->allocator, arena);
+}
+
+void arena_reset(Arena *arena)
+{
+        // The following chunks are emptied when arena_get reaches them
+        arena->chunk = arena->first;
+        arena->chunk->used = 0;
+}
+
+inline void *arena_malloc(Arena *arena, size_t size)
+{
+        return arena_get(arena, size, ARENA_ALIGNMENT);
+}
+
+char *arena_strdup(Arena *arena, const char *string, size_t len)
+{
+        char *duplicate = arena_get(arena, len + 1, 1);
+        if (duplicate == NULL)
+                return NULL;
+        memcpy(duplicate, string, len);
+        duplicate[len] = 0;
+        return duplicate;
+}
+
+void *arena_get(Arena *arena, size_t size, size_t alignment)
+{
+        ArenaChunk *chunk = arena->chunk;
+        size_t padding = (size_t) -(uintptr_t) (chunk->data + chunk->used) & (alignment - 1);
+        char *result;
+
+        if (chunk->used + padding + size > chunk->size) {
+                // Move to the next chunk large enough, reusing the chunks
+                // kept by arena_reset before allocating a new one
+                do {
+                        if (chunk->next == NULL) {
+                                while (arena->chunkSize < size + alignment)
+                                        arena->chunkSize *= 2;
+
+                                if (arena_chunk_alloc(arena, chunk, arena->chunkSize) == NULL)
+                                        return NULL;
+                                arena->chunkSize *= 2;
+                        }
+                        chunk = chunk->next;
+                        chunk->used = 0;
+                } while (chunk->size < size + alignment);
+
+                arena->chunk = chunk;
+                padding = (size_t) -(uintptr_t) chunk->data & (alignment - 1);
+        }
+
+        result = chunk->data + chunk->used + padding;
+        chunk->used += padding + size;
+        return result;
+}
+
+ArenaChunk *arena_chunk_alloc(Arena *arena, ArenaChunk *last, size_t size)
+{
+        ArenaChunk *chunk = allocator_malloc(arena->allocator, sizeof(ArenaChunk) + size);
+
+        if (chunk == NULL)
+                return NULL;
+
+        chunk->next = NULL;
+        chunk->size = size;
+        chunk->used = 0;
+        if (last != NULL)
+                last->next = chunk;
+        arena->allocated += size;
+        return chunk;
+}
@@ -0,0 +1,111 @@
+//
+// Created by Davide on 16/10/2026.
+//
+
+#ifndef C_CSV__ARENA_H
+#define C_CSV__ARENA_H
+
+#include <stdlib.h>
+
+/**
+ * A pluggable allocator: alloc and free are invoked with context as first
+ * argument, and they must behave like malloc and free
+ */
+typedef struct Allocator_s {
+        void *(*alloc)(void *context, size_t size);
+        void (*free)(void *context, void *ptr);
+        void *context;
+} Allocator;
+
+/**
+ * A block of memory owned by an arena
+ */
+typedef struct ArenaChunk_s {
+        struct ArenaChunk_s *next;
+        size_t size;
+        size_t used;
+        char data[];
+} ArenaChunk;
+
+/**
+ * A bump allocator: memory is taken sequentially from chunks and it is never
+ * released one block at a time. arena_reset releases everything in O(1).
+ * first is the head of the list of chunks, in allocation order, chunk the
+ * chunk currently in use, chunkSize the size of the next chunk to allocate,
+ * allocated the sum of the sizes of all the chunks
+ */
+typedef struct Arena_s {
+        ArenaChunk *first;
+        ArenaChunk *chunk;
+        size_t chunkSize;
+        size_t allocated;
+        const Allocator *allocator;
+} Arena;
+
+/**
+ * Allocate memory with an allocator
+ * @param allocator the allocator, if NULL malloc is used
+ * @param size number of bytes
+ * @return the memory, or NULL on error
+ */
+void *allocator_malloc(const Allocator *allocator, size_t size);
+
+/**
+ * Release memory allocated with an allocator
+ * @param allocator the allocator, if NULL free is used
+ * @param ptr the memory
+ */
+void allocator_free(const Allocator *allocator, void *ptr);
+
+/**
+ * Resize memory allocated with an allocator. If the allocator is not NULL
+ * the memory is moved in a new block
+ * @param allocator the allocator, if NULL realloc is used
+ * @param ptr the memory
+ * @param oldSize the current size of the block
+ * @param newSize the new size of the block
+ * @return the memory, or NULL on error (ptr is left untouched)
+ */
+void *allocator_realloc(const Allocator *allocator, void *ptr, size_t oldSize, size_t newSize);
+
+/**
+ * Create an arena
+ * @param size size of the first chunk
+ * @param allocator allocator used for the chunks, if NULL malloc is used.
+ *                  It must outlive the arena
+ * @return the arena, or NULL on error
+ */
+Arena *arena_alloc(size_t size, const Allocator *allocator);
+
+/**
+ * Destroy an arena and all the memory taken from it
+ * @param arena the arena
+ */
+void arena_free(Arena *arena);
+
+/**
+ * Release all the memory taken from the arena, in O(1).
+ * The chunks are kept and filled again in order, so that in steady state
+ * the arena does not allocate
+ * @param arena the arena
+ */
+void arena_reset(Arena *arena);
+
+/**
+ * Take size bytes from the arena, aligned for any type
+ * @param arena the arena
+ * @param size number of bytes
+ * @return the memory, or NULL on error
+ */
+void *arena_malloc(Arena *arena, size_t size);
+
+/**
+ * Create a null terminated copy of a string in the arena
+ * @param arena the arena
+ * @param string the string, it may not be null terminated
+ * @param len length of the string
+ * @return a copy of the string, or NULL on error
+ */
+char *arena_strdup(Arena *arena, const char *string, size_t len);
+
+#endif //C_CSV__ARENA_H
@@ -0,0 +1,424 @@
+//
+// Created by Davide on 16/10/2026.
+//
+
+#include <errno.h>
+#include <utils.h>
+#include "batch.h"
+
+#define RECORD_BATCH_FIELDS 8
+#define RECORD_BATCH_FIELD_BYTES 8
+#define RECORD_BATCH_GAP 3
+
+// Private prototypes
+
+/**
+ * Allocate the buffers of a column
+ * @param column the column, its type must be set
+ * @param capacity the maximum number of rows
+ * @param width expected width of the string values
+ * @param allocator the allocator
+ * @return 0 on success, -1 on error
+ */
+int column_init(Column *column, size_t capacity, size_t width, const Allocator *allocator);
+
+/**
+ * Release the buffers of a column
+ * @param column the column
+ * @param allocator the allocator
+ */
+void column_destroy(Column *column, const Allocator *allocator);
+
+/**
+ * Store a field in a column
+ * @param column the column
+ * @param row the index of the row
+ * @param field the field, NULL if it is missing
+ * @return 0 on success, -1 on error
+ */
+int column_append(Column *column, size_t row, const FieldView *field);
+
+/**
+ * Store a value of a typed column in a column of the same type
+ * @param column the column
+ * @param row the index of the row
+ * @param typed the typed column
+ * @param index the index of the value in the typed column
+ */
+void column_append_typed(Column *column, size_t row, const TypedColumn *typed, size_t index);
+
+/**
+ * Make sure that size more bytes can be stored in the data of a row major
+ * batch. If the data is moved, the fields are pointed to the new block
+ * @param batch the batch
+ * @param size number of bytes
+ * @return 0 on success, -1 on error
+ */
+int record_batch_reserve(RecordBatch *batch, size_t size);
+
+/**
+ * Check if the fields of a record follow each other in the same block, as
+ * when they are read from the input: only separators, quotes or blanks
+ * can be between them, so they can be copied at once
+ * @param record the record
+ * @param size output, the sum of the lengths of the fields
+ * @return the number of bytes from the first to the end of the last field,
+ *         0 if the fields must be copied one at a time
+ */
+size_t record_batch_span(const RecordView *record, size_t *size);
+
+// Public Implementation
+
+Batch *batch_alloc(const Schema *schema, size_t capacity, const Allocator *allocator)
+{
+        Batch *result = allocator_malloc(allocator, sizeof(Batch));
+        size_t i;
+
+        if (result == NULL)
+                return NULL;
+
+        if (capacity == 0)
+                capacity = 1;
+
+        result->columns = allocator_malloc(allocator, sizeof(Column) * (schema->columnCount + 1));
+        result->columnCount = 0;
+        result->length = 0;
+        result->capacity = capacity;
+        result->allocator = allocator;
+
+        if (result->columns == NULL) {
+                batch_free(result);
+                return NULL;
+        }
+
+        for (i = 0; i < schema->columnCount; i++, result->columnCount++) {
+                result->columns[i].type = schema->columns[i].type;
+                if (column_init(&result->columns[i], capacity, schema->columns[i].maxWidth, allocator) < 0) {
+                        batch_free(result);
+                        return NULL;
+                }
+        }
+
+        return result;
+}
+
+int batch_append(Batch *batch, const RecordView *record)
+{
+        return batch_append_typed(batch, record, NULL, 0, 0);
+}
+
+int batch_append_typed(Batch *batch, const RecordView *record, const TypedColumn *const *typed,
+                       size_t typedCount, size_t row)
+{
+        Column *column;
+        size_t i;
+
+        if (batch->length >= batch->capacity) {
+                errno = ENOBUFS;
+                return -1;
+        }
+
+        for (i = 0; i < batch->columnCount; i++) {
+                column = &batch->columns[i];
+
+                // Only the numeric columns are converted in advance
+                if (i < typedCount && typed[i] != NULL && typed[i]->type == column->type &&
+                    (column->type == STRING_TYPE_INT || column->type == STRING_TYPE_FLOAT))
+                        column_append_typed(column, batch->length, typed[i], row);
+                else if (column_append(column, batch->length, i < record->arraySize ? &record->fields[i] : NULL) < 0)
+                        return -1;
+        }
+
+        batch->length += 1;
+        return 0;
+}
+
+void batch_reset(Batch *batch)
+{
+        Column *column;
+        size_t i;
+
+        for (i = 0; i < batch->columnCount; i++) {
+                column = &batch->columns[i];
+                memset(column->validity, 0, (batch->length + 7) / 8);
+                column->nullCount = 0;
+                if (column->data != NULL)
+                        buffer_reset(column->data);
+        }
+
+        batch->length = 0;
+}
+
+void batch_free(Batch *batch)
+{
+        size_t i;
+
+        if (batch->columns != NULL) {
+                for (i = 0; i < batch->columnCount; i++) {
+                        column_destroy(&batch->columns[i], batch->allocator);
+                }
+                allocator_free(batch->allocator, batch->columns);
+        }
+
+        allocator_free(batch->allocator, batch);
+}
+
+inline int column_is_valid(const Column *column, size_t row)
+{
+        return (column->validity[row / 8] >> (row % 8)) & 1;
+}
+
+RecordBatch *record_batch_alloc(size_t capacity, const Allocator *allocator)
+{
+        RecordBatch *result = allocator_malloc(allocator, sizeof(RecordBatch));
+
+        if (result == NULL)
+                return NULL;
+
+        if (capacity == 0)
+                capacity = 1;
+
+        result->length = 0;
+        result->capacity = capacity;
+        result->fieldCount = 0;
+        result->fieldSize = capacity * RECORD_BATCH_FIELDS;
+        result->columns = NULL;
+        result->allocator = allocator;
+        result->fields = allocator_malloc(allocator, sizeof(FieldView) * result->fieldSize);
+        result->records = allocator_malloc(allocator, sizeof(size_t) * (capacity + 1));
+        result->data = buffer_alloc_with(result->fieldSize * RECORD_BATCH_FIELD_BYTES + 1, allocator);
+
+        if (result->fields == NULL || result->records == NULL || result->data == NULL) {
+                record_batch_free(result);
+                return NULL;
+        }
+
+        result->records[0] = 0;
+        return result;
+}
+
+int record_batch_append(RecordBatch *batch, const RecordView *record)
+{
+        size_t fieldCount = batch->fieldCount + record->arraySize;
+        size_t fieldSize = batch->fieldSize;
+        FieldView *fields;
+        FieldView *field;
+        char *destination;
+        size_t span;
+        size_t size;
+        size_t i;
+
+        if (batch->length >= batch->capacity) {
+                errno = ENOBUFS;
+                return -1;
+        }
+
+        if (fieldCount > fieldSize) {
+                while (fieldSize < fieldCount)
+                        fieldSize *= 2;
+                fields = allocator_realloc(batch->allocator, batch->fields, sizeof(FieldView) * batch->fieldSize,
+                                           sizeof(FieldView) * fieldSize);
+                if (fields == NULL)
+                        return -1;
+                batch->fields = fields;
+                batch->fieldSize = fieldSize;
+        }
+
+        // Fields which follow each other in the input are copied at once,
+        // together with the separators between them
+        span = record_batch_span(record, &size);
+        if (record_batch_reserve(batch, span > 0 ? span : size) < 0)
+                return -1;
+
+        field = batch->fields + batch->fieldCount;
+        destination = batch->data->buffer + batch->data->stringLength;
+
+        if (span > 0) {
+                memcpy(destination, record->fields[0].data, span);
+                for (i = 0; i < record->arraySize; i++, field++) {
+                        field->data = destination + (record->fields[i].data - record->fields[0].data);
+                        field->length = record->fields[i].length;
+                }
+                batch->data->stringLength += span;
+        } else {
+                for (i = 0; i < record->arraySize; i++, field++) {
+                        memcpy(destination, record->fields[i].data, record->fields[i].length);
+                        field->data = destination;
+                        field->length = record->fields[i].length;
+                        destination += field->length;
+                }
+                batch->data->stringLength += size;
+        }
+
+        batch->fieldCount = fieldCount;
+        batch->length += 1;
+        batch->records[batch->length] = fieldCount;
+        return 0;
+}
+
+inline void record_batch_get(const RecordBatch *batch, size_t index, RecordView *record)
+{
+        record->fields = batch->fields + batch->records[index];
+        record->arraySize = batch->records[index + 1] - batch->records[index];
+        record->bufferSize = record->arraySize;
+        record->columns = batch->columns;
+}
+
+void record_batch_reset(RecordBatch *batch)
+{
+        batch->length = 0;
+        batch->fieldCount = 0;
+        buffer_reset(batch->data);
+}
+
+void record_batch_free(RecordBatch *batch)
+{
+        allocator_free(batch->allocator, batch->fields);
+        allocator_free(batch->allocator, batch->records);
+        if (batch->data != NULL)
+                buffer_free(batch->data);
+        allocator_free(batch->allocator, batch);
+}
+
+// Private Implementation
+
+int column_init(Column *column, size_t capacity, size_t width, const Allocator *allocator)
+{
+        size_t validitySize = (capacity + 7) / 8;
+
+        column->nullCount = 0;
+        column->ints = NULL;
+        column->floats = NULL;
+        column->offsets = NULL;
+        column->data = NULL;
+        column->validity = allocator_malloc(allocator, validitySize);
+
+        if (column->validity == NULL)
+                return -1;
+        memset(column->validity, 0, validitySize);
+
+        if (column->type == STRING_TYPE_INT) {
+                column->ints = allocator_malloc(allocator, sizeof(int64_t) * capacity);
+                return column->ints != NULL ? 0 : -1;
+        }
+
+        if (column->type == STRING_TYPE_FLOAT) {
+                column->floats = allocator_malloc(allocator, sizeof(double) * capacity);
+                return column->floats != NULL ? 0 : -1;
+        }
+
+        column->offsets = allocator_malloc(allocator, sizeof(size_t) * (capacity + 1));
+        column->data = buffer_alloc_with(capacity * (width > 0 ? width : 1) + 1, allocator);
+
+        if (column->offsets == NULL || column->data == NULL)
+                return -1;
+
+        column->offsets[0] = 0;
+        return 0;
+}
+
+void column_destroy(Column *column, const Allocator *allocator)
+{
+        allocator_free(allocator, column->validity);
+        allocator_free(allocator, column->ints);
+        allocator_free(allocator, column->floats);
+        allocator_free(allocator, column->offsets);
+        if (column->data != NULL)
+                buffer_free(column->data);
+}
+
+int column_append(Column *column, size_t row, const FieldView *field)
+{
+        int valid = field != NULL;
+
+        switch (column->type) {
+                // The conversions reject the empty fields, and the values of other types
+                case STRING_TYPE_INT:
+                        valid = valid && string_to_int64(field->data, field->length, &column->ints[row]) == 0;
+                        if (!valid)
+                                column->ints[row] = 0;
+                        break;
+                case STRING_TYPE_FLOAT:
+                        valid = valid && string_to_double(field->data, field->length, &column->floats[row]) == 0;
+                        if (!valid)
+                                column->floats[row] = 0;
+                        break;
+                default:
+                        valid = valid && string_type_len(field->data, field->length) != STRING_TYPE_EMPTY;
+                        if (valid && buffer_append_str(column->data, field->data, field->length) == NULL)
+                                return -1;
+                        column->offsets[row + 1] = column->data->stringLength;
+                        break;
+        }
+
+        if (valid)
+                column->validity[row / 8] |= (uint8_t) (1 << (row % 8));
+        else
+                column->nullCount += 1;
+        return 0;
+}
+
+void column_append_typed(Column *column, size_t row, const TypedColumn *typed, size_t index)
+{
+        int valid = (typed->validity[index / 8] >> (index % 8)) & 1;
+
+        if (column->type == STRING_TYPE_INT)
+                column->ints[row] = valid ? typed->ints[index] : 0;
+        else
+                column->floats[row] = valid ? typed->floats[index] : 0;
+
+        if (valid)
+                column->validity[row / 8] |= (uint8_t) (1 << (row % 8));
+        else
+                column->nullCount += 1;
+}
+
+int record_batch_reserve(RecordBatch *batch, size_t size)
+{
+        Buffer *data = batch->data;
+        Buffer *grown;
+        size_t i;
+
+        if (data->stringLength + size < data->bufferLength)
+                return 0;
+
+        grown = buffer_alloc_with(2 * (data->stringLength + size) + 1, batch->allocator);
+        if (grown == NULL)
+                return -1;
+
+        memcpy(grown->buffer, data->buffer, data->stringLength);
+        grown->stringLength = data->stringLength;
+
+        for (i = 0; i < batch->fieldCount; i++) {
+                batch->fields[i].data = grown->buffer + (batch->fields[i].data - data->buffer);
+        }
+
+        buffer_free(data);
+        batch->data = grown;
+        return 0;
+}
+
+size_t record_batch_span(const RecordView *record, size_t *size)
+{
+        uintptr_t end;
+        uintptr_t start;
+        size_t i;
+
+        *size = 0;
+        for (i = 0; i < record->arraySize; i++) {
+                *size += record->fields[i].length;
+        }
+
+        if (record->arraySize == 0)
+                return 0;
+
+        end = (uintptr_t) record->fields[0].data;
+        for (i = 0; i < record->arraySize; i++) {
+                start = (uintptr_t) record->fields[i].data;
+                if (start < end || start - end > RECORD_BATCH_GAP)
+                        return 0;
+                end = start + record->fields[i].length;
+        }
+
+        return end - (uintptr_t) record->fields[0].data;
+}
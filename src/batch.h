@@ -0,0 +1,180 @@
+//
+// Created by Davide on 16/10/2026.
+//
+
+#ifndef C_CSV__BATCH_H
+#define C_CSV__BATCH_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "buffer.h"
+#include "record.h"
+#include "schema.h"
+
+/**
+ * A column of a batch, stored contiguously.
+ * type is the type of the column schema: values of STRING_TYPE_INT columns
+ * are stored in ints, values of STRING_TYPE_FLOAT columns in floats, the
+ * other columns are strings: the value of row i is stored in data from
+ * offsets[i] to offsets[i + 1] (data is not null terminated).
+ * Bit i of validity (least significant bit first) is set if row i is not
+ * null. A field is null if it is empty, if it is missing, or if it cannot
+ * be converted to the type of the column.
+ * nullCount is the number of null rows
+ */
+typedef struct Column_s {
+        char type;
+        uint8_t *validity;
+        size_t nullCount;
+        int64_t *ints;
+        double *floats;
+        size_t *offsets;
+        Buffer *data;
+} Column;
+
+/**
+ * The values of a column converted in advance, for a sequence of records.
+ * type is STRING_TYPE_INT if the values are stored in ints,
+ * STRING_TYPE_FLOAT if they are stored in floats, or STRING_TYPE_TEXT if
+ * the column is not converted. Bit i of validity is set if the field of
+ * record i has been converted, as in a Column
+ */
+typedef struct TypedColumn_s {
+        char type;
+        const uint8_t *validity;
+        const int64_t *ints;
+        const double *floats;
+} TypedColumn;
+
+/**
+ * A column major block of records.
+ * columns holds columnCount columns, each one storing length rows.
+ * At most capacity rows are stored
+ */
+typedef struct Batch_s {
+        Column *columns;
+        size_t columnCount;
+        size_t length;
+        size_t capacity;
+        const Allocator *allocator;
+} Batch;
+
+/**
+ * A row major block of records.
+ * The fields of all the records are stored contiguously in fields, and
+ * their bytes are copied contiguously in data: record i is made of the
+ * fields from records[i] to records[i + 1] (see record_batch_get).
+ * length is the number of records, at most capacity. fieldCount is the
+ * number of fields of all the records, fieldSize the size of fields.
+ * The buffers are reused when the batch is reset, so in steady state
+ * filling a batch does not allocate.
+ * columns, if not NULL, maps the names of the header to the fields
+ */
+typedef struct RecordBatch_s {
+        FieldView *fields;
+        size_t *records;
+        size_t length;
+        size_t capacity;
+        size_t fieldCount;
+        size_t fieldSize;
+        Buffer *data;
+        const struct ColumnMap_s *columns;
+        const Allocator *allocator;
+} RecordBatch;
+
+/**
+ * Allocate a batch. The buffers of the columns are sized according to the
+ * schema, so that in the common case filling the batch does not allocate
+ * @param schema the schema of the records. Fields past the end of the
+ *               schema are discarded
+ * @param capacity the maximum number of rows
+ * @param allocator the allocator, if NULL malloc is used. It must outlive
+ *                  the batch
+ * @return the batch, or NULL on error
+ */
+Batch *batch_alloc(const Schema *schema, size_t capacity, const Allocator *allocator);
+
+/**
+ * Append a record to a batch, converting its fields to the types of the
+ * columns
+ * @param batch the batch, it must not be full
+ * @param record the record
+ * @return 0 on success, -1 on error
+ */
+int batch_append(Batch *batch, const RecordView *record);
+
+/**
+ * Append a record to a batch, taking the values of the columns from the
+ * typed columns of the same type instead of converting the fields
+ * @param batch the batch, it must not be full
+ * @param record the record
+ * @param typed the typed column of each of the typedCount fields of the
+ *              record, NULL for the fields which are not converted
+ * @param typedCount the number of typed columns
+ * @param row the index of the record in the typed columns
+ * @return 0 on success, -1 on error
+ */
+int batch_append_typed(Batch *batch, const RecordView *record, const TypedColumn *const *typed,
+                       size_t typedCount, size_t row);
+
+/**
+ * Remove all the rows of a batch, without releasing its buffers
+ * @param batch the batch
+ */
+void batch_reset(Batch *batch);
+
+/**
+ * Free a batch
+ * @param batch the batch
+ */
+void batch_free(Batch *batch);
+
+/**
+ * Check if a value of a column is not null
+ * @param column the column
+ * @param row the index of the row
+ * @return 1 if the value is valid, 0 if it is null
+ */
+int column_is_valid(const Column *column, size_t row);
+
+/**
+ * Allocate a row major batch
+ * @param capacity the maximum number of records
+ * @param allocator the allocator, if NULL malloc is used. It must outlive
+ *                  the batch
+ * @return the batch, or NULL on error
+ */
+RecordBatch *record_batch_alloc(size_t capacity, const Allocator *allocator);
+
+/**
+ * Append a copy of a record to a batch
+ * @param batch the batch, it must not be full
+ * @param record the record
+ * @return 0 on success, -1 on error
+ */
+int record_batch_append(RecordBatch *batch, const RecordView *record);
+
+/**
+ * Get a view on a record of a batch, valid as long as the batch is not
+ * modified
+ * @param batch the batch
+ * @param index the index of the record, less than length
+ * @param record output, the view. Its fields point inside the batch, it
+ *               must not be modified
+ */
+void record_batch_get(const RecordBatch *batch, size_t index, RecordView *record);
+
+/**
+ * Remove all the records of a batch, without releasing its buffers
+ * @param batch the batch
+ */
+void record_batch_reset(RecordBatch *batch);
+
+/**
+ * Free a row major batch
+ * @param batch the batch
+ */
+void record_batch_free(RecordBatch *batch);
+
+#endif //C_CSV__BATCH_H
@@ -7,17 +7,23 @@
 
 #include "buffer.h"
 
-Buffer *buffer_alloc(size_t len)
+inline Buffer *buffer_alloc(size_t len)
 {
-        Buffer *result = malloc(sizeof(Buffer));
+        return buffer_alloc_with(len, NULL);
+}
+
+Buffer *buffer_alloc_with(size_t len, const Allocator *allocator)
+{
+        Buffer *result = allocator_malloc(allocator, sizeof(Buffer));
 
         if (result == NULL) return NULL;
         for (result->bufferLength = 1 ; result->bufferLength < len; result->bufferLength *= 2);
 
-        result->buffer = malloc(sizeof(char) * result->bufferLength);
+        result->allocator = allocator;
+        result->buffer = allocator_malloc(allocator, sizeof(char) * result->bufferLength);
 
         if (result->buffer == NULL) {
-                free(result);
+                allocator_free(allocator, result);
                 return NULL;
         }
 
@@ -27,19 +33,37 @@ Buffer *buffer_alloc(size_t len)
 }
 
 inline void buffer_free(Buffer *buffer) {
-        free(buffer->buffer);
-        free(buffer);
+        const Allocator *allocator = buffer->allocator;
+        allocator_free(allocator, buffer->buffer);
+        allocator_free(allocator, buffer);
 }
 inline void buffer_reset(Buffer *buffer) { buffer->buffer[0] = 0; buffer->stringLength = 0; }
 
+char *buffer_reserve(Buffer *buf, size_t len)
+{
+        size_t newLength = buf->bufferLength;
+        char *newBuffer;
+
+        for (; newLength <= buf->stringLength + len; newLength *= 2);
+
+        if (newLength == buf->bufferLength)
+                return buf->buffer;
+
+        newBuffer = allocator_realloc(buf->allocator, buf->buffer,
+                                      buf->bufferLength * sizeof *buf->buffer,
+                                      newLength * sizeof *buf->buffer);
+        if (newBuffer == NULL)
+                return NULL;
+
+        buf->buffer = newBuffer;
+        buf->bufferLength = newLength;
+        return buf->buffer;
+}
+
 char *buffer_append(Buffer *buf, char c)
 {
-        // It should loop once anyway
-        for (; buf->bufferLength <= buf->stringLength + 1; buf->bufferLength *= 2) {
-                buf->buffer =  realloc(buf->buffer, buf->bufferLength * sizeof *buf->buffer);
-                if (buf->buffer == NULL)
-                        return NULL;
-        }
+        if (buffer_reserve(buf, 1) == NULL)
+                return NULL;
 
         buf->buffer[buf->stringLength] = c;
         buf->stringLength += 1;
@@ -47,3 +71,13 @@ char *buffer_append(Buffer *buf, char c)
         return buf->buffer;
 }
 
+char *buffer_append_str(Buffer *buf, const char *string, size_t len)
+{
+        if (buffer_reserve(buf, len) == NULL)
+                return NULL;
+
+        memcpy(buf->buffer + buf->stringLength, string, len);
+        buf->stringLength += len;
+        buf->buffer[buf->stringLength] = 0;
+        return buf->buffer;
+}
@@ -5,6 +5,8 @@
 #ifndef C_CSV__BUFFER_H
 #define C_CSV__BUFFER_H
 
+#include "arena.h"
+
 /**
  * This is a buffer which is internally used by the csv parser to
  * temporarily store the quoted strings
@@ -12,7 +14,8 @@
 typedef struct Buffer_s {
         char *buffer;
         size_t stringLength;
-        int bufferLength;
+        size_t bufferLength;
+        const Allocator *allocator;
 } Buffer;
 
 /**
@@ -21,6 +24,14 @@ typedef struct Buffer_s {
  */
 Buffer *buffer_alloc(size_t len);
 
+/**
+ * Create a buffer structure whose memory is provided by an allocator
+ * @param allocator the allocator, if NULL malloc is used. It must outlive
+ *                  the buffer
+ * @return the buffer
+ */
+Buffer *buffer_alloc_with(size_t len, const Allocator *allocator);
+
 /**
  * Destroy a buffer structure
  * @param buffer the buffer
@@ -41,5 +52,23 @@ void buffer_reset(Buffer *buffer);
  */
 char *buffer_append(Buffer *buf, char c);
 
+/**
+ * Append len bytes at the end of the buffer
+ * @param buffer the buffer
+ * @param string the bytes to append, it may not be null terminated
+ * @param len number of bytes
+ * @return the underlying buffer on success, NULL otherwise
+ */
+char *buffer_append_str(Buffer *buf, const char *string, size_t len);
+
+/**
+ * Make sure that at least len more bytes (plus the null terminator)
+ * can be stored in the buffer without reallocating
+ * @param buffer the buffer
+ * @param len number of bytes
+ * @return the underlying buffer on success, NULL otherwise
+ */
+char *buffer_reserve(Buffer *buf, size_t len);
+
 
 #endif //C_CSV__BUFFER_H
@@ -0,0 +1,701 @@
+//
+// Created by Davide on 16/10/2026.
+//
+
+#include <stddef.h>
+#include <utils.h>
+#include "parser.h"
+
+#define CACHE_MAGIC "CCSVCAC2"
+#define CACHE_BYTE_ORDER 0x0102030405060708ULL
+#define CACHE_HASH_BLOCK (64 << 10)
+#define CACHE_HASH_SEED 0x9e3779b97f4a7c15ULL
+#define CACHE_ALIGNMENT 8
+#define CACHE_WRITE_SIZE (1 << 20)
+#define CACHE_WRITE_VALUES 4096
+
+#ifdef __APPLE__
+#define stat_mtime_nsec(info) ((info)->st_mtimespec.tv_nsec)
+#define stat_ctime_nsec(info) ((info)->st_ctimespec.tv_nsec)
+#else
+#define stat_mtime_nsec(info) ((info)->st_mtim.tv_nsec)
+#define stat_ctime_nsec(info) ((info)->st_ctim.tv_nsec)
+#endif
+
+/**
+ * The description of a typed column in a cache file: values holds the value
+ * of each record (0 if it is not valid), validity is a bitmap as in a
+ * TypedColumn. Both are 0 if the column is not converted
+ */
+typedef struct CacheColumn_s {
+        uint64_t type;
+        uint64_t values;
+        uint64_t validity;
+} CacheColumn;
+
+
+// Private prototypes
+
+#ifdef CSV_POSIX
+
+/**
+ * Describe a csv file in the header of its cache
+ * @param reader the CsvReader, whose dialect the file is parsed with
+ * @param data the content of the file
+ * @param len the length of the file
+ * @param info the status of the file
+ * @param header output, the header
+ */
+void cache_source(CsvReader *reader, const char *data, size_t len, const struct stat *info, CacheHeader *header);
+
+/**
+ * Pack the characters of a dialect in an integer
+ * @param dialect the dialect
+ * @return the packed dialect
+ */
+uint64_t cache_dialect(const Dialect *dialect);
+
+/**
+ * Map a cache file, checking that it holds the expected csv file
+ * @param path the path of the cache file
+ * @param source the description of the csv file (see cache_source)
+ * @return the cache, or NULL if it is missing, if it holds another file
+ *         or if it is malformed
+ */
+Cache *cache_map(const char *path, const CacheHeader *source);
+
+/**
+ * Check that a section of a cache file is aligned and inside the file
+ * @param offset the offset of the section
+ * @param count the number of elements of the section
+ * @param size the size of an element
+ * @param len the length of the file
+ * @return 1 if the section is valid, 0 otherwise
+ */
+int cache_section(uint64_t offset, uint64_t count, size_t size, size_t len);
+
+/**
+ * Check the tables of the records of a mapped cache, in a single pass: the
+ * entries must not decrease, the last one must end the text of the fields
+ * and the csv file, and the ends of the fields of each record must not
+ * decrease and must end with the text of the record
+ * @param cache the cache, whose sections are inside the file
+ * @param header the header of the cache
+ * @return 1 if the records are valid, 0 otherwise
+ */
+int cache_check_records(const Cache *cache, const CacheHeader *header);
+
+/**
+ * Parse a csv file and write its cache. The cache is written in a new
+ * temporary file which is then renamed, so a cache file is always complete.
+ * The group and the others can read it if they can read the csv file
+ * @param reader the CsvReader, whose dialect the file is parsed with
+ * @param data the content of the csv file
+ * @param len the length of the csv file
+ * @param source the description of the csv file (see cache_source)
+ * @param mode the permissions of the csv file
+ * @param path the path of the cache file
+ * @return 0 on success, -1 on error
+ */
+int cache_write(CsvReader *reader, const char *data, size_t len, const CacheHeader *source, mode_t mode,
+                const char *path);
+
+/**
+ * Write the text of the fields and the tables of the records of a cache
+ * @param reader the CsvReader, whose dialect the file is parsed with
+ * @param data the content of the csv file
+ * @param len the length of the csv file
+ * @param file the cache file, positioned after the header
+ * @param header the header of the cache, whose counts and offsets are set
+ * @param types output, the type of each column: the widest type of its
+ *              non empty fields, as inferred by a schema. It is allocated
+ *              with malloc
+ * @return 0 on success, -1 on error
+ */
+int cache_write_records(CsvReader *reader, const char *data, size_t len, FILE *file, CacheHeader *header,
+                        char **types);
+
+/**
+ * Write the typed columns of a cache, whose records have already been
+ * written
+ * @param file the cache file, positioned at the end of the records
+ * @param path the path of the cache file
+ * @param header the header of the cache, whose columnsOffset is set
+ * @param types the type of each column
+ * @return 0 on success, -1 on error
+ */
+int cache_write_columns(FILE *file, const char *path, CacheHeader *header, const char *types);
+
+/**
+ * Write zeros up to the next multiple of CACHE_ALIGNMENT
+ * @param file the file
+ * @param position the position in the file, updated
+ * @return 0 on success, -1 on error
+ */
+int cache_align(FILE *file, uint64_t *position);
+
+#endif
+
+
+// Public Implementation
+
+void cache_free(Cache *cache)
+{
+#ifdef CSV_POSIX
+        unmap_file(cache->mapping, cache->mappingLength);
+#endif
+        free(cache->columns);
+        free(cache);
+}
+
+void csv_reader_set_cache(CsvReader *reader, int enabled)
+{
+        reader->cache = enabled != 0;
+}
+
+#ifdef CSV_POSIX
+Cache *load_cache(CsvReader *reader, const char *path)
+{
+        char *cachePath = malloc(strlen(path) + sizeof CSV_CACHE_SUFFIX);
+        CacheHeader source;
+        struct stat info;
+        const char *data;
+        size_t len;
+        Cache *result;
+
+        if (cachePath == NULL)
+                return NULL;
+
+        if (stat(path, &info) < 0 || map_file(path, &data, &len) < 0) {
+                free(cachePath);
+                return NULL;
+        }
+
+        strcpy(cachePath, path);
+        strcat(cachePath, CSV_CACHE_SUFFIX);
+        cache_source(reader, data, len, &info, &source);
+
+        result = cache_map(cachePath, &source);
+        if (result == NULL && cache_write(reader, data, len, &source, info.st_mode, cachePath) == 0)
+                result = cache_map(cachePath, &source);
+
+        unmap_file(data, len);
+        free(cachePath);
+        return result;
+}
+#else
+Cache *load_cache(CsvReader *reader, const char *path)
+{
+        // Without mmap the csv file is always parsed
+        return NULL;
+}
+#endif
+
+void set_cache(ParsingContext *pc, Cache *cache)
+{
+        pc->cache = cache;
+        pc->cacheRecord = 0;
+        pc->data = cache->text;
+        pc->length = cache->textLength;
+}
+
+int get_cached_record(ParsingContext *pc)
+{
+        const Cache *cache = pc->cache;
+        const CacheEntry *entry;
+        FieldSpan *fields;
+        size_t count;
+        size_t start;
+        size_t end;
+        size_t i;
+
+        // Records which do not satisfy the predicates are skipped
+        do {
+                if (pc->cacheRecord >= cache->records) {
+                        pc->flags |= PROCESSED_ALL_RECORDS;
+                        return 0;
+                }
+
+                entry = &cache->entries[pc->cacheRecord];
+                pc->cacheRecord += 1;
+                pc->fieldCount = 0;
+                pc->column = 0;
+
+                // Selected columns missing from the record are empty
+                for (; pc->fieldCount < pc->projectionCount; pc->fieldCount++) {
+                        pc->fields[pc->fieldCount].offset = 0;
+                        pc->fields[pc->fieldCount].length = 0;
+                        pc->fields[pc->fieldCount].escaped = 0;
+                }
+
+                start = entry->text;
+                count = entry[1].field - entry->field;
+
+                // Without selection and predicates the fields are stored as they are
+                if (pc->projection == NULL && pc->filterCount == 0) {
+                        if (count > pc->fieldSize) {
+                                fields = allocator_realloc(pc->allocator, pc->fields, pc->fieldSize * sizeof *fields,
+                                                           count * sizeof *fields);
+                                if (fields == NULL) {
+                                        perror("Cannot alloc memory buffer for csv parsing");
+                                        abort();
+                                }
+                                pc->fields = fields;
+                                pc->fieldSize = count;
+                        }
+
+                        fields = pc->fields;
+                        for (i = 0; i < count; i++) {
+                                end = entry->text + cache->ends[entry->field + i];
+                                fields[i].offset = start;
+                                fields[i].length = end - start;
+                                fields[i].escaped = 0;
+                                start = end;
+                        }
+
+                        pc->fieldCount = count;
+                        pc->column = count;
+                        stats_add(pc, fields, count);
+                } else {
+                        for (i = 0; i < count; i++) {
+                                end = entry->text + cache->ends[entry->field + i];
+                                emit_field(pc, start, end - start, 0);
+                                start = end;
+                        }
+                }
+
+#ifdef CSV_STATS
+                pc->stats.records += 1;
+                pc->stats.bytes += entry[1].offset - entry->offset;
+                stats_max(pc, largestRecord, entry[1].offset - entry->offset);
+#endif
+        } while (pc->filterCount > 0 && !accept_record(pc));
+
+        return 1;
+}
+
+void resolve_typed_columns(ParsingContext *pc)
+{
+        const Cache *cache = pc->cache;
+        size_t count = pc->projection != NULL ? pc->projectionCount : cache->columnCount;
+        size_t column;
+        size_t slot;
+
+        pc->typedColumns = allocator_malloc(pc->allocator, sizeof(TypedColumn *) * (count + 1));
+        if (pc->typedColumns == NULL) {
+                perror("Cannot alloc memory buffer for csv parsing");
+                abort();
+        }
+
+        pc->typedCount = count;
+        for (slot = 0; slot < count; slot++) {
+                pc->typedColumns[slot] = pc->projection == NULL ? &cache->columns[slot] : NULL;
+        }
+
+        // The fields of the view are the selected columns
+        if (pc->projection != NULL) {
+                for (column = 0; column < pc->projectionColumns && column < cache->columnCount; column++) {
+                        slot = pc->projection[column];
+                        if (slot != NOT_SELECTED)
+                                pc->typedColumns[slot] = &cache->columns[column];
+                }
+        }
+}
+
+
+// Private Implementation
+
+#ifdef CSV_POSIX
+void cache_source(CsvReader *reader, const char *data, size_t len, const struct stat *info, CacheHeader *header)
+{
+        size_t block = len < CACHE_HASH_BLOCK ? len : CACHE_HASH_BLOCK;
+
+        memset(header, 0, sizeof *header);
+        memcpy(header->magic, CACHE_MAGIC, CACHE_MAGIC_LENGTH);
+        header->byteOrder = CACHE_BYTE_ORDER;
+        header->dialect = cache_dialect(&reader->dialect);
+        header->sourceSize = len;
+        header->sourceInode = (uint64_t) info->st_ino;
+        header->sourceModified = (uint64_t) info->st_mtime * 1000000000 + (uint64_t) stat_mtime_nsec(info);
+        header->sourceChanged = (uint64_t) info->st_ctime * 1000000000 + (uint64_t) stat_ctime_nsec(info);
+
+        // Hashing the whole file would cost as much as parsing it
+        header->sourceHash = string_hash(data, block, CACHE_HASH_SEED);
+        header->sourceHash = string_hash(data + len - block, block, header->sourceHash);
+}
+
+uint64_t cache_dialect(const Dialect *dialect)
+{
+        return (uint64_t) (unsigned char) dialect->delimiter |
+               (uint64_t) (unsigned char) dialect->quote << 8 |
+               (uint64_t) (unsigned char) dialect->escape << 16 |
+               (uint64_t) (unsigned char) dialect->lineEnding << 24 |
+               (uint64_t) (unsigned char) dialect->trim << 32;
+}
+
+Cache *cache_map(const char *path, const CacheHeader *source)
+{
+        const CacheHeader *header;
+        const CacheColumn *columns;
+        const char *data;
+        Cache *result;
+        size_t len;
+        size_t i;
+
+        if (map_file(path, &data, &len) < 0)
+                return NULL;
+
+        header = (const CacheHeader *) data;
+        columns = (const CacheColumn *) (data + (len >= sizeof *header ? header->columnsOffset : 0));
+
+        if (len < sizeof *header || memcmp(header, source, offsetof(CacheHeader, records)) != 0 ||
+            !cache_section(header->textOffset, header->textLength, 1, len) ||
+            !cache_section(header->entriesOffset, header->records + 1, sizeof(CacheEntry), len) ||
+            !cache_section(header->endsOffset, header->fields, sizeof(uint32_t), len) ||
+            !cache_section(header->columnsOffset, header->columns, sizeof(CacheColumn), len)) {
+                unmap_file(data, len);
+                return NULL;
+        }
+
+        result = malloc(sizeof(Cache));
+        if (result == NULL) {
+                unmap_file(data, len);
+                return NULL;
+        }
+
+        result->mapping = data;
+        result->mappingLength = len;
+        result->records = header->records;
+        result->entries = (const CacheEntry *) (data + header->entriesOffset);
+        result->ends = (const uint32_t *) (data + header->endsOffset);
+        result->text = data + header->textOffset;
+        result->textLength = header->textLength;
+        result->columnCount = header->columns;
+        result->columns = malloc(sizeof(TypedColumn) * (header->columns + 1));
+
+        // A corrupted cache must not make the parser read outside the mapping
+        if (result->columns == NULL || !cache_check_records(result, header)) {
+                cache_free(result);
+                return NULL;
+        }
+
+        for (i = 0; i < result->columnCount; i++) {
+                result->columns[i].type = (char) columns[i].type;
+                result->columns[i].validity = (const uint8_t *) (data + columns[i].validity);
+                result->columns[i].ints = (const int64_t *) (data + columns[i].values);
+                result->columns[i].floats = (const double *) (data + columns[i].values);
+
+                if (columns[i].type != STRING_TYPE_TEXT &&
+                    (!cache_section(columns[i].values, header->records, sizeof(int64_t), len) ||
+                     !cache_section(columns[i].validity, (header->records + 7) / 8, 1, len))) {
+                        cache_free(result);
+                        return NULL;
+                }
+        }
+
+        return result;
+}
+
+int cache_section(uint64_t offset, uint64_t count, size_t size, size_t len)
+{
+        return offset % CACHE_ALIGNMENT == 0 && offset <= len && count <= (len - offset) / size;
+}
+
+int cache_check_records(const Cache *cache, const CacheHeader *header)
+{
+        const CacheEntry *entry = cache->entries;
+        const CacheEntry *last = cache->entries + cache->records;
+        uint64_t span;
+        uint32_t end;
+        uint64_t i;
+
+        if (entry->field != 0 || entry->text != 0 || last->field != header->fields ||
+            last->text != header->textLength || last->offset != header->sourceSize)
+                return 0;
+
+        for (; entry < last; entry++) {
+                if (entry[1].field < entry->field || entry[1].text < entry->text || entry[1].offset < entry->offset)
+                        return 0;
+
+                span = entry[1].text - entry->text;
+                for (i = entry->field, end = 0; i < entry[1].field; i++) {
+                        if (cache->ends[i] < end)
+                                return 0;
+                        end = cache->ends[i];
+                }
+                if (end != span)
+                        return 0;
+        }
+
+        return 1;
+}
+
+int cache_write(CsvReader *reader, const char *data, size_t len, const CacheHeader *source, mode_t mode,
+                const char *path)
+{
+        char *temporary = malloc(strlen(path) + sizeof ".XXXXXX");
+        CacheHeader header = *source;
+        char *types = NULL;
+        FILE *file = NULL;
+        int result = -1;
+        int fd;
+
+        if (temporary == NULL)
+                return -1;
+
+        // Readers of the same file may write its cache at the same time, and
+        // the temporary file must not be an existing file or link
+        strcpy(temporary, path);
+        strcat(temporary, ".XXXXXX");
+        fd = mkstemp(temporary);
+        if (fd >= 0 && (fchmod(fd, 0600 | (mode & 0044)) < 0 || (file = fdopen(fd, "wb")) == NULL)) {
+                close(fd);
+                remove(temporary);
+        }
+
+        if (file != NULL &&
+            fwrite(&header, sizeof header, 1, file) == 1 &&
+            cache_write_records(reader, data, len, file, &header, &types) == 0 &&
+            cache_write_columns(file, temporary, &header, types) == 0 &&
+            fseeko(file, 0, SEEK_SET) == 0 &&
+            fwrite(&header, sizeof header, 1, file) == 1)
+                result = 0;
+
+        if (file != NULL && fclose(file) != 0)
+                result = -1;
+
+        if (result == 0 && rename(temporary, path) < 0)
+                result = -1;
+
+        if (result < 0 && file != NULL)
+                remove(temporary);
+
+        free(types);
+        free(temporary);
+        return result;
+}
+
+int cache_write_records(CsvReader *reader, const char *data, size_t len, FILE *file, CacheHeader *header,
+                        char **types)
+{
+        ParsingContext pc;
+        Buffer *entries = buffer_alloc(sizeof(CacheEntry) * BATCH_SIZE);
+        Buffer *ends = buffer_alloc(sizeof(uint32_t) * BATCH_SIZE);
+        Buffer *text = buffer_alloc(CACHE_WRITE_SIZE);
+        uint64_t position = sizeof(CacheHeader);
+        CacheEntry entry;
+        RecordView *view;
+        uint32_t end;
+        char *newTypes;
+        char type;
+        size_t i;
+        int result = 0;
+
+        if (entries == NULL || ends == NULL || text == NULL) {
+                result = -1;
+                goto end;
+        }
+
+        // The records are parsed without the selection and the predicates of
+        // the reader, so that the cache serves any parsing of the file
+        parsing_context_init(reader, &pc);
+        pc.data = data;
+        pc.length = len;
+        view = pc.view;
+        header->textOffset = position;
+
+        while (result == 0 && get_next_record(&pc)) {
+                resolve_fields(&pc, view);
+
+                entry.field = header->fields;
+                entry.text = header->textLength;
+                entry.offset = pc.recordStart;
+                if (buffer_append_str(entries, (const char *) &entry, sizeof entry) == NULL)
+                        result = -1;
+
+                if (view->arraySize > header->columns) {
+                        newTypes = realloc(*types, view->arraySize);
+                        if (newTypes == NULL) {
+                                result = -1;
+                                break;
+                        }
+                        memset(newTypes + header->columns, STRING_TYPE_EMPTY, view->arraySize - header->columns);
+                        *types = newTypes;
+                        header->columns = view->arraySize;
+                }
+
+                for (i = 0, end = 0; i < view->arraySize && result == 0; i++) {
+                        // Records longer than 4 GiB are not cached
+                        if (view->fields[i].length > UINT32_MAX - end) {
+                                result = -1;
+                                break;
+                        }
+
+                        end += (uint32_t) view->fields[i].length;
+                        if (buffer_append_str(text, view->fields[i].data, view->fields[i].length) == NULL ||
+                            buffer_append_str(ends, (const char *) &end, sizeof end) == NULL)
+                                result = -1;
+
+                        // The first record is the header
+                        type = string_type_len(view->fields[i].data, view->fields[i].length);
+                        if (header->records > 0 && type > (*types)[i])
+                                (*types)[i] = type;
+                }
+
+                if (text->stringLength >= CACHE_WRITE_SIZE || result < 0) {
+                        if (fwrite(text->buffer, 1, text->stringLength, file) != text->stringLength)
+                                result = -1;
+                        buffer_reset(text);
+                }
+
+                header->records += 1;
+                header->fields += view->arraySize;
+                header->textLength += end;
+        }
+
+        parsing_context_destroy(&pc);
+
+        if (result == 0 && fwrite(text->buffer, 1, text->stringLength, file) != text->stringLength)
+                result = -1;
+
+        entry.field = header->fields;
+        entry.text = header->textLength;
+        entry.offset = len;
+        position += header->textLength;
+
+        if (result == 0 && (cache_align(file, &position) < 0 ||
+                            buffer_append_str(entries, (const char *) &entry, sizeof entry) == NULL))
+                result = -1;
+
+        header->entriesOffset = position;
+        position += entries->stringLength;
+        if (result == 0 && fwrite(entries->buffer, 1, entries->stringLength, file) != entries->stringLength)
+                result = -1;
+
+        header->endsOffset = position;
+        position += ends->stringLength;
+        if (result == 0 && (fwrite(ends->buffer, 1, ends->stringLength, file) != ends->stringLength ||
+                            cache_align(file, &position) < 0))
+                result = -1;
+
+        header->columnsOffset = position;
+
+end:
+        if (entries != NULL)
+                buffer_free(entries);
+        if (ends != NULL)
+                buffer_free(ends);
+        if (text != NULL)
+                buffer_free(text);
+        return result;
+}
+
+int cache_write_columns(FILE *file, const char *path, CacheHeader *header, const char *types)
+{
+        CacheColumn *columns = calloc(header->columns + 1, sizeof(CacheColumn));
+        size_t validitySize = ((header->records + 7) / 8 + CACHE_ALIGNMENT - 1) / CACHE_ALIGNMENT * CACHE_ALIGNMENT;
+        uint8_t *validity = malloc(validitySize + 1);
+        uint64_t position = header->columnsOffset + sizeof(CacheColumn) * header->columns;
+        const CacheEntry *entries;
+        const uint32_t *ends;
+        const char *field;
+        const char *data;
+        int64_t values[CACHE_WRITE_VALUES];
+        size_t count = 0;
+        size_t length;
+        size_t len = 0;
+        size_t start;
+        size_t column;
+        size_t record;
+        int64_t value;
+        double floatValue;
+        int valid;
+        int result = 0;
+
+        if (columns == NULL || validity == NULL) {
+                result = -1;
+                goto end;
+        }
+
+        for (column = 0; column < header->columns; column++) {
+                columns[column].type = types[column] == STRING_TYPE_INT || types[column] == STRING_TYPE_FLOAT ?
+                                       (uint64_t) types[column] : STRING_TYPE_TEXT;
+                if (columns[column].type == STRING_TYPE_TEXT)
+                        continue;
+
+                columns[column].values = position;
+                columns[column].validity = position + sizeof(int64_t) * header->records;
+                position += sizeof(int64_t) * header->records + validitySize;
+        }
+
+        // The fields are converted from the records written so far
+        if (fwrite(columns, sizeof(CacheColumn), header->columns, file) != header->columns ||
+            fflush(file) != 0 || map_file(path, &data, &len) < 0) {
+                result = -1;
+                goto end;
+        }
+
+        entries = (const CacheEntry *) (data + header->entriesOffset);
+        ends = (const uint32_t *) (data + header->endsOffset);
+
+        for (column = 0; column < header->columns && result == 0; column++) {
+                if (columns[column].type == STRING_TYPE_TEXT)
+                        continue;
+
+                memset(validity, 0, validitySize);
+                for (record = 0; record < header->records && result == 0; record++) {
+                        value = 0;
+                        valid = 0;
+
+                        if (record > 0 && entries[record].field + column < entries[record + 1].field) {
+                                start = column > 0 ? ends[entries[record].field + column - 1] : 0;
+                                field = data + header->textOffset + entries[record].text + start;
+                                length = ends[entries[record].field + column] - start;
+
+                                // The values are stored as they would be converted by a batch
+                                if (columns[column].type == STRING_TYPE_INT) {
+                                        valid = string_to_int64(field, length, &value) == 0;
+                                } else {
+                                        valid = string_to_double(field, length, &floatValue) == 0;
+                                        memcpy(&value, &floatValue, sizeof value);
+                                }
+                        }
+
+                        if (!valid)
+                                value = 0;
+                        else
+                                validity[record / 8] |= (uint8_t) (1 << (record % 8));
+
+                        // The values are written a block at a time
+                        values[count++] = value;
+                        if (count == CACHE_WRITE_VALUES || record + 1 == header->records) {
+                                if (fwrite(values, sizeof value, count, file) != count)
+                                        result = -1;
+                                count = 0;
+                        }
+                }
+
+                if (result == 0 && fwrite(validity, 1, validitySize, file) != validitySize)
+                        result = -1;
+        }
+
+        unmap_file(data, len);
+
+end:
+        free(columns);
+        free(validity);
+        return result;
+}
+
+int cache_align(FILE *file, uint64_t *position)
+{
+        static const char zeros[CACHE_ALIGNMENT] = {0};
+        size_t padding = (CACHE_ALIGNMENT - *position % CACHE_ALIGNMENT) % CACHE_ALIGNMENT;
+
+        if (fwrite(zeros, 1, padding, file) != padding)
+                return -1;
+
+        *position += padding;
+        return 0;
+}
+#endif
@@ -0,0 +1,88 @@
+//
+// Created by Davide on 16/10/2026.
+//
+
+#ifndef C_CSV__CACHE_H
+#define C_CSV__CACHE_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "batch.h"
+
+#define CACHE_MAGIC_LENGTH 8
+
+/**
+ * The header of a cache file. It is followed by the text of the fields, by
+ * the entries of the records, by the ends of the fields and by the
+ * descriptions of the columns, each section aligned to CACHE_ALIGNMENT
+ * bytes: the offsets are from the beginning of the file.
+ * The cache holds a csv file of sourceSize bytes, whose first and last
+ * CACHE_HASH_BLOCK bytes hash to sourceHash, parsed with dialect (see
+ * cache_dialect). The file is identified by its inode, by the time of its
+ * last modification and by the time of the last change of its inode, in
+ * nanoseconds: a file rewritten within the same second, or replaced by
+ * another file, does not match
+ */
+typedef struct CacheHeader_s {
+        char magic[CACHE_MAGIC_LENGTH];
+        uint64_t byteOrder;
+        uint64_t dialect;
+        uint64_t sourceSize;
+        uint64_t sourceInode;
+        uint64_t sourceModified;
+        uint64_t sourceChanged;
+        uint64_t sourceHash;
+        uint64_t records;
+        uint64_t fields;
+        uint64_t columns;
+        uint64_t textLength;
+        uint64_t textOffset;
+        uint64_t entriesOffset;
+        uint64_t endsOffset;
+        uint64_t columnsOffset;
+} CacheHeader;
+
+/**
+ * A record of a cached csv file.
+ * field is the index of its first field, text the offset of its first
+ * field in the text of the cache, offset the offset of the record in the
+ * csv file. The fields of a record end where the next record begins
+ */
+typedef struct CacheEntry_s {
+        uint64_t field;
+        uint64_t text;
+        uint64_t offset;
+} CacheEntry;
+
+/**
+ * A csv file stored by the parser in a binary sidecar file (see
+ * csv_reader_set_cache), mapped in memory.
+ * entries holds one entry for each of the records of the file (the header
+ * included) plus one, whose offset is the length of the file.
+ * The fields are stored unescaped and contiguously in text: field i of a
+ * record ends ends[entry->field + i] bytes after the text of the record.
+ * columns holds columnCount typed columns, indexed by the record number:
+ * the values of the columns whose non empty fields are all integers (or
+ * all numbers) are converted when the cache is written, the other columns
+ * have type STRING_TYPE_TEXT and no values
+ */
+typedef struct Cache_s {
+        const char *mapping;
+        size_t mappingLength;
+        size_t records;
+        const CacheEntry *entries;
+        const uint32_t *ends;
+        const char *text;
+        size_t textLength;
+        TypedColumn *columns;
+        size_t columnCount;
+} Cache;
+
+/**
+ * Free a cache, unmapping its file
+ * @param cache the cache
+ */
+void cache_free(Cache *cache);
+
+#endif //C_CSV__CACHE_H
@@ -0,0 +1,155 @@
+//
+// Created by Davide on 16/10/2026.
+//
+
+#include <utils.h>
+#include "parser.h"
+
+#define COLUMN_MAP_LOAD 4
+#define COLUMN_MAP_SEEDS 32
+
+// Private prototypes
+
+/**
+ * Store the names of the header in the table, using its seed
+ * @param map the table
+ * @return 1 if no name has been moved from its slot, 0 otherwise
+ */
+int column_map_fill(ColumnMap *map);
+
+
+// Public Implementation
+
+size_t csv_record_column(const Record *record, const char *name)
+{
+        if (record->columns == NULL)
+                return CSV_NO_COLUMN;
+        return column_map_find(record->columns, name, strlen(name));
+}
+
+size_t csv_record_view_column(const RecordView *record, const char *name)
+{
+        if (record->columns == NULL)
+                return CSV_NO_COLUMN;
+        return column_map_find(record->columns, name, strlen(name));
+}
+
+const char *csv_record_get(const Record *record, const char *name)
+{
+        return csv_record_field(record, csv_record_column(record, name));
+}
+
+const FieldView *csv_record_view_get(const RecordView *record, const char *name)
+{
+        return csv_record_view_field(record, csv_record_view_column(record, name));
+}
+
+inline const char *csv_record_field(const Record *record, size_t column)
+{
+        return column < record->arraySize ? record->fields[column] : NULL;
+}
+
+inline const FieldView *csv_record_view_field(const RecordView *record, size_t column)
+{
+        return column < record->arraySize ? &record->fields[column] : NULL;
+}
+
+ColumnMap *column_map_build(const RecordView *header, const Allocator *allocator)
+{
+        ColumnMap *result = allocator_malloc(allocator, sizeof(ColumnMap));
+        size_t size;
+
+        if (result == NULL)
+                return NULL;
+
+        for (size = 8; size < COLUMN_MAP_LOAD * header->arraySize; size *= 2);
+
+        result->header = header;
+        result->mask = size - 1;
+        result->allocator = allocator;
+        result->slots = allocator_malloc(allocator, sizeof(size_t) * size);
+
+        if (result->slots == NULL) {
+                column_map_free(result);
+                return NULL;
+        }
+
+        // Large headers are unlikely to have a perfect table, any seed works
+        for (result->seed = 0; result->seed < COLUMN_MAP_SEEDS; result->seed++) {
+                if (column_map_fill(result))
+                        break;
+        }
+
+        if (result->seed == COLUMN_MAP_SEEDS) {
+                result->seed = 0;
+                column_map_fill(result);
+        }
+
+        return result;
+}
+
+size_t column_map_find(const ColumnMap *map, const char *name, size_t len)
+{
+        size_t slot = (size_t) string_hash(name, len, map->seed) & map->mask;
+        const FieldView *field;
+        size_t column;
+
+        for (;;) {
+                column = map->slots[slot];
+                if (column == CSV_NO_COLUMN)
+                        return CSV_NO_COLUMN;
+
+                field = &map->header->fields[column];
+                if (field->length == len && memcmp(field->data, name, len) == 0)
+                        return column;
+
+                // In a perfect table the slot of a name holds the name itself
+                if (map->perfect)
+                        return CSV_NO_COLUMN;
+
+                slot = (slot + 1) & map->mask;
+        }
+}
+
+void column_map_free(ColumnMap *map)
+{
+        if (map == NULL)
+                return;
+
+        allocator_free(map->allocator, map->slots);
+        allocator_free(map->allocator, map);
+}
+
+
+// Private Implementation
+
+int column_map_fill(ColumnMap *map)
+{
+        const FieldView *field;
+        size_t slot;
+        size_t i;
+        int result = 1;
+
+        for (i = 0; i <= map->mask; i++) {
+                map->slots[i] = CSV_NO_COLUMN;
+        }
+
+        // Duplicated names are looked up while the table is being filled
+        map->perfect = 0;
+
+        for (i = 0; i < map->header->arraySize; i++) {
+                field = &map->header->fields[i];
+                if (column_map_find(map, field->data, field->length) != CSV_NO_COLUMN)
+                        continue;
+
+                slot = (size_t) string_hash(field->data, field->length, map->seed) & map->mask;
+                if (map->slots[slot] != CSV_NO_COLUMN)
+                        result = 0;
+                while (map->slots[slot] != CSV_NO_COLUMN)
+                        slot = (slot + 1) & map->mask;
+                map->slots[slot] = i;
+        }
+
+        map->perfect = result;
+        return result;
+}
@@ -0,0 +1,56 @@
+//
+// Created by Davide on 16/10/2026.
+//
+
+#ifndef C_CSV__COLUMNS_H
+#define C_CSV__COLUMNS_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "record.h"
+
+/**
+ * A hash table from the names of the header to the index of their column.
+ * slots holds mask + 1 column indexes, CSV_NO_COLUMN for the empty slots;
+ * a name is stored in the slot given by its hash, or in the next empty one.
+ * The seed of the hash is chosen so that, if possible, no name is moved
+ * from its slot: then the table is perfect and a lookup reads one slot.
+ * The names are those of header, which must outlive the table.
+ * If a name appears more than once, the first column is found
+ */
+typedef struct ColumnMap_s {
+        const RecordView *header;
+        size_t *slots;
+        size_t mask;
+        uint64_t seed;
+        int perfect;
+        const Allocator *allocator;
+} ColumnMap;
+
+/**
+ * Build the table of the names of a header
+ * @param header the header, it is not copied
+ * @param allocator the allocator, if NULL malloc is used. It must outlive
+ *                  the table
+ * @return the table, or NULL on error
+ */
+ColumnMap *column_map_build(const RecordView *header, const Allocator *allocator);
+
+/**
+ * Find the column of a name
+ * @param map the table
+ * @param name the name, it may not be null terminated
+ * @param len length of the name
+ * @return the index of the column, CSV_NO_COLUMN if the header does not
+ *         contain the name
+ */
+size_t column_map_find(const ColumnMap *map, const char *name, size_t len);
+
+/**
+ * Free a table
+ * @param map the table, it may be NULL
+ */
+void column_map_free(ColumnMap *map);
+
+#endif //C_CSV__COLUMNS_H
@@ -2,111 +2,9 @@
 // Created by Davide on 29/10/2021.
 //
 
-#include <ctype.h>
-#include "../include/csv.h"
-
-#define BUFFER_SIZE 2
-#define RECORD_SIZE 2
-
-#define HEADER_FOUND 0X01
-#define PROCESSED_ALL_RECORDS 0x02
-#define ESCAPING 0x04
-#define DQUOTE_FOUND 0x08
-
-#define DQUOTE 34
-#define NEW_LINE 10
-#define CARRIAGE_RETURN 13
-#define COMMA 44
-
-#define is_line_ending(c) ((c) == NEW_LINE || (c) == EOF)
-#define is_carriage_return(c) ((c) == CARRIAGE_RETURN)
-#define is_separator(c) ((c) == COMMA)
-#define is_dquote(c) ((c) == DQUOTE)
-
-/**
- * This structure encapsulate some data
- * structures used throughout the parsing process
- *
- * @param buffer a dynamic string which temporarily stores the field the parser
- *               is currently reading
-
- * @param currentRecord A dynamic array of strings.
- *                      Once a CSV record has been completely read by the
- *                      parser, this array contains the fields of that record.
- *                      This pointer is then passed as an argument to the
- *                      recordCallback function to process its data.
- *
- * @param header A dynamic array of strings which stores the fields
- *               of the CSV header
- *
- * @param flags The first five bits holds some information on the parser state.
- *               - HEADER_FOUND: The first record (header) has been processed.
- *               - ESCAPING: The character that the parser is reading is
- *                           enclosed in double quotes and must be escaped
- *                           accordingly to the CSV syntax;
- *               - ONE_DQUOTE_FOUND: The parser encountered one double quote
- *                                   in an escaped sequence;
- *               - TWO_DQUOTES_FOUND: Two consecutive double quotes are found
- *                                    in an escaped sequence. When this happens,
- *                                    the final parsed field will contain a
- *                                    single double quote character.
- *                - END_OF_FILE: 1 if EOF is encountered
- *              Remaining bits are currently unused.
- *
- * @param currentCsv FILE * pointer of the CSV file to parse
- * @param nextchr The current character
- * @param tempBuffer Contains the content of the file
- * @param bufPos store the current position in the buffer
- */
-typedef struct {
-        FILE *currentCsv;
-        Buffer *buffer;
-        Record *record;
-        Record *header;
-
-        int bufferPosition;
-        int lastSeparator;
-
-        Buffer *secondaryBuffer;
-        int flags;
-} ParsingContext;
-
-
-// Private prototypes
-
-/**
- * Execute the callback function for the currently stored record,
- * then resets the record buffer
- * @param reader the CsvReader
- * @param pc the current parsing context
- */
-void emit_record(CsvReader *reader, ParsingContext *pc);
-
-/**
- * Takes the buffer stored in the parsing context and stores it
- * as a field in the record data structure, then resets the buffer
- * @param reader the CsvReader
- * @param pc the current parsing context
- */
-void emit_field(ParsingContext *pc);
-
-/**
- * Move to the next character
- * @param pc
- */
-void get_next_character(ParsingContext *pc);
-/**
- * Move to the next line
- * @param pc parsing context
- */
-void get_next_line(ParsingContext *pc);
-
-
-void start_escaped_sequence(CsvReader *reader, ParsingContext *pc);
-void end_escaped_sequence(CsvReader *reader, ParsingContext *pc);
-void get_escaped_sequence(CsvReader *reader, ParsingContext *pc);
-char current_char(ParsingContext *pc);
-char lookahead(ParsingContext *pc);
+#include <errno.h>
+#include <utils.h>
+#include "parser.h"
 
 
 // Public Implementation
@@ -119,180 +17,1208 @@ CsvReader *csv_reader_alloc(void (*headerCallback)(void *, Record *),
         if (result == NULL)
                 return NULL;
         result->context = context;
+        result->blockSize = BLOCK_SIZE;
+        result->readAhead = 0;
+        result->allocator.alloc = NULL;
+        result->allocator.free = NULL;
+        result->allocator.context = NULL;
         result->header = headerCallback;
         result->record = recordCallback;
+        result->headerView = NULL;
+        result->recordView = NULL;
+        result->batch = NULL;
+        result->schema = NULL;
+        result->batchSize = BATCH_SIZE;
+        result->recordBatch = NULL;
+        result->recordBatchSize = BATCH_SIZE;
+        result->selection = NULL;
+        result->selectionCount = 0;
+        result->predicates = NULL;
+        result->predicateCount = 0;
+        result->interned = NULL;
+        result->internedCount = 0;
+        result->index = NULL;
+        result->startRecord = 0;
+        result->statsTiming = 0;
+        result->feed = NULL;
+        result->control = 0;
+        result->offset = 0;
+        result->paused = NULL;
+        result->cache = 0;
+        dialect_init(&result->dialect, ',');
+        csv_reader_stats_reset(result);
+        return result;
+}
+
+CsvReader *csv_reader_alloc_view(void (*headerCallback)(void *, RecordView *),
+                                 void (*recordCallback)(void *, RecordView *, RecordView *),
+                                 void *context)
+{
+        CsvReader *result = csv_reader_alloc(NULL, NULL, context);
+        if (result == NULL)
+                return NULL;
+        result->headerView = headerCallback;
+        result->recordView = recordCallback;
         return result;
 }
 
-inline void csv_reader_free(CsvReader *reader) {
+int csv_reader_set_allocator(CsvReader *reader,
+                             void *(*alloc)(void *, size_t),
+                             void (*free)(void *, void *),
+                             void *context)
+{
+        if (check_reader_idle(reader) < 0)
+                return -1;
+
+        reader->allocator.alloc = alloc;
+        reader->allocator.free = free;
+        reader->allocator.context = context;
+        return 0;
+}
+
+void csv_reader_set_batch(CsvReader *reader,
+                          void (*batchCallback)(void *, RecordView *, Batch *),
+                          const Schema *schema,
+                          size_t batchSize)
+{
+        reader->batch = batchCallback;
+        reader->schema = schema;
+        reader->batchSize = batchSize > 0 ? batchSize : BATCH_SIZE;
+}
+
+void csv_reader_set_record_batch(CsvReader *reader,
+                                 void (*batchCallback)(void *, RecordView *, RecordBatch *),
+                                 size_t batchSize)
+{
+        reader->recordBatch = batchCallback;
+        reader->recordBatchSize = batchSize > 0 ? batchSize : BATCH_SIZE;
+}
+
+int csv_reader_select_column(CsvReader *reader, const char *name)
+{
+        char *copy = string_duplicate(name, strlen(name));
+
+        if (copy == NULL)
+                return -1;
+
+        if (csv_reader_select_index(reader, 0) < 0) {
+                free(copy);
+                return -1;
+        }
+
+        reader->selection[reader->selectionCount - 1].name = copy;
+        return 0;
+}
+
+int csv_reader_select_index(CsvReader *reader, size_t index)
+{
+        ColumnSelection *selection = realloc(reader->selection,
+                                             sizeof(ColumnSelection) * (reader->selectionCount + 1));
+
+        if (selection == NULL)
+                return -1;
+
+        selection[reader->selectionCount].name = NULL;
+        selection[reader->selectionCount].index = index;
+        reader->selection = selection;
+        reader->selectionCount += 1;
+        return 0;
+}
+
+void csv_reader_select_all(CsvReader *reader)
+{
+        size_t i;
+
+        for (i = 0; i < reader->selectionCount; i++) {
+                free(reader->selection[i].name);
+        }
+
+        free(reader->selection);
+        reader->selection = NULL;
+        reader->selectionCount = 0;
+}
+
+void csv_reader_stats(const CsvReader *reader, CsvStats *stats)
+{
+        *stats = reader->stats;
+}
+
+void csv_reader_stats_reset(CsvReader *reader)
+{
+        memset(&reader->stats, 0, sizeof reader->stats);
+}
+
+void csv_reader_stats_timing(CsvReader *reader, int enabled)
+{
+        reader->statsTiming = enabled != 0;
+}
+
+void csv_reader_set_block_size(CsvReader *reader, size_t blockSize)
+{
+        reader->blockSize = blockSize > 0 ? blockSize : BLOCK_SIZE;
+}
+
+void csv_reader_set_read_ahead(CsvReader *reader, size_t blocks)
+{
+        reader->readAhead = blocks;
+}
+
+void csv_reader_free(CsvReader *reader) {
+        if (reader->feed != NULL) {
+                parsing_context_destroy(reader->feed);
+                free(reader->feed);
+                reader->feed = NULL;
+        }
+        discard_paused(reader);
+        csv_reader_select_all(reader);
+        csv_reader_filter_clear(reader);
+        csv_reader_intern_clear(reader);
         free(reader);
 }
 
-void csv_reader_parse(CsvReader *reader, FILE *csvFile)
+int csv_reader_feed(CsvReader *reader, const char *data, size_t len)
 {
-        ParsingContext pc;
+        ParsingContext *pc = reader->feed;
+        Buffer *buffer;
 
-        pc.currentCsv = csvFile;
+        if (pc == NULL) {
+                pc = parsing_context_alloc(reader);
+                pc->flags |= FEEDING;
+                parsing_context_init_stream(reader, pc);
+                reader->feed = pc;
+        }
 
-        pc.buffer = buffer_alloc(BUFFER_SIZE);
-        pc.record = record_alloc(RECORD_SIZE);
-        pc.bufferPosition = 0;
-        pc.secondaryBuffer = NULL;
-        pc.header = NULL;
-        pc.flags = 0x00;
+        if (pc->flags & STOPPED)
+                return CSV_STOPPED;
 
-        get_next_line(&pc);
+        buffer = pc->buffer;
 
-        do {
-                if (is_separator(pc.buffer->buffer[pc.bufferPosition])) {
-                        emit_field(&pc);
-                        pc.lastSeparator = pc.bufferPosition + 1;
-                } else if (is_line_ending(pc.buffer->buffer[pc.bufferPosition]) || \
-                          (is_carriage_return(pc.buffer->buffer[pc.bufferPosition]) && is_line_ending(pc.buffer->buffer[pc.bufferPosition+1])) \
-                          ) {
-                        emit_field(&pc);
-                        emit_record(reader, &pc);
-                        continue;
-                } else if (is_dquote(pc.buffer->buffer[pc.bufferPosition])) {
-                        start_escaped_sequence(reader, &pc);
-                        continue;
-                }
+        // Only the incomplete record at the end of the previous data is kept
+        if (!(pc->flags & IN_RECORD))
+                pc->recordStart = pc->bufferPosition < pc->length ? pc->bufferPosition : pc->length;
+        compact_buffer(pc);
 
-                get_next_character(&pc);
-        } while (!(pc.flags & PROCESSED_ALL_RECORDS));
+        if (buffer_append_str(buffer, data, len) == NULL || buffer_reserve(buffer, pc->padding) == NULL) {
+                perror("Cannot alloc memory buffer for csv parsing");
+                abort();
+        }
+
+        pc->data = buffer->buffer;
+        pc->length = buffer->stringLength;
+        pc->flags &= ~WAITING_DATA;
 
-        buffer_free(pc.buffer);
-        record_free(pc.record);
+        return parse_records(reader, pc);
+}
 
-        if (pc.flags & HEADER_FOUND) {
-                record_free(pc.header);
+int csv_reader_finish(CsvReader *reader)
+{
+        ParsingContext *pc = reader->feed;
+        int status = CSV_STOPPED;
+
+        if (pc == NULL)
+                return CSV_END;
+
+        // The statistics of a stopped parsing have already been merged
+        if (!(pc->flags & STOPPED)) {
+                pc->flags |= FEED_FINISHED;
+                pc->flags &= ~WAITING_DATA;
+
+                status = parse_records(reader, pc);
+                if (status == CSV_PAUSED)
+                        return status;
         }
 
-        if (pc.secondaryBuffer != NULL) {
-                buffer_free(pc.secondaryBuffer);
+        parsing_context_destroy(pc);
+        free(pc);
+        reader->feed = NULL;
+        return status;
+}
+
+int csv_reader_parse(CsvReader *reader, FILE *csvFile)
+{
+        ParsingContext *pc = parsing_context_alloc(reader);
+
+        pc->currentCsv = csvFile;
+        parsing_context_init_stream(reader, pc);
+        return run_parsing(reader, pc);
+}
+
+#ifdef CSV_POSIX
+int csv_reader_parse_fd(CsvReader *reader, int fd)
+{
+        ParsingContext *pc = parsing_context_alloc(reader);
+
+        pc->fd = fd;
+        parsing_context_init_stream(reader, pc);
+        return run_parsing(reader, pc);
+}
+#endif
+
+void csv_reader_stop(CsvReader *reader)
+{
+        reader->control |= CONTROL_STOP;
+        discard_paused(reader);
+}
+
+void csv_reader_skip_record(CsvReader *reader)
+{
+        reader->control |= CONTROL_SKIP;
+}
+
+void csv_reader_pause(CsvReader *reader)
+{
+        reader->control |= CONTROL_PAUSE;
+}
+
+int csv_reader_resume(CsvReader *reader)
+{
+        ParsingContext *pc = reader->paused;
+
+        if (pc != NULL) {
+                reader->paused = NULL;
+                return run_parsing(reader, pc);
         }
+
+        // A paused feed is kept in the reader, waiting for more input
+        if (reader->feed != NULL && !(reader->feed->flags & STOPPED))
+                return parse_records(reader, reader->feed);
+
+        return CSV_END;
 }
 
-void get_next_character(ParsingContext *pc)
+inline size_t csv_reader_offset(const CsvReader *reader)
 {
-        pc->bufferPosition+=1;
+        return reader->offset;
+}
 
-        if (pc->bufferPosition >= (pc->buffer->bufferLength - 1)) {
-                pc->buffer->bufferLength *= 2;
-                pc->buffer->buffer = realloc(pc->buffer->buffer, sizeof(char) * pc->buffer->bufferLength);
+int parse_records(CsvReader *reader, ParsingContext *pc)
+{
+        reader->control = 0;
 
-                if (!pc->buffer->buffer) {
-                        perror("Cannot alloc memory buffer for csv parsing");
-                        abort();
-                }
+        while (!(reader->control & (CONTROL_STOP | CONTROL_PAUSE)) && get_next_record(pc)) {
+                emit_record(reader, pc);
+                // A skip request holds for the record just delivered
+                reader->control &= ~CONTROL_SKIP;
+        }
 
-                if(!fgets(pc->buffer->buffer + pc->bufferPosition,
-                          pc->buffer->bufferLength - pc->bufferPosition,
-                          pc->currentCsv)) {
-                        fprintf(stderr, "Error reading additional data from CSV\n");
-                }
+        // The data of a cache is not the text of the input
+        if (pc->cache != NULL)
+                reader->offset = pc->cache->entries[pc->cacheRecord].offset;
+        else
+                reader->offset = pc->consumed + (pc->bufferPosition < pc->length ? pc->bufferPosition : pc->length);
+
+        if (reader->control & CONTROL_STOP) {
+                // The records delivered before the stop complete their batches
+                end_parsing(reader, pc);
+                pc->flags |= STOPPED;
+                return CSV_STOPPED;
+        }
+
+        if (reader->control & CONTROL_PAUSE)
+                return CSV_PAUSED;
+
+        // Fed input ends only when csv_reader_finish is invoked
+        if (!(pc->flags & FEEDING) || (pc->flags & FEED_FINISHED))
+                end_parsing(reader, pc);
+        return CSV_END;
+}
+
+int run_parsing(CsvReader *reader, ParsingContext *pc)
+{
+        int status;
+
+        // The index is only used to reach the starting record, after the header
+        if (reader->startRecord > 0 && !(pc->flags & HEADER_FOUND) && check_index(pc, reader->index) < 0) {
+                parsing_context_destroy(pc);
+                free(pc);
+                return -1;
+        }
+
+        status = parse_records(reader, pc);
+
+        if (status == CSV_PAUSED) {
+                reader->paused = pc;
+                return status;
+        }
+
+        parsing_context_destroy(pc);
+        free(pc);
+        return status;
+}
+
+int check_reader_idle(const CsvReader *reader)
+{
+        if (reader->paused != NULL || reader->feed != NULL) {
+                errno = EBUSY;
+                return -1;
+        }
+        return 0;
+}
+
+void discard_paused(CsvReader *reader)
+{
+        ParsingContext *pc = reader->paused;
+
+        if (pc == NULL)
+                return;
+
+        merge_stats(reader, pc);
+        parsing_context_destroy(pc);
+        free(pc);
+        reader->paused = NULL;
+}
+
+void parsing_context_init_stream(CsvReader *reader, ParsingContext *pc)
+{
+        pc->blockSize = reader->blockSize;
+        pc->padding = SCAN_BLOCK_SIZE;
+        pc->buffer = buffer_alloc_with(pc->blockSize + pc->padding + 1, pc->allocator);
+
+        if (pc->buffer == NULL) {
+                perror("Cannot alloc memory buffer for csv parsing");
+                abort();
+        }
+
+        pc->data = pc->buffer->buffer;
+
+        // Fed input is never read from a stream
+        if (reader->readAhead > 0 && !(pc->flags & FEEDING))
+                pc->prefetch = prefetch_alloc(pc, reader->readAhead);
+}
+
+int csv_reader_parse_memory(CsvReader *reader, const char *data, size_t len)
+{
+        ParsingContext *pc = parsing_context_alloc(reader);
+
+        pc->data = data;
+        pc->length = len;
+        return run_parsing(reader, pc);
+}
+
+int csv_reader_parse_path(CsvReader *reader, const char *path)
+{
+        ParsingContext *pc;
+        Cache *cache = reader->cache ? load_cache(reader, path) : NULL;
+#ifdef CSV_POSIX
+        const char *data;
+        size_t len;
+#endif
+
+        if (cache != NULL) {
+                pc = parsing_context_alloc(reader);
+                set_cache(pc, cache);
+                return run_parsing(reader, pc);
+        }
+
+#ifdef CSV_POSIX
+        if (map_file(path, &data, &len) < 0)
+                return -1;
+
+        pc = parsing_context_alloc(reader);
+        pc->data = data;
+        pc->length = len;
+#else
+        FILE *csvFile = fopen(path, "r");
+
+        if (csvFile == NULL)
+                return -1;
+
+        pc = parsing_context_alloc(reader);
+        pc->currentCsv = csvFile;
+        parsing_context_init_stream(reader, pc);
+#endif
+
+        // The file is closed with the context, which a pause keeps alive
+        pc->flags |= OWNS_INPUT;
+        return run_parsing(reader, pc);
+}
+
+#ifdef CSV_POSIX
+int map_file(const char *path, const char **data, size_t *len)
+{
+        struct stat info;
+        void *mapping;
+        int fd = open(path, O_RDONLY);
+
+        if (fd < 0)
+                return -1;
+
+        if (fstat(fd, &info) < 0) {
+                close(fd);
+                return -1;
+        }
+
+        if (info.st_size == 0) {
+                close(fd);
+                *data = "";
+                *len = 0;
+                return 0;
         }
+
+        mapping = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+
+        if (mapping == MAP_FAILED)
+                return -1;
+
+        madvise(mapping, (size_t) info.st_size, MADV_SEQUENTIAL);
+        *data = mapping;
+        *len = (size_t) info.st_size;
+        return 0;
+}
+
+void unmap_file(const char *data, size_t len)
+{
+        if (len > 0)
+                munmap((void *) data, len);
 }
+#endif
 
-inline void get_next_line(ParsingContext *pc)
+void parsing_context_init(CsvReader *reader, ParsingContext *pc)
 {
+        pc->currentCsv = NULL;
+        pc->fd = -1;
+        pc->allocator = reader->allocator.alloc != NULL ? &reader->allocator : NULL;
+        pc->data = NULL;
+        pc->length = 0;
+        pc->padding = 0;
+        pc->buffer = NULL;
+        pc->blockSize = 0;
+        pc->prefetch = NULL;
+
+        pc->record = record_alloc_with(RECORD_SIZE, pc->allocator);
+        pc->header = record_alloc_with(RECORD_SIZE, pc->allocator);
+        pc->view = record_view_alloc(RECORD_SIZE);
+        pc->headerView = record_view_alloc(RECORD_SIZE);
+        pc->columns = NULL;
+        pc->dictionaries = NULL;
+        pc->dictionaryCount = 0;
+        pc->fields = allocator_malloc(pc->allocator, sizeof(FieldSpan) * RECORD_SIZE);
+        pc->fieldCount = 0;
+        pc->fieldSize = RECORD_SIZE;
+        pc->projection = NULL;
+        pc->projectionColumns = 0;
+        pc->projectionCount = 0;
+        pc->column = 0;
+        pc->filters = NULL;
+        pc->filterCount = 0;
+        pc->consumed = 0;
+        pc->bodyStart = 0;
+        pc->recordStart = 0;
+        memset(&pc->stats, 0, sizeof pc->stats);
+#ifdef CSV_STATS
+        pc->startTime = reader->statsTiming ? stats_clock() : 0;
+#endif
+        pc->fieldStart = 0;
         pc->bufferPosition = 0;
-        pc->lastSeparator = 0;
+        pc->escapedLength = 0;
+        pc->scanBlock = NO_SCAN_BLOCK;
+        pc->dialect = reader->dialect;
+        pc->dialectKind = dialect_kind(&reader->dialect);
+        pc->scanChars.separator = reader->dialect.delimiter;
+        pc->scanChars.quote = reader->dialect.quote;
+        pc->scanChars.newLine = dialect_new_line(&reader->dialect);
+        pc->scanChars.escape = reader->dialect.escape;
+        pc->secondaryBuffer = NULL;
+        pc->batch = NULL;
+        pc->recordBatch = NULL;
+        pc->flags = 0x00;
+        pc->cache = NULL;
+        pc->cacheRecord = 0;
+        pc->typedColumns = NULL;
+        pc->typedCount = 0;
+
+        if (!pc->record || !pc->header || !pc->view || !pc->headerView || !pc->fields) {
+                perror("Cannot alloc memory buffer for csv parsing");
+                abort();
+        }
+}
+
+ParsingContext *parsing_context_alloc(CsvReader *reader)
+{
+        ParsingContext *pc = malloc(sizeof(ParsingContext));
+
+        if (pc == NULL) {
+                perror("Cannot alloc memory buffer for csv parsing");
+                abort();
+        }
+
+        discard_paused(reader);
+        parsing_context_init(reader, pc);
+        return pc;
+}
+
+void parsing_context_destroy(ParsingContext *pc)
+{
+        // The thread may be reading in the buffers of the context
+        prefetch_free(pc->prefetch);
+
+        if (pc->buffer != NULL) {
+                buffer_free(pc->buffer);
+        }
+
+        record_free(pc->record);
+        record_free(pc->header);
+        record_view_free(pc->view);
+        record_view_free(pc->headerView);
+        column_map_free(pc->columns);
+        allocator_free(pc->allocator, pc->dictionaries);
+        allocator_free(pc->allocator, pc->fields);
+        allocator_free(pc->allocator, pc->projection);
+        allocator_free(pc->allocator, pc->filters);
+
+        if (pc->secondaryBuffer != NULL) {
+                buffer_free(pc->secondaryBuffer);
+        }
+
+        if (pc->batch != NULL) {
+                batch_free(pc->batch);
+        }
+
+        if (pc->recordBatch != NULL) {
+                record_batch_free(pc->recordBatch);
+        }
+
+        if (pc->cache != NULL) {
+                cache_free(pc->cache);
+                allocator_free(pc->allocator, pc->typedColumns);
+        }
+
+        if (pc->flags & OWNS_INPUT) {
+                if (pc->currentCsv != NULL)
+                        fclose(pc->currentCsv);
+#ifdef CSV_POSIX
+                else
+                        unmap_file(pc->data, pc->length);
+#endif
+        }
+}
+
+size_t fill_buffer(ParsingContext *pc)
+{
+        Buffer *buffer = pc->buffer;
+        size_t available;
+        size_t n;
+
+        // Input in memory is all available since the beginning
+        if (buffer == NULL || (pc->flags & PROCESSED_ALL_RECORDS))
+                return 0;
+
+        if (pc->flags & FEEDING) {
+                if (!(pc->flags & FEED_FINISHED))
+                        pc->flags |= WAITING_DATA;
+                return 0;
+        }
+
+        if (pc->prefetch != NULL)
+                return prefetch_fill(pc);
+
+        compact_buffer(pc);
 
-        if (!fgets(pc->buffer->buffer, pc->buffer->bufferLength, pc->currentCsv)) {
-                if (feof(pc->currentCsv)) {
-                        pc->flags |= PROCESSED_ALL_RECORDS;
-                } else {
+        // Records longer than a block make the buffer grow
+        available = buffer->bufferLength;
+        if (buffer_reserve(buffer, pc->blockSize + pc->padding) == NULL) {
+                perror("Cannot alloc memory buffer for csv parsing");
+                abort();
+        }
+        stats_add(pc, bufferGrowths, buffer->bufferLength != available);
+
+        available = buffer->bufferLength - buffer->stringLength - pc->padding - 1;
+        n = read_stream(pc, buffer->buffer + buffer->stringLength, available);
+
+        if (n == 0)
+                pc->flags |= PROCESSED_ALL_RECORDS;
+
+        buffer->stringLength += n;
+        pc->data = buffer->buffer;
+        pc->length = buffer->stringLength;
+        return n;
+}
+
+void compact_buffer(ParsingContext *pc)
+{
+        Buffer *buffer = pc->buffer;
+        size_t shift = pc->recordStart;
+
+        if (shift > 0) {
+                memmove(buffer->buffer, buffer->buffer + shift, buffer->stringLength - shift);
+                buffer->stringLength -= shift;
+                pc->length = buffer->stringLength;
+        }
+
+        shift_offsets(pc, shift);
+}
+
+void shift_offsets(ParsingContext *pc, size_t shift)
+{
+        size_t i;
+
+        if (shift > 0) {
+                pc->consumed += shift;
+                pc->recordStart -= shift;
+                pc->fieldStart -= shift;
+                pc->bufferPosition -= shift;
+
+                for (i = 0; i < pc->fieldCount; i++) {
+                        if (!pc->fields[i].escaped)
+                                pc->fields[i].offset -= shift;
+                }
+        }
+
+        // Blocks are classified again since their alignment has changed
+        pc->scanBlock = NO_SCAN_BLOCK;
+}
+
+size_t read_stream(ParsingContext *pc, char *destination, size_t len)
+{
+        size_t n;
+#ifdef CSV_POSIX
+        ssize_t result;
+
+        if (pc->fd >= 0) {
+                do {
+                        result = read(pc->fd, destination, len);
+                } while (result < 0 && errno == EINTR);
+
+                if (result < 0) {
                         perror("Error while reading input CSV");
                         abort();
                 }
+                return (size_t) result;
+        }
+#endif
+
+        n = fread(destination, 1, len, pc->currentCsv);
+        if (n == 0 && ferror(pc->currentCsv)) {
+                perror("Error while reading input CSV");
+                abort();
+        }
+        return n;
+}
+
+// Parsers of the dialects: the characters of the common ones are constants,
+// any other dialect is read from the parsing context at runtime
+
+#define DIALECT_NAME(name) name##_csv
+#define DIALECT_SEPARATOR(pc) ','
+#define DIALECT_SCAN scan_block_csv
+#include "parser_dialect.h"
+
+#define DIALECT_NAME(name) name##_tsv
+#define DIALECT_SEPARATOR(pc) '\t'
+#define DIALECT_SCAN scan_block_tsv
+#include "parser_dialect.h"
+
+#define DIALECT_NAME(name) name##_psv
+#define DIALECT_SEPARATOR(pc) '|'
+#define DIALECT_SCAN scan_block_psv
+#include "parser_dialect.h"
+
+#define DIALECT_NAME(name) name##_generic
+#define DIALECT_SEPARATOR(pc) ((pc)->dialect.delimiter)
+#define DIALECT_QUOTE(pc) ((pc)->dialect.quote)
+#define DIALECT_ESCAPE(pc) ((pc)->dialect.escape)
+#define DIALECT_LINE_ENDING(pc) ((pc)->dialect.lineEnding)
+#define DIALECT_TRIM(pc) ((pc)->dialect.trim)
+#define DIALECT_SCAN scan_block
+#include "parser_dialect.h"
+
+int get_next_record(ParsingContext *pc)
+{
+        if (pc->cache != NULL)
+                return get_cached_record(pc);
+
+        switch (pc->dialectKind) {
+        case DIALECT_KIND_CSV:
+                return get_next_record_csv(pc);
+        case DIALECT_KIND_TSV:
+                return get_next_record_tsv(pc);
+        case DIALECT_KIND_PSV:
+                return get_next_record_psv(pc);
+        default:
+                return get_next_record_generic(pc);
+        }
+}
+
+void emit_field(ParsingContext *pc, size_t offset, size_t length, char escaped)
+{
+        size_t slot = pc->fieldCount;
+        size_t column = pc->column;
+
+        pc->column += 1;
+        stats_add(pc, fields, 1);
+
+        if (pc->filterCount > 0) {
+                if (!(pc->flags & REJECTED))
+                        filter_field(pc, column, (escaped ? pc->secondaryBuffer->buffer : pc->data) + offset, length);
+                if (pc->flags & REJECTED)
+                        return;
+        }
+
+        if (pc->projection != NULL) {
+                slot = column < pc->projectionColumns ? pc->projection[column] : NOT_SELECTED;
+                if (slot == NOT_SELECTED)
+                        return;
+        } else if (pc->fieldCount >= pc->fieldSize) {
+                FieldSpan *newFields = allocator_realloc(pc->allocator, pc->fields,
+                                                         pc->fieldSize * sizeof *pc->fields,
+                                                         2 * pc->fieldSize * sizeof *pc->fields);
+                if (newFields == NULL) {
+                        perror("Cannot alloc memory buffer for csv parsing");
+                        abort();
+                }
+                pc->fields = newFields;
+                pc->fieldSize *= 2;
         }
+
+        pc->fields[slot].offset = offset;
+        pc->fields[slot].length = length;
+        pc->fields[slot].escaped = escaped;
+
+        if (pc->projection == NULL)
+                pc->fieldCount += 1;
 }
 
+void resolve_fields(ParsingContext *pc, RecordView *view)
+{
+        size_t i;
+        const char *base;
+
+        record_view_reset(view);
+        for (i = 0; i < pc->fieldCount; i++) {
+                base = pc->fields[i].escaped ? pc->secondaryBuffer->buffer : pc->data;
+                record_view_append(view, base + pc->fields[i].offset, pc->fields[i].length);
+        }
+}
 
 void emit_record(CsvReader *reader, ParsingContext *pc)
 {
-        if (pc->flags & HEADER_FOUND) {
-                if (reader->record != NULL)
-                        reader->record(reader->context, pc->header, pc->record);
-                record_reset(pc->record);
-        } else {
+        resolve_fields(pc, pc->view);
+        emit_view(reader, pc);
+}
+
+void emit_view(CsvReader *reader, ParsingContext *pc)
+{
+        if (!(pc->flags & HEADER_FOUND)) {
+                resolve_header(reader, pc);
+
                 if (reader->header != NULL)
-                        reader->header(reader->context, pc->record);
-                pc->flags |= HEADER_FOUND;
-                pc->header = pc->record;
-                pc->record = record_alloc(pc->header->arraySize);
+                        timed_callback(reader, pc, reader->header(reader->context, pc->header));
+                if (reader->headerView != NULL && !(reader->control & CONTROL_STOP))
+                        timed_callback(reader, pc, reader->headerView(reader->context, pc->headerView));
+
+                apply_seek(reader, pc);
+                return;
+        }
+
+        if (reader->recordView != NULL)
+                timed_callback(reader, pc, reader->recordView(reader->context, pc->headerView, pc->view));
+
+        if (reader->record != NULL && is_delivered(reader)) {
+                build_record(pc);
+                timed_callback(reader, pc, reader->record(reader->context, pc->header, pc->record));
+                record_reset(pc->record);
+        }
+
+        if (reader->batch != NULL && is_delivered(reader))
+                append_batch(reader, pc);
+
+        if (reader->recordBatch != NULL && is_delivered(reader))
+                append_record_batch(reader, pc);
+}
+
+void append_batch(CsvReader *reader, ParsingContext *pc)
+{
+        Schema *schema;
+
+        if (pc->batch == NULL) {
+                // Without a schema every column of the header is a string
+                schema = reader->schema == NULL ? schema_alloc(pc->headerView) : NULL;
+                if (reader->schema != NULL || schema != NULL)
+                        pc->batch = batch_alloc(reader->schema != NULL ? reader->schema : schema,
+                                                reader->batchSize, pc->allocator);
+                schema_free(schema);
+        }
+
+        // The numeric columns of a cache are converted in advance
+        if (pc->cache != NULL && pc->typedColumns == NULL)
+                resolve_typed_columns(pc);
+
+        if (pc->batch == NULL || batch_append_typed(pc->batch, pc->view, pc->typedColumns, pc->typedCount,
+                                                    pc->cacheRecord - 1) < 0) {
+                perror("Cannot alloc memory buffer for csv parsing");
+                abort();
+        }
+
+        if (pc->batch->length == pc->batch->capacity) {
+                timed_callback(reader, pc, reader->batch(reader->context, pc->headerView, pc->batch));
+                batch_reset(pc->batch);
+        }
+}
+
+void append_record_batch(CsvReader *reader, ParsingContext *pc)
+{
+        if (pc->recordBatch == NULL) {
+                pc->recordBatch = record_batch_alloc(reader->recordBatchSize, pc->allocator);
+                if (pc->recordBatch != NULL)
+                        pc->recordBatch->columns = pc->columns;
+        }
+
+        if (pc->recordBatch == NULL || record_batch_append(pc->recordBatch, pc->view) < 0) {
+                perror("Cannot alloc memory buffer for csv parsing");
+                abort();
+        }
+
+        if (pc->recordBatch->length == pc->recordBatch->capacity) {
+                timed_callback(reader, pc, reader->recordBatch(reader->context, pc->headerView, pc->recordBatch));
+                record_batch_reset(pc->recordBatch);
+        }
+}
+
+void flush_batch(CsvReader *reader, ParsingContext *pc)
+{
+        if (pc->batch != NULL && pc->batch->length > 0) {
+                timed_callback(reader, pc, reader->batch(reader->context, pc->headerView, pc->batch));
+                batch_reset(pc->batch);
+        }
+
+        if (pc->recordBatch != NULL && pc->recordBatch->length > 0) {
+                timed_callback(reader, pc, reader->recordBatch(reader->context, pc->headerView, pc->recordBatch));
+                record_batch_reset(pc->recordBatch);
+        }
+}
+
+void end_parsing(CsvReader *reader, ParsingContext *pc)
+{
+        flush_batch(reader, pc);
+        merge_stats(reader, pc);
+}
+
+void merge_stats(CsvReader *reader, ParsingContext *pc)
+{
+#ifdef CSV_STATS
+        CsvStats *stats = &reader->stats;
+
+        if (reader->statsTiming)
+                pc->stats.totalTime = stats_clock() - pc->startTime;
+
+        stats->bytes += pc->stats.bytes;
+        stats->records += pc->stats.records;
+        stats->skippedRecords += pc->stats.skippedRecords;
+        stats->fields += pc->stats.fields;
+        stats->quotedFields += pc->stats.quotedFields;
+        stats->multilineRecords += pc->stats.multilineRecords;
+        stats->bufferGrowths += pc->stats.bufferGrowths;
+        if (pc->stats.largestRecord > stats->largestRecord)
+                stats->largestRecord = pc->stats.largestRecord;
+        stats->totalTime += pc->stats.totalTime;
+        stats->callbackTime += pc->stats.callbackTime;
+
+        memset(&pc->stats, 0, sizeof pc->stats);
+#endif
+}
+
+inline void stats_record(ParsingContext *pc)
+{
+#ifdef CSV_STATS
+        // bufferPosition is past the end of the input if the record ends at EOF
+        size_t size = (pc->bufferPosition < pc->length ? pc->bufferPosition : pc->length) - pc->recordStart;
+
+        pc->stats.records += 1;
+        pc->stats.bytes += size;
+        stats_max(pc, largestRecord, size);
+        if (pc->flags & MULTILINE_RECORD)
+                pc->stats.multilineRecords += 1;
+#endif
+}
+
+double stats_clock(void)
+{
+#ifdef CSV_POSIX
+        struct timespec time;
+        clock_gettime(CLOCK_MONOTONIC, &time);
+        return (double) time.tv_sec + (double) time.tv_nsec / 1e9;
+#else
+        return (double) clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+void resolve_header(CsvReader *reader, ParsingContext *pc)
+{
+        RecordView *header;
+        size_t *projection;
+        size_t columns = pc->view->arraySize;
+        ColumnSelection *selection;
+        size_t i;
+        size_t j;
+
+        pc->bodyStart = pc->consumed + (pc->bufferPosition < pc->length ? pc->bufferPosition : pc->length);
+
+        if (reader->predicateCount > 0)
+                resolve_filters(reader, pc);
+
+        if (reader->selectionCount == 0) {
+                store_header(pc, pc->view);
+                resolve_dictionaries(reader, pc);
+                return;
+        }
+
+        for (i = 0; i < reader->selectionCount; i++) {
+                if (reader->selection[i].name == NULL && reader->selection[i].index >= columns)
+                        columns = reader->selection[i].index + 1;
         }
 
-        get_next_line(pc);
+        header = record_view_alloc(reader->selectionCount);
+        projection = malloc(sizeof(size_t) * columns);
+
+        if (header == NULL || projection == NULL) {
+                perror("Cannot alloc memory buffer for csv parsing");
+                abort();
+        }
+
+        for (i = 0; i < columns; i++) {
+                projection[i] = NOT_SELECTED;
+        }
+
+        for (i = 0; i < reader->selectionCount; i++) {
+                selection = &reader->selection[i];
+                j = selection->index;
+
+                if (selection->name != NULL) {
+                        for (j = 0; j < pc->view->arraySize; j++) {
+                                if (pc->view->fields[j].length == strlen(selection->name) &&
+                                    memcmp(pc->view->fields[j].data, selection->name, pc->view->fields[j].length) == 0)
+                                        break;
+                        }
+                        if (j == pc->view->arraySize)
+                                j = columns;
+                }
+
+                // If a column is selected twice, the field is stored only in its first slot
+                if (j < columns && projection[j] == NOT_SELECTED)
+                        projection[j] = i;
+
+                if (j < pc->view->arraySize)
+                        record_view_append(header, pc->view->fields[j].data, pc->view->fields[j].length);
+                else if (selection->name != NULL)
+                        record_view_append(header, selection->name, strlen(selection->name));
+                else
+                        record_view_append(header, "", 0);
+        }
+
+        store_header(pc, header);
+        set_projection(pc, projection, columns, reader->selectionCount);
+        resolve_dictionaries(reader, pc);
+        record_view_free(header);
+        free(projection);
 }
 
-void emit_field(ParsingContext *pc)
+void resolve_dictionaries(CsvReader *reader, ParsingContext *pc)
 {
-        char *string = pc->buffer->buffer + pc->lastSeparator;
-        char stringTermination = string[pc->bufferPosition - pc->lastSeparator];
-        string[pc->bufferPosition - pc->lastSeparator] = 0;
-        record_append_str(pc->record, string, pc->bufferPosition - pc->lastSeparator);
-        string[pc->bufferPosition - pc->lastSeparator] = stringTermination;
+        const char *name;
+        size_t column;
+        size_t i;
+
+        if (reader->internedCount == 0)
+                return;
+
+        pc->dictionaryCount = pc->headerView->arraySize;
+        pc->dictionaries = allocator_malloc(pc->allocator, sizeof(Dictionary *) * (pc->dictionaryCount + 1));
+        if (pc->dictionaries == NULL) {
+                perror("Cannot alloc memory buffer for csv parsing");
+                abort();
+        }
+
+        for (i = 0; i < pc->dictionaryCount; i++) {
+                pc->dictionaries[i] = NULL;
+        }
+
+        for (i = 0; i < reader->internedCount; i++) {
+                name = reader->interned[i].name;
+                column = column_map_find(pc->columns, name, strlen(name));
+                if (column != CSV_NO_COLUMN)
+                        pc->dictionaries[column] = reader->interned[i].dictionary;
+        }
 }
 
-void start_escaped_sequence(CsvReader *reader, ParsingContext *pc)
+void build_record(ParsingContext *pc)
 {
-        if (pc->secondaryBuffer == NULL) {
-                pc->secondaryBuffer = buffer_alloc(BUFFER_SIZE);
+        const FieldView *field;
+        Dictionary *dictionary;
+        uint32_t code;
+        size_t i;
+
+        for (i = 0; i < pc->view->arraySize; i++) {
+                field = &pc->view->fields[i];
+                dictionary = i < pc->dictionaryCount ? pc->dictionaries[i] : NULL;
+
+                if (dictionary != NULL && !dictionary->spilled) {
+                        if (dictionary_intern(dictionary, field->data, field->length, &code) < 0) {
+                                perror("Cannot alloc memory buffer for csv parsing");
+                                abort();
+                        }
+                        if (code != CSV_NO_CODE) {
+                                record_append_interned(pc->record, dictionary->values[code], code);
+                                continue;
+                        }
+                }
+
+                record_append_str(pc->record, field->data, field->length);
         }
-        pc->flags |= ESCAPING;
-        get_next_character(pc);
-        get_escaped_sequence(reader, pc);
 }
 
-void get_escaped_sequence(CsvReader *reader, ParsingContext *pc)
+void set_projection(ParsingContext *pc, const size_t *projection, size_t columns, size_t count)
 {
-        while(pc->flags & ESCAPING) {
-                if (current_char(pc) == 0) {
-                        get_next_line(pc);
+        FieldSpan *newFields;
+
+        allocator_free(pc->allocator, pc->projection);
+        pc->projection = allocator_malloc(pc->allocator, sizeof(size_t) * (columns + 1));
+
+        if (count > pc->fieldSize) {
+                newFields = allocator_realloc(pc->allocator, pc->fields,
+                                              pc->fieldSize * sizeof *pc->fields,
+                                              count * sizeof *pc->fields);
+                if (newFields != NULL) {
+                        pc->fields = newFields;
+                        pc->fieldSize = count;
                 }
+        }
+
+        if (pc->projection == NULL || count > pc->fieldSize) {
+                perror("Cannot alloc memory buffer for csv parsing");
+                abort();
+        }
+
+        memcpy(pc->projection, projection, sizeof(size_t) * columns);
+        pc->projectionColumns = columns;
+        pc->projectionCount = count;
+}
+
+void resolve_filters(CsvReader *reader, ParsingContext *pc)
+{
+        FieldFilter *filters = malloc(sizeof(FieldFilter) * reader->predicateCount);
+        const char *column;
+        size_t i;
+        size_t j;
+
+        if (filters == NULL) {
+                perror("Cannot alloc memory buffer for csv parsing");
+                abort();
+        }
+
+        for (i = 0; i < reader->predicateCount; i++) {
+                column = reader->predicates[i].column;
+                filters[i].predicate = &reader->predicates[i];
+                filters[i].column = NOT_SELECTED;
 
-                if (!is_dquote(current_char(pc))) {
-                        buffer_append(pc->secondaryBuffer, pc->buffer->buffer[pc->bufferPosition]);
-                } else if (is_dquote(current_char(pc)) && !is_dquote(lookahead((pc)))) {
-                        end_escaped_sequence(reader, pc);
-                        break;
-                } else if (is_dquote(current_char(pc)) && is_dquote(lookahead((pc)))) {
-                        buffer_append(pc->secondaryBuffer, pc->buffer->buffer[pc->bufferPosition]);
-                        get_next_character(pc);
+                for (j = 0; j < pc->view->arraySize; j++) {
+                        if (pc->view->fields[j].length == strlen(column) &&
+                            memcmp(pc->view->fields[j].data, column, pc->view->fields[j].length) == 0) {
+                                filters[i].column = j;
+                                break;
+                        }
                 }
+        }
+
+        set_filters(pc, filters, reader->predicateCount);
+        free(filters);
+}
 
-                get_next_character(pc);
+void set_filters(ParsingContext *pc, const FieldFilter *filters, size_t count)
+{
+        allocator_free(pc->allocator, pc->filters);
+        pc->filters = allocator_malloc(pc->allocator, sizeof(FieldFilter) * (count + 1));
+
+        if (pc->filters == NULL) {
+                perror("Cannot alloc memory buffer for csv parsing");
+                abort();
         }
+
+        memcpy(pc->filters, filters, sizeof(FieldFilter) * count);
+        pc->filterCount = count;
 }
 
-void end_escaped_sequence(CsvReader *reader, ParsingContext *pc)
+void filter_field(ParsingContext *pc, size_t column, const char *field, size_t length)
 {
-        record_append_str(pc->record, pc->secondaryBuffer->buffer, pc->secondaryBuffer->stringLength);
-        buffer_reset(pc->secondaryBuffer);
-        pc->flags &= ~ESCAPING;
+        size_t i;
 
-        do {
-                if (is_separator(current_char(pc))) {
-                        pc->lastSeparator = pc->bufferPosition + 1;
-                        get_next_character(pc);
-                } else if (is_line_ending(pc->buffer->buffer[pc->bufferPosition])) {
-                        emit_record(reader, pc);
-                } else {
-                        get_next_character(pc);
-                        continue;
+        for (i = 0; i < pc->filterCount; i++) {
+                if (pc->filters[i].column == column && !predicate_match(pc->filters[i].predicate, field, length)) {
+                        pc->flags |= REJECTED;
+                        return;
                 }
-                break;
-        } while (1);
+        }
+}
+
+int accept_record(ParsingContext *pc)
+{
+        size_t i;
+
+        if (pc->flags & REJECTED) {
+                pc->flags &= ~REJECTED;
+                stats_add(pc, skippedRecords, 1);
+                return 0;
+        }
+
+        for (i = 0; i < pc->filterCount; i++) {
+                if (pc->filters[i].column >= pc->column && !predicate_match(pc->filters[i].predicate, "", 0)) {
+                        stats_add(pc, skippedRecords, 1);
+                        return 0;
+                }
+        }
+
+        return 1;
+}
+
+int field_needed(ParsingContext *pc)
+{
+        size_t i;
+
+        if (pc->flags & REJECTED)
+                return 0;
+
+        if (is_selected(pc))
+                return 1;
+
+        for (i = 0; i < pc->filterCount; i++) {
+                if (pc->filters[i].column == pc->column)
+                        return 1;
+        }
+
+        return 0;
+}
+
+void store_header(ParsingContext *pc, RecordView *header)
+{
+        size_t i;
+
+        // The header is always copied, since it must outlive the input buffer
+        for (i = 0; i < header->arraySize; i++) {
+                record_append_str(pc->header, header->fields[i].data, header->fields[i].length);
+        }
+        for (i = 0; i < pc->header->arraySize; i++) {
+                record_view_append(pc->headerView, pc->header->fields[i], header->fields[i].length);
+        }
+
+        pc->columns = column_map_build(pc->headerView, pc->allocator);
+        if (pc->columns == NULL) {
+                perror("Cannot alloc memory buffer for csv parsing");
+                abort();
+        }
+
+        pc->header->columns = pc->columns;
+        pc->headerView->columns = pc->columns;
+        pc->record->columns = pc->columns;
+        pc->view->columns = pc->columns;
+        pc->flags |= HEADER_FOUND;
 }
 
 inline char current_char(ParsingContext *pc)
 {
-        return pc->buffer->buffer[pc->bufferPosition];
+        return pc->bufferPosition < pc->length ? pc->data[pc->bufferPosition] : 0;
 }
 
 inline char lookahead(ParsingContext *pc)
 {
-        return pc->buffer->buffer[pc->bufferPosition + 1];
+        return pc->bufferPosition + 1 < pc->length ? pc->data[pc->bufferPosition + 1] : 0;
 }
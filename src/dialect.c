@@ -0,0 +1,77 @@
+//
+// Created by Davide on 16/10/2026.
+//
+
+#include <errno.h>
+#include "parser.h"
+
+
+// Public Implementation
+
+int csv_reader_set_dialect(CsvReader *reader, const Dialect *dialect)
+{
+        if (!dialect_valid(dialect)) {
+                errno = EINVAL;
+                return -1;
+        }
+
+        reader->dialect = *dialect;
+        return 0;
+}
+
+void dialect_init(Dialect *dialect, char delimiter)
+{
+        dialect->delimiter = delimiter;
+        dialect->quote = '"';
+        dialect->escape = '"';
+        dialect->lineEnding = DIALECT_LINE_ANY;
+        dialect->trim = 0;
+}
+
+int dialect_valid(const Dialect *dialect)
+{
+        char newLine;
+
+        if (dialect->lineEnding != DIALECT_LINE_ANY && dialect->lineEnding != DIALECT_LINE_LF &&
+            dialect->lineEnding != DIALECT_LINE_CR)
+                return 0;
+
+        // The structural characters must be distinct
+        newLine = dialect_new_line(dialect);
+        if (dialect->delimiter == 0 || dialect->delimiter == newLine || dialect->delimiter == dialect->quote ||
+            dialect->delimiter == dialect->escape)
+                return 0;
+
+        if (dialect->quote == newLine || dialect->escape == newLine)
+                return 0;
+
+        // The carriage return before a new line is removed
+        if (dialect->lineEnding == DIALECT_LINE_ANY &&
+            (dialect->delimiter == CARRIAGE_RETURN || dialect->quote == CARRIAGE_RETURN))
+                return 0;
+
+        return dialect->trim == 0 || dialect->trim == 1;
+}
+
+int dialect_kind(const Dialect *dialect)
+{
+        if (dialect->quote != '"' || dialect->escape != '"' || dialect->lineEnding != DIALECT_LINE_ANY ||
+            dialect->trim)
+                return DIALECT_KIND_GENERIC;
+
+        switch (dialect->delimiter) {
+        case ',':
+                return DIALECT_KIND_CSV;
+        case '\t':
+                return DIALECT_KIND_TSV;
+        case '|':
+                return DIALECT_KIND_PSV;
+        default:
+                return DIALECT_KIND_GENERIC;
+        }
+}
+
+inline char dialect_new_line(const Dialect *dialect)
+{
+        return dialect->lineEnding == DIALECT_LINE_CR ? CARRIAGE_RETURN : NEW_LINE;
+}
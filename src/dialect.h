@@ -0,0 +1,76 @@
+//
+// Created by Davide on 16/10/2026.
+//
+
+#ifndef C_CSV__DIALECT_H
+#define C_CSV__DIALECT_H
+
+#include <stdlib.h>
+
+#define DIALECT_LINE_ANY 0
+#define DIALECT_LINE_LF 1
+#define DIALECT_LINE_CR 2
+
+#define DIALECT_KIND_CSV 0
+#define DIALECT_KIND_TSV 1
+#define DIALECT_KIND_PSV 2
+#define DIALECT_KIND_GENERIC 3
+
+/**
+ * The syntax of the input (see csv_reader_set_dialect)
+ *
+ * @param delimiter the character which separates the fields of a record
+ * @param quote the character which encloses the fields containing
+ *              delimiters or line endings, 0 if fields cannot be quoted
+ * @param escape the character which makes the next character literal.
+ *               If it is equal to quote, a quote is escaped by doubling it
+ *               inside a quoted field, as in RFC 4180. Otherwise it escapes
+ *               any character, both inside and outside quoted fields.
+ *               0 if there is no escape character
+ * @param lineEnding how records are terminated, one of
+ *                    - DIALECT_LINE_ANY: by "\n" or "\r\n"
+ *                    - DIALECT_LINE_LF: by "\n", carriage returns are data
+ *                    - DIALECT_LINE_CR: by "\r"
+ * @param trim if 1, spaces and tabs around unquoted fields are removed
+ */
+typedef struct Dialect_s {
+        char delimiter;
+        char quote;
+        char escape;
+        char lineEnding;
+        char trim;
+} Dialect;
+
+/**
+ * Initialize a dialect with the RFC 4180 syntax and the given delimiter:
+ * fields quoted by double quotes, escaped by doubling them, records
+ * terminated by "\n" or "\r\n" and no trimming.
+ * The parser is specialized at compile time for the dialects initialized
+ * this way with ',' (CSV), '\t' (TSV) or '|' (PSV); any other dialect is
+ * parsed by a generic, slightly slower, parser
+ * @param dialect the dialect
+ * @param delimiter the delimiter
+ */
+void dialect_init(Dialect *dialect, char delimiter);
+
+/**
+ * Check that the characters of a dialect are not ambiguous
+ * @param dialect the dialect
+ * @return 1 if the dialect is valid, 0 otherwise
+ */
+int dialect_valid(const Dialect *dialect);
+
+/**
+ * @param dialect the dialect
+ * @return the specialized parser of the dialect, one of DIALECT_KIND_CSV,
+ *         DIALECT_KIND_TSV, DIALECT_KIND_PSV, or DIALECT_KIND_GENERIC
+ */
+int dialect_kind(const Dialect *dialect);
+
+/**
+ * @param dialect the dialect
+ * @return the character terminating the records
+ */
+char dialect_new_line(const Dialect *dialect);
+
+#endif //C_CSV__DIALECT_H
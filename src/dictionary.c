@@ -0,0 +1,237 @@
+//
+// Created by Davide on 16/10/2026.
+//
+
+#include <utils.h>
+#include "parser.h"
+
+#define DICTIONARY_ARENA_SIZE 4096
+
+// Private prototypes
+
+/**
+ * Double the size of the hash table of a dictionary, storing the codes
+ * again
+ * @param dictionary the dictionary
+ * @return 0 on success, -1 on error
+ */
+int dictionary_rehash(Dictionary *dictionary);
+
+/**
+ * Find the slot of a value in the hash table of a dictionary
+ * @param dictionary the dictionary
+ * @param value the value
+ * @param len length of the value
+ * @return the slot storing the code of the value, or the empty slot where
+ *         it would be stored
+ */
+size_t dictionary_find(const Dictionary *dictionary, const char *value, size_t len);
+
+
+// Public Implementation
+
+int csv_reader_intern_column(CsvReader *reader, const char *name, size_t maxValues)
+{
+        InternedColumn *interned;
+        char *copy;
+        Dictionary *dictionary;
+
+        if (check_reader_idle(reader) < 0)
+                return -1;
+
+        if (maxValues == 0)
+                maxValues = DICTIONARY_SIZE;
+        if (maxValues > CSV_NO_CODE)
+                maxValues = CSV_NO_CODE;
+
+        interned = realloc(reader->interned, sizeof(InternedColumn) * (reader->internedCount + 1));
+        if (interned == NULL)
+                return -1;
+        reader->interned = interned;
+
+        copy = string_duplicate(name, strlen(name));
+        dictionary = dictionary_alloc(maxValues);
+
+        if (copy == NULL || dictionary == NULL) {
+                free(copy);
+                dictionary_free(dictionary);
+                return -1;
+        }
+
+        interned[reader->internedCount].name = copy;
+        interned[reader->internedCount].dictionary = dictionary;
+        reader->internedCount += 1;
+        return 0;
+}
+
+const Dictionary *csv_reader_dictionary(const CsvReader *reader, const char *name)
+{
+        size_t i;
+
+        for (i = 0; i < reader->internedCount; i++) {
+                if (strcmp(reader->interned[i].name, name) == 0)
+                        return reader->interned[i].dictionary;
+        }
+
+        return NULL;
+}
+
+int csv_reader_intern_clear(CsvReader *reader)
+{
+        size_t i;
+
+        if (check_reader_idle(reader) < 0)
+                return -1;
+
+        for (i = 0; i < reader->internedCount; i++) {
+                free(reader->interned[i].name);
+                dictionary_free(reader->interned[i].dictionary);
+        }
+
+        free(reader->interned);
+        reader->interned = NULL;
+        reader->internedCount = 0;
+        return 0;
+}
+
+inline uint32_t csv_record_code(const Record *record, size_t column)
+{
+        return record->codes != NULL && column < record->arraySize ? record->codes[column] : CSV_NO_CODE;
+}
+
+Dictionary *dictionary_alloc(size_t maxCount)
+{
+        Dictionary *result = malloc(sizeof(Dictionary));
+        size_t i;
+
+        if (result == NULL)
+                return NULL;
+
+        result->count = 0;
+        result->size = 16;
+        result->maxCount = maxCount;
+        result->spilled = 0;
+        result->mask = 2 * result->size - 1;
+        result->values = malloc(sizeof(char *) * result->size);
+        result->lengths = malloc(sizeof(size_t) * result->size);
+        result->slots = malloc(sizeof(uint32_t) * (result->mask + 1));
+        result->arena = arena_alloc(DICTIONARY_ARENA_SIZE, NULL);
+
+        if (result->values == NULL || result->lengths == NULL || result->slots == NULL || result->arena == NULL) {
+                dictionary_free(result);
+                return NULL;
+        }
+
+        for (i = 0; i <= result->mask; i++) {
+                result->slots[i] = CSV_NO_CODE;
+        }
+
+        return result;
+}
+
+int dictionary_intern(Dictionary *dictionary, const char *value, size_t len, uint32_t *code)
+{
+        size_t slot;
+        char **values;
+        size_t *lengths;
+
+        // A high cardinality column is not worth the lookups
+        if (dictionary->spilled) {
+                *code = CSV_NO_CODE;
+                return 0;
+        }
+
+        slot = dictionary_find(dictionary, value, len);
+        if (dictionary->slots[slot] != CSV_NO_CODE) {
+                *code = dictionary->slots[slot];
+                return 0;
+        }
+
+        if (dictionary->count >= dictionary->maxCount) {
+                dictionary->spilled = 1;
+                *code = CSV_NO_CODE;
+                return 0;
+        }
+
+        if (dictionary->count == dictionary->size) {
+                values = realloc(dictionary->values, sizeof(char *) * 2 * dictionary->size);
+                if (values == NULL)
+                        return -1;
+                dictionary->values = values;
+
+                lengths = realloc(dictionary->lengths, sizeof(size_t) * 2 * dictionary->size);
+                if (lengths == NULL)
+                        return -1;
+                dictionary->lengths = lengths;
+                dictionary->size *= 2;
+        }
+
+        dictionary->values[dictionary->count] = arena_strdup(dictionary->arena, value, len);
+        if (dictionary->values[dictionary->count] == NULL)
+                return -1;
+
+        dictionary->lengths[dictionary->count] = len;
+        dictionary->slots[slot] = (uint32_t) dictionary->count;
+        *code = (uint32_t) dictionary->count;
+        dictionary->count += 1;
+
+        // The table is kept at most half full
+        if (2 * dictionary->count > dictionary->mask + 1)
+                return dictionary_rehash(dictionary);
+        return 0;
+}
+
+void dictionary_free(Dictionary *dictionary)
+{
+        if (dictionary == NULL)
+                return;
+
+        free(dictionary->values);
+        free(dictionary->lengths);
+        free(dictionary->slots);
+        if (dictionary->arena != NULL)
+                arena_free(dictionary->arena);
+        free(dictionary);
+}
+
+
+// Private Implementation
+
+int dictionary_rehash(Dictionary *dictionary)
+{
+        size_t size = 2 * (dictionary->mask + 1);
+        uint32_t *slots = malloc(sizeof(uint32_t) * size);
+        size_t code;
+        size_t i;
+
+        if (slots == NULL)
+                return -1;
+
+        free(dictionary->slots);
+        dictionary->slots = slots;
+        dictionary->mask = size - 1;
+
+        for (i = 0; i < size; i++) {
+                slots[i] = CSV_NO_CODE;
+        }
+
+        for (code = 0; code < dictionary->count; code++) {
+                i = dictionary_find(dictionary, dictionary->values[code], dictionary->lengths[code]);
+                slots[i] = (uint32_t) code;
+        }
+
+        return 0;
+}
+
+size_t dictionary_find(const Dictionary *dictionary, const char *value, size_t len)
+{
+        size_t slot = (size_t) string_hash(value, len, 0) & dictionary->mask;
+        uint32_t code;
+
+        for (;; slot = (slot + 1) & dictionary->mask) {
+                code = dictionary->slots[slot];
+                if (code == CSV_NO_CODE || (dictionary->lengths[code] == len &&
+                                            memcmp(dictionary->values[code], value, len) == 0))
+                        return slot;
+        }
+}
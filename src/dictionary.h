@@ -0,0 +1,64 @@
+//
+// Created by Davide on 16/10/2026.
+//
+
+#ifndef C_CSV__DICTIONARY_H
+#define C_CSV__DICTIONARY_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "record.h"
+
+#define DICTIONARY_SIZE 4096
+
+/**
+ * The distinct values of an interned column (see csv_reader_intern_column).
+ * Codes are assigned in order of appearance, from 0 to count - 1:
+ * values[code] is the value whose code is code, null terminated, and
+ * lengths[code] its length. The values are stored in arena and never
+ * moved, so they are valid until the dictionary is freed.
+ * At most maxCount values are stored: when a column has more distinct
+ * values, the column is spilled and spilled is set. The values of a
+ * spilled column are no longer looked up: all of them are copied, without
+ * a code, and the dictionary keeps the values stored before.
+ * slots is a hash table of mask + 1 codes, CSV_NO_CODE for the empty slots
+ */
+typedef struct Dictionary_s {
+        char **values;
+        size_t *lengths;
+        size_t count;
+        size_t size;
+        size_t maxCount;
+        int spilled;
+        uint32_t *slots;
+        size_t mask;
+        Arena *arena;
+} Dictionary;
+
+/**
+ * Allocate an empty dictionary
+ * @param maxCount the maximum number of values, at most CSV_NO_CODE
+ * @return the dictionary, or NULL on error
+ */
+Dictionary *dictionary_alloc(size_t maxCount);
+
+/**
+ * Find the code of a value, adding the value if it is not stored yet
+ * @param dictionary the dictionary
+ * @param value the value, it may not be null terminated
+ * @param len length of the value
+ * @param code output, the code of the value, CSV_NO_CODE if the column is
+ *             spilled, or if the value is not stored and the dictionary is
+ *             full (the column is then spilled)
+ * @return 0 on success, -1 on error
+ */
+int dictionary_intern(Dictionary *dictionary, const char *value, size_t len, uint32_t *code);
+
+/**
+ * Free a dictionary and its values
+ * @param dictionary the dictionary, it may be NULL
+ */
+void dictionary_free(Dictionary *dictionary);
+
+#endif //C_CSV__DICTIONARY_H
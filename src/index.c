@@ -0,0 +1,577 @@
+//
+// Created by Davide on 16/10/2026.
+//
+
+#include "parser.h"
+
+#define INDEX_MAGIC "CCSVIDX1"
+#define INDEX_MAGIC_LENGTH 8
+#define INDEX_SIZE 64
+
+// Private prototypes
+
+/**
+ * Index the records of the input of a parsing context
+ * @param pc the parsing context, positioned at the beginning of the input
+ * @param stride the number of records between two offsets
+ * @return the index, or NULL on error
+ */
+RecordIndex *index_build(ParsingContext *pc, size_t stride);
+
+/**
+ * Write a 64 bit unsigned integer to a file
+ * @param file the file
+ * @param value the value
+ * @return 0 on success, -1 on error
+ */
+int index_write(FILE *file, size_t value);
+
+/**
+ * Read a 64 bit unsigned integer from a file
+ * @param file the file
+ * @param value output, the value
+ * @return 0 on success, -1 on error
+ */
+int index_read(FILE *file, size_t *value);
+
+/**
+ * Check if the stream of a parsing context can be repositioned
+ * @param pc the parsing context
+ * @return 1 if the stream supports seeking, 0 otherwise
+ */
+int stream_seekable(ParsingContext *pc);
+
+/**
+ * Count the records of the input of a parsing context
+ * @param pc the parsing context, positioned at the beginning of the input
+ * @return the number of records, the header excluded
+ */
+size_t count_records(ParsingContext *pc);
+
+
+// Public Implementation
+
+RecordIndex *csv_index_build_memory(CsvReader *reader, const char *data, size_t len, size_t stride)
+{
+        ParsingContext pc;
+        RecordIndex *result;
+
+        parsing_context_init(reader, &pc);
+        pc.data = data;
+        pc.length = len;
+        result = index_build(&pc, stride);
+        parsing_context_destroy(&pc);
+        return result;
+}
+
+RecordIndex *csv_index_build(CsvReader *reader, const char *path, size_t stride)
+{
+        RecordIndex *result;
+#ifdef CSV_POSIX
+        const char *data;
+        size_t len;
+
+        if (map_file(path, &data, &len) < 0)
+                return NULL;
+
+        result = csv_index_build_memory(reader, data, len, stride);
+        unmap_file(data, len);
+#else
+        ParsingContext pc;
+        FILE *csvFile = fopen(path, "r");
+
+        if (csvFile == NULL)
+                return NULL;
+
+        parsing_context_init(reader, &pc);
+        pc.currentCsv = csvFile;
+        parsing_context_init_stream(reader, &pc);
+        result = index_build(&pc, stride);
+        parsing_context_destroy(&pc);
+        fclose(csvFile);
+#endif
+        return result;
+}
+
+int csv_index_save(const RecordIndex *index, const char *path)
+{
+        FILE *file = fopen(path, "wb");
+        size_t i;
+        int result;
+
+        if (file == NULL)
+                return -1;
+
+        result = fwrite(INDEX_MAGIC, 1, INDEX_MAGIC_LENGTH, file) == INDEX_MAGIC_LENGTH &&
+                 index_write(file, index->stride) == 0 &&
+                 index_write(file, index->count) == 0 &&
+                 index_write(file, index->records) == 0 &&
+                 index_write(file, index->inputSize) == 0 ? 0 : -1;
+
+        for (i = 0; i < index->count && result == 0; i++) {
+                result = index_write(file, index->offsets[i]);
+        }
+
+        if (fclose(file) != 0)
+                result = -1;
+        return result;
+}
+
+RecordIndex *csv_index_load(const char *path)
+{
+        FILE *file = fopen(path, "rb");
+        char magic[INDEX_MAGIC_LENGTH];
+        RecordIndex *result;
+        size_t stride, count, offset;
+        size_t i;
+
+        if (file == NULL)
+                return NULL;
+
+        if (fread(magic, 1, INDEX_MAGIC_LENGTH, file) != INDEX_MAGIC_LENGTH ||
+            memcmp(magic, INDEX_MAGIC, INDEX_MAGIC_LENGTH) != 0 ||
+            index_read(file, &stride) < 0 || index_read(file, &count) < 0 || stride == 0) {
+                fclose(file);
+                errno = EINVAL;
+                return NULL;
+        }
+
+        result = record_index_alloc(stride);
+        if (result == NULL || index_read(file, &result->records) < 0 || index_read(file, &result->inputSize) < 0) {
+                record_index_free(result);
+                fclose(file);
+                return NULL;
+        }
+
+        for (i = 0; i < count; i++) {
+                if (index_read(file, &offset) < 0 || record_index_append(result, offset) < 0) {
+                        record_index_free(result);
+                        fclose(file);
+                        errno = EINVAL;
+                        return NULL;
+                }
+        }
+
+        fclose(file);
+        return result;
+}
+
+int csv_count_records_memory(CsvReader *reader, const char *data, size_t len, size_t *count)
+{
+        ParsingContext pc;
+
+        parsing_context_init(reader, &pc);
+        pc.data = data;
+        pc.length = len;
+        *count = count_records(&pc);
+        parsing_context_destroy(&pc);
+        return 0;
+}
+
+int csv_count_records(CsvReader *reader, const char *path, size_t *count)
+{
+        ParsingContext pc;
+        Cache *cache = reader->cache ? load_cache(reader, path) : NULL;
+#ifdef CSV_POSIX
+        const char *data;
+        size_t len;
+#else
+        FILE *csvFile;
+#endif
+
+        if (cache != NULL) {
+                parsing_context_init(reader, &pc);
+                set_cache(&pc, cache);
+                *count = count_records(&pc);
+                parsing_context_destroy(&pc);
+                return 0;
+        }
+
+#ifdef CSV_POSIX
+        if (map_file(path, &data, &len) < 0)
+                return -1;
+
+        csv_count_records_memory(reader, data, len, count);
+        unmap_file(data, len);
+#else
+        csvFile = fopen(path, "r");
+        if (csvFile == NULL)
+                return -1;
+
+        parsing_context_init(reader, &pc);
+        pc.currentCsv = csvFile;
+        parsing_context_init_stream(reader, &pc);
+        *count = count_records(&pc);
+        parsing_context_destroy(&pc);
+        fclose(csvFile);
+#endif
+        return 0;
+}
+
+inline void csv_index_free(RecordIndex *index)
+{
+        record_index_free(index);
+}
+
+void csv_reader_set_index(CsvReader *reader, const RecordIndex *index)
+{
+        reader->index = index;
+}
+
+int csv_reader_seek_record(CsvReader *reader, size_t record)
+{
+        if (reader->index != NULL && record > reader->index->records) {
+                errno = ERANGE;
+                return -1;
+        }
+
+        reader->startRecord = record;
+        return 0;
+}
+
+int csv_iterator_seek_record(CsvIterator *iterator, size_t record)
+{
+        const RecordIndex *index = iterator->reader->index;
+
+        if (index != NULL && record > index->records) {
+                errno = ERANGE;
+                return -1;
+        }
+
+        if (check_index(&iterator->pc, index) < 0)
+                return -1;
+
+        if (csv_iterator_header(iterator) == NULL)
+                return record == 0 ? 0 : -1;
+
+        return seek_record(&iterator->pc, index, record);
+}
+
+size_t csv_iterator_skip_records(CsvIterator *iterator, size_t count)
+{
+        if (count == 0 || csv_iterator_header(iterator) == NULL)
+                return 0;
+
+        return skip_records(&iterator->pc, count);
+}
+
+RecordIndex *record_index_alloc(size_t stride)
+{
+        RecordIndex *result = malloc(sizeof(RecordIndex));
+
+        if (result == NULL)
+                return NULL;
+
+        result->stride = stride > 0 ? stride : 1;
+        result->offsets = malloc(sizeof(size_t) * INDEX_SIZE);
+        result->count = 0;
+        result->size = INDEX_SIZE;
+        result->records = 0;
+        result->inputSize = 0;
+
+        if (result->offsets == NULL) {
+                free(result);
+                return NULL;
+        }
+
+        return result;
+}
+
+int record_index_append(RecordIndex *index, size_t offset)
+{
+        size_t *offsets;
+
+        if (index->count >= index->size) {
+                offsets = realloc(index->offsets, sizeof(size_t) * index->size * 2);
+                if (offsets == NULL)
+                        return -1;
+                index->offsets = offsets;
+                index->size *= 2;
+        }
+
+        index->offsets[index->count] = offset;
+        index->count += 1;
+        return 0;
+}
+
+void record_index_free(RecordIndex *index)
+{
+        if (index == NULL)
+                return;
+
+        free(index->offsets);
+        free(index);
+}
+
+void apply_seek(CsvReader *reader, ParsingContext *pc)
+{
+        if (reader->startRecord == 0 || (pc->flags & FEEDING))
+                return;
+
+        if (seek_record(pc, reader->index, reader->startRecord) < 0) {
+                // Nothing is read if the record cannot be reached
+                pc->bufferPosition = pc->length;
+                pc->flags |= PROCESSED_ALL_RECORDS;
+        }
+}
+
+int check_index(ParsingContext *pc, const RecordIndex *index)
+{
+        size_t length;
+#ifdef CSV_POSIX
+        struct stat info;
+        int fd;
+#endif
+
+        // Fed input is never repositioned
+        if (index == NULL || (pc->flags & FEEDING))
+                return 0;
+
+        if (pc->cache != NULL) {
+                length = pc->cache->entries[pc->cache->records].offset;
+        } else if (pc->currentCsv == NULL && pc->fd < 0) {
+                length = pc->consumed + pc->length;
+        } else {
+#ifdef CSV_POSIX
+                fd = pc->fd >= 0 ? pc->fd : fileno(pc->currentCsv);
+                if (fstat(fd, &info) < 0 || !S_ISREG(info.st_mode))
+                        return 0;
+                length = (size_t) info.st_size;
+#else
+                return 0;
+#endif
+        }
+
+        if (length != index->inputSize) {
+                errno = EINVAL;
+                return -1;
+        }
+        return 0;
+}
+
+int seek_record(ParsingContext *pc, const RecordIndex *index, size_t record)
+{
+        size_t offset = pc->bodyStart;
+        size_t skip = record;
+        size_t entry;
+
+        // The records of a cache are reached directly, the header is the first
+        if (pc->cache != NULL) {
+                pc->cacheRecord = 1;
+                skip_records(pc, record);
+                return 0;
+        }
+
+        if (index != NULL && index->count > 0) {
+                entry = record / index->stride < index->count ? record / index->stride : index->count - 1;
+                offset = index->offsets[entry];
+                skip = record - entry * index->stride;
+        }
+
+        // Streams which cannot be repositioned are read from the first record
+        if (seek_offset(pc, offset) < 0) {
+                skip = record;
+                if (seek_offset(pc, pc->bodyStart) < 0)
+                        return -1;
+        }
+
+        skip_records(pc, skip);
+        return 0;
+}
+
+size_t skip_records(ParsingContext *pc, size_t count)
+{
+        void (*scan)(const char *, const ScanChars *, ScanMasks *);
+        ScanMasks masks;
+        size_t filterCount = pc->filterCount;
+        size_t skipped = 0;
+        size_t block;
+        size_t length;
+        uint64_t valid;
+        uint64_t quoted = 0;
+        uint64_t inside;
+        uint64_t ends;
+        unsigned n;
+        int pending = 0;
+
+        if (pc->cache != NULL) {
+                skipped = pc->cache->records - pc->cacheRecord;
+                skipped = count < skipped ? count : skipped;
+                pc->cacheRecord += skipped;
+                return skipped;
+        }
+
+        // Records are skipped by parsing them if escape characters may hide
+        // quotes, and if the input is fed (the skip must be resumable)
+        if ((pc->scanChars.escape != 0 && pc->scanChars.escape != pc->scanChars.quote) || (pc->flags & FEEDING)) {
+                // Skipped records are not checked against the predicates
+                pc->filterCount = 0;
+                while (skipped < count && get_next_record(pc))
+                        skipped++;
+                pc->filterCount = filterCount;
+                return skipped;
+        }
+
+        switch (pc->dialectKind) {
+        case DIALECT_KIND_CSV:
+                scan = &scan_block_csv;
+                break;
+        case DIALECT_KIND_TSV:
+                scan = &scan_block_tsv;
+                break;
+        case DIALECT_KIND_PSV:
+                scan = &scan_block_psv;
+                break;
+        default:
+                scan = &scan_block;
+                break;
+        }
+
+        // Records end at the line endings outside quotes: the bytes inside
+        // quotes are found from the parity of the quotes which precede them
+        while (skipped < count) {
+                if (pc->bufferPosition >= pc->length) {
+                        // The bytes of the skipped records are not kept
+                        pc->recordStart = pc->bufferPosition;
+                        if (fill_buffer(pc) == 0) {
+                                // The last record may end at EOF without a line ending
+                                skipped += pending;
+                                break;
+                        }
+                }
+
+                block = pc->bufferPosition;
+                length = pc->length - block < SCAN_BLOCK_SIZE ? pc->length - block : SCAN_BLOCK_SIZE;
+                if (block + SCAN_BLOCK_SIZE <= pc->length + pc->padding)
+                        scan(pc->data + block, &pc->scanChars, &masks);
+                else
+                        scan_partial_block(pc->data + block, length, &pc->scanChars, &masks);
+
+                valid = length < SCAN_BLOCK_SIZE ? ~(~(uint64_t) 0 << length) : ~(uint64_t) 0;
+                inside = scan_prefix_xor(masks.dquote & valid) ^ quoted;
+                ends = masks.newLine & valid & ~inside;
+                n = scan_count_bits(ends);
+
+                if (skipped + n >= count) {
+                        // Drop the ends beyond the last record to skip
+                        for (; skipped + 1 < count; skipped++)
+                                ends &= ends - 1;
+                        pc->bufferPosition = block + scan_first_bit(ends) + 1;
+                        skipped = count;
+                        break;
+                }
+
+                skipped += n;
+                quoted = (uint64_t) 0 - (inside >> (length - 1) & 1);
+                pending = !(ends >> (length - 1) & 1);
+                pc->bufferPosition = block + length;
+        }
+
+        pc->recordStart = pc->bufferPosition;
+        pc->fieldStart = pc->bufferPosition;
+        return skipped;
+}
+
+int seek_offset(ParsingContext *pc, size_t offset)
+{
+        size_t position = pc->consumed + pc->length;
+        int result = -1;
+
+        if (offset >= pc->consumed && offset <= position) {
+                pc->bufferPosition = offset - pc->consumed;
+        } else {
+                if (pc->buffer == NULL || (pc->flags & FEEDING))
+                        return -1;
+
+                // The position of the stream is the end of the input buffer,
+                // unless blocks have been read in advance: they are discarded
+                // only if the stream can be repositioned
+                if (pc->prefetch != NULL) {
+                        if (!stream_seekable(pc))
+                                return -1;
+                        position = prefetch_stop(pc->prefetch);
+                }
+
+#ifdef CSV_POSIX
+                if (pc->fd >= 0)
+                        result = lseek(pc->fd, (off_t) offset - (off_t) position, SEEK_CUR) < 0 ? -1 : 0;
+                else
+#endif
+                        result = fseek(pc->currentCsv, (long) offset - (long) position, SEEK_CUR);
+
+                if (result < 0)
+                        return -1;
+
+                buffer_reset(pc->buffer);
+                pc->data = pc->buffer->buffer;
+                pc->consumed = offset;
+                pc->length = 0;
+                pc->bufferPosition = 0;
+        }
+
+        pc->recordStart = pc->bufferPosition;
+        pc->fieldStart = pc->bufferPosition;
+        pc->fieldCount = 0;
+        pc->scanBlock = NO_SCAN_BLOCK;
+        pc->flags &= ~(PROCESSED_ALL_RECORDS | IN_RECORD | ESCAPING | ESCAPED_FIELD | DQUOTE_FOUND | REJECTED);
+        return 0;
+}
+
+// Private Implementation
+
+size_t count_records(ParsingContext *pc)
+{
+        size_t records = skip_records(pc, (size_t) -1);
+
+        // The header is not counted
+        return records > 0 ? records - 1 : 0;
+}
+
+RecordIndex *index_build(ParsingContext *pc, size_t stride)
+{
+        RecordIndex *result = record_index_alloc(stride);
+
+        if (result == NULL)
+                return NULL;
+
+        // The header is not indexed
+        get_next_record(pc);
+
+        while (get_next_record(pc)) {
+                if (result->records % result->stride == 0 &&
+                    record_index_append(result, pc->consumed + pc->recordStart) < 0) {
+                        record_index_free(result);
+                        return NULL;
+                }
+                result->records += 1;
+        }
+
+        result->inputSize = pc->consumed + pc->length;
+        return result;
+}
+
+int index_write(FILE *file, size_t value)
+{
+        uint64_t data = value;
+        return fwrite(&data, sizeof data, 1, file) == 1 ? 0 : -1;
+}
+
+int index_read(FILE *file, size_t *value)
+{
+        uint64_t data;
+
+        if (fread(&data, sizeof data, 1, file) != 1)
+                return -1;
+
+        *value = (size_t) data;
+        return 0;
+}
+
+int stream_seekable(ParsingContext *pc)
+{
+#ifdef CSV_POSIX
+        if (pc->fd >= 0)
+                return lseek(pc->fd, 0, SEEK_CUR) >= 0;
+#endif
+        return ftell(pc->currentCsv) >= 0;
+}
@@ -0,0 +1,47 @@
+//
+// Created by Davide on 16/10/2026.
+//
+
+#ifndef C_CSV__INDEX_H
+#define C_CSV__INDEX_H
+
+#include <stdlib.h>
+
+/**
+ * The byte offsets of the records of a csv file.
+ * offsets[i] is the offset of the first character of record i * stride,
+ * records are numbered from 0, the header excluded. count is the number of
+ * offsets, records the number of records of the file and inputSize its
+ * length in bytes
+ */
+typedef struct RecordIndex_s {
+        size_t stride;
+        size_t *offsets;
+        size_t count;
+        size_t size;
+        size_t records;
+        size_t inputSize;
+} RecordIndex;
+
+/**
+ * Allocate an empty index
+ * @param stride the number of records between two offsets
+ * @return the index, or NULL on error
+ */
+RecordIndex *record_index_alloc(size_t stride);
+
+/**
+ * Append the offset of a record to the index
+ * @param index the index
+ * @param offset the offset of the record
+ * @return 0 on success, -1 on error
+ */
+int record_index_append(RecordIndex *index, size_t offset);
+
+/**
+ * Free an index
+ * @param index the index
+ */
+void record_index_free(RecordIndex *index);
+
+#endif //C_CSV__INDEX_H
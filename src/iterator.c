@@ -0,0 +1,180 @@
+//
+// Created by Davide on 16/10/2026.
+//
+
+#include "parser.h"
+
+// Private prototypes
+
+/**
+ * Allocate an iterator and its parsing context
+ * @param reader the CsvReader
+ * @return the iterator, or NULL on error
+ */
+CsvIterator *iterator_alloc(CsvReader *reader);
+
+/**
+ * Read the header, if it has not been read yet
+ * @param iterator the iterator
+ * @return 0 if the input is empty, 1 otherwise
+ */
+int iterator_read_header(CsvIterator *iterator);
+
+
+// Public Implementation
+
+CsvIterator *csv_iterator_open(CsvReader *reader, FILE *csvFile)
+{
+        CsvIterator *result = iterator_alloc(reader);
+        if (result == NULL)
+                return NULL;
+        result->pc.currentCsv = csvFile;
+        parsing_context_init_stream(reader, &result->pc);
+        return result;
+}
+
+#ifdef CSV_POSIX
+CsvIterator *csv_iterator_open_fd(CsvReader *reader, int fd)
+{
+        CsvIterator *result = iterator_alloc(reader);
+        if (result == NULL)
+                return NULL;
+        result->pc.fd = fd;
+        parsing_context_init_stream(reader, &result->pc);
+        return result;
+}
+#endif
+
+CsvIterator *csv_iterator_open_memory(CsvReader *reader, const char *data, size_t len)
+{
+        CsvIterator *result = iterator_alloc(reader);
+        if (result == NULL)
+                return NULL;
+        result->pc.data = data;
+        result->pc.length = len;
+        return result;
+}
+
+CsvIterator *csv_iterator_open_path(CsvReader *reader, const char *path)
+{
+        CsvIterator *result;
+        Cache *cache = reader->cache ? load_cache(reader, path) : NULL;
+#ifdef CSV_POSIX
+        const char *data;
+        size_t len;
+#endif
+
+        // The cache is freed with the parsing context
+        if (cache != NULL) {
+                result = iterator_alloc(reader);
+                if (result == NULL) {
+                        cache_free(cache);
+                        return NULL;
+                }
+                set_cache(&result->pc, cache);
+                return result;
+        }
+
+#ifdef CSV_POSIX
+        if (map_file(path, &data, &len) < 0)
+                return NULL;
+
+        result = csv_iterator_open_memory(reader, data, len);
+        if (result == NULL) {
+                unmap_file(data, len);
+                return NULL;
+        }
+#else
+        FILE *csvFile = fopen(path, "r");
+
+        if (csvFile == NULL)
+                return NULL;
+
+        result = csv_iterator_open(reader, csvFile);
+        if (result == NULL) {
+                fclose(csvFile);
+                return NULL;
+        }
+#endif
+
+        // The file is closed with the parsing context
+        result->pc.flags |= OWNS_INPUT;
+        return result;
+}
+
+int csv_iterator_next(CsvIterator *iterator, RecordView **header, RecordView **record)
+{
+        ParsingContext *pc = &iterator->pc;
+
+        if (!iterator_read_header(iterator) || !get_next_record(pc))
+                return 0;
+
+        resolve_fields(pc, pc->view);
+
+        if (header != NULL)
+                *header = pc->headerView;
+        if (record != NULL)
+                *record = pc->view;
+        return 1;
+}
+
+int csv_iterator_next_record(CsvIterator *iterator, Record **header, Record **record)
+{
+        ParsingContext *pc = &iterator->pc;
+
+        record_reset(pc->record);
+
+        if (!csv_iterator_next(iterator, NULL, NULL))
+                return 0;
+
+        build_record(pc);
+
+        if (header != NULL)
+                *header = pc->header;
+        if (record != NULL)
+                *record = pc->record;
+        return 1;
+}
+
+RecordView *csv_iterator_header(CsvIterator *iterator)
+{
+        if (!iterator_read_header(iterator))
+                return NULL;
+        return iterator->pc.headerView;
+}
+
+void csv_iterator_close(CsvIterator *iterator)
+{
+        merge_stats(iterator->reader, &iterator->pc);
+        parsing_context_destroy(&iterator->pc);
+        free(iterator);
+}
+
+// Private Implementation
+
+CsvIterator *iterator_alloc(CsvReader *reader)
+{
+        CsvIterator *result = malloc(sizeof(CsvIterator));
+        if (result == NULL)
+                return NULL;
+
+        parsing_context_init(reader, &result->pc);
+        result->reader = reader;
+        return result;
+}
+
+int iterator_read_header(CsvIterator *iterator)
+{
+        ParsingContext *pc = &iterator->pc;
+
+        if (pc->flags & HEADER_FOUND)
+                return 1;
+
+        if (!get_next_record(pc))
+                return 0;
+
+        resolve_fields(pc, pc->view);
+        resolve_header(iterator->reader, pc);
+        apply_seek(iterator->reader, pc);
+        return 1;
+}
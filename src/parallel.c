@@ -0,0 +1,515 @@
+//
+// Created by Davide on 16/10/2026.
+//
+
+#include "parser.h"
+
+#ifdef CSV_POSIX
+#include <pthread.h>
+#endif
+
+#define CHUNK_SIZE (8 << 20)
+#define CHUNKS_PER_THREAD 4
+
+#define PASS_COUNT_DQUOTES 0
+#define PASS_PARSE 1
+
+/**
+ * A slice of the input, parsed by a single worker.
+ * nominalStart is where the slice would begin if records were not taken
+ * into account, start is the first record beginning at or after it.
+ * The slice ends where the next one starts
+ */
+typedef struct {
+        size_t nominalStart;
+        size_t start;
+        size_t end;
+        size_t dquotes;
+} Chunk;
+
+/**
+ * The records of a chunk, stored as field positions until the chunk can be
+ * delivered (ordered mode only)
+ *
+ * @param fields the fields of all the records, offsets in the input or in
+ *               escaped
+ * @param records number of fields of each record
+ * @param escaped the unescaped quoted fields of the chunk
+ */
+typedef struct {
+        FieldSpan *fields;
+        size_t fieldCount;
+        size_t fieldSize;
+
+        size_t *records;
+        size_t recordCount;
+        size_t recordSize;
+
+        Buffer *escaped;
+} ChunkRecords;
+
+/**
+ * State shared by the workers
+ *
+ * @param header the header of the file, copied by each worker
+ * @param headerContext the context which has read the header, whose
+ *                      projection and predicates are copied by each worker
+ * @param nextChunk the next chunk to be taken by a worker
+ * @param nextDelivery in ordered mode, the chunk whose records can be
+ *                     delivered
+ */
+typedef struct {
+        CsvReader *reader;
+        const char *data;
+        size_t length;
+        RecordView *header;
+        const ParsingContext *headerContext;
+
+        Chunk *chunks;
+        size_t chunkCount;
+        int pass;
+        int ordered;
+
+#ifdef CSV_POSIX
+        pthread_mutex_t lock;
+        pthread_cond_t turn;
+#endif
+        size_t nextChunk;
+        size_t nextDelivery;
+} ParallelContext;
+
+
+// Private prototypes
+
+/**
+ * Run a pass of the parallel parsing on the given number of threads
+ * @param par the shared state
+ * @param threads number of threads
+ */
+void parallel_run(ParallelContext *par, int threads);
+
+/**
+ * Body of a worker: take chunks until there are none left
+ * @param arg the ParallelContext
+ * @return NULL
+ */
+void *parallel_worker(void *arg);
+
+/**
+ * Take the next chunk to process
+ * @param par the shared state
+ * @return the index of the chunk, or chunkCount if there are no chunks left
+ */
+size_t parallel_next_chunk(ParallelContext *par);
+
+/**
+ * Find the first record of each chunk, given the number of quotes of each
+ * chunk: a record starts after a new line preceded by an even number of
+ * quotes
+ * @param par the shared state
+ */
+void parallel_resolve_boundaries(ParallelContext *par);
+
+/**
+ * Parse the records of a chunk and deliver them as soon as they are read
+ * @param par the shared state
+ * @param pc the parsing context of the worker
+ * @param chunk the chunk
+ */
+void parallel_parse_chunk(ParallelContext *par, ParsingContext *pc, Chunk *chunk);
+
+/**
+ * Parse the records of a chunk, store them, and deliver them when all the
+ * previous chunks have been delivered
+ * @param par the shared state
+ * @param pc the parsing context of the worker
+ * @param chunk the index of the chunk
+ * @param store storage for the records of the chunk
+ */
+void parallel_parse_chunk_ordered(ParallelContext *par, ParsingContext *pc, size_t chunk, ChunkRecords *store);
+
+/**
+ * Append the fields of the record stored in the parsing context to a store
+ * @param pc parsing context
+ * @param store the store
+ */
+void chunk_records_append(ParsingContext *pc, ChunkRecords *store);
+
+
+// Public Implementation
+
+void csv_reader_parse_memory_parallel(CsvReader *reader, const char *data, size_t len, int threads, int ordered)
+{
+        ParallelContext par;
+        ParsingContext pc;
+        size_t bodyStart;
+        size_t chunkSize;
+        size_t i;
+
+#ifndef CSV_POSIX
+        threads = 1;
+#endif
+
+        // Quotes escaped by an escape character would break the count of the
+        // quotes which finds the boundaries of the records, and the
+        // dictionaries of the interned columns are not shared among threads
+        if (threads <= 1 || (reader->dialect.escape != 0 && reader->dialect.escape != reader->dialect.quote) ||
+            reader->internedCount > 0) {
+                // The data may not outlive the call, a paused parsing is ended
+                if (csv_reader_parse_memory(reader, data, len) == CSV_PAUSED)
+                        discard_paused(reader);
+                return;
+        }
+
+        discard_paused(reader);
+        reader->control = 0;
+
+        // The header is read sequentially
+        parsing_context_init(reader, &pc);
+        pc.data = data;
+        pc.length = len;
+
+        if (!get_next_record(&pc)) {
+                parsing_context_destroy(&pc);
+                return;
+        }
+
+        emit_record(reader, &pc);
+        reader->control &= ~CONTROL_SKIP;
+        bodyStart = pc.bufferPosition < len ? pc.bufferPosition : len;
+
+        par.reader = reader;
+        par.data = data;
+        par.length = len;
+        par.header = pc.headerView;
+        par.headerContext = &pc;
+        par.ordered = ordered;
+
+        chunkSize = (len - bodyStart) / ((size_t) threads * CHUNKS_PER_THREAD) + 1;
+        if (chunkSize > CHUNK_SIZE)
+                chunkSize = CHUNK_SIZE;
+
+        par.chunkCount = (len - bodyStart + chunkSize - 1) / chunkSize;
+        par.chunks = malloc(sizeof(Chunk) * (par.chunkCount + 1));
+
+        if (par.chunks == NULL) {
+                perror("Cannot alloc memory buffer for csv parsing");
+                abort();
+        }
+
+        for (i = 0; i < par.chunkCount; i++) {
+                par.chunks[i].nominalStart = bodyStart + i * chunkSize;
+                par.chunks[i].dquotes = 0;
+        }
+
+#ifdef CSV_POSIX
+        pthread_mutex_init(&par.lock, NULL);
+        pthread_cond_init(&par.turn, NULL);
+#endif
+
+        par.pass = PASS_COUNT_DQUOTES;
+        parallel_run(&par, threads);
+
+        parallel_resolve_boundaries(&par);
+
+        par.pass = PASS_PARSE;
+        parallel_run(&par, threads);
+
+#ifdef CSV_POSIX
+        pthread_mutex_destroy(&par.lock);
+        pthread_cond_destroy(&par.turn);
+#endif
+
+        free(par.chunks);
+        merge_stats(reader, &pc);
+        parsing_context_destroy(&pc);
+}
+
+int csv_reader_parse_parallel(CsvReader *reader, const char *path, int threads, int ordered)
+{
+#ifdef CSV_POSIX
+        const char *data;
+        size_t len;
+
+        if (map_file(path, &data, &len) < 0)
+                return -1;
+
+        csv_reader_parse_memory_parallel(reader, data, len, threads, ordered);
+        unmap_file(data, len);
+        return 0;
+#else
+        return csv_reader_parse_path(reader, path);
+#endif
+}
+
+// Private Implementation
+
+void parallel_run(ParallelContext *par, int threads)
+{
+#ifdef CSV_POSIX
+        pthread_t *workers = malloc(sizeof(pthread_t) * (size_t) threads);
+        int started;
+        int i;
+
+        if (workers == NULL) {
+                perror("Cannot alloc memory buffer for csv parsing");
+                abort();
+        }
+
+        par->nextChunk = 0;
+        par->nextDelivery = 0;
+
+        for (started = 0; started < threads; started++) {
+                if (pthread_create(&workers[started], NULL, &parallel_worker, par) != 0)
+                        break;
+        }
+
+        // If no thread could be started, the chunks are processed here
+        if (started == 0)
+                parallel_worker(par);
+
+        for (i = 0; i < started; i++) {
+                pthread_join(workers[i], NULL);
+        }
+
+        free(workers);
+#endif
+}
+
+void *parallel_worker(void *arg)
+{
+        ParallelContext *par = arg;
+        ParsingContext pc;
+        ChunkRecords store;
+        size_t chunk;
+
+        if (par->pass == PASS_COUNT_DQUOTES) {
+                while ((chunk = parallel_next_chunk(par)) < par->chunkCount) {
+                        size_t end = chunk + 1 < par->chunkCount ? par->chunks[chunk + 1].nominalStart : par->length;
+                        par->chunks[chunk].dquotes = scan_count_quotes(par->data + par->chunks[chunk].nominalStart,
+                                                                       end - par->chunks[chunk].nominalStart,
+                                                                       &par->headerContext->scanChars);
+                }
+                return NULL;
+        }
+
+        parsing_context_init(par->reader, &pc);
+        store_header(&pc, par->header);
+        if (par->headerContext->projection != NULL)
+                set_projection(&pc, par->headerContext->projection,
+                               par->headerContext->projectionColumns, par->headerContext->projectionCount);
+        if (par->headerContext->filters != NULL)
+                set_filters(&pc, par->headerContext->filters, par->headerContext->filterCount);
+        pc.data = par->data;
+
+        store.fields = NULL;
+        store.fieldCount = 0;
+        store.fieldSize = 0;
+        store.records = NULL;
+        store.recordCount = 0;
+        store.recordSize = 0;
+        store.escaped = NULL;
+
+        while ((chunk = parallel_next_chunk(par)) < par->chunkCount) {
+                if (par->ordered)
+                        parallel_parse_chunk_ordered(par, &pc, chunk, &store);
+                else
+                        parallel_parse_chunk(par, &pc, &par->chunks[chunk]);
+        }
+
+        flush_batch(par->reader, &pc);
+
+#ifdef CSV_POSIX
+        pthread_mutex_lock(&par->lock);
+#endif
+        merge_stats(par->reader, &pc);
+#ifdef CSV_POSIX
+        pthread_mutex_unlock(&par->lock);
+#endif
+
+        free(store.fields);
+        free(store.records);
+        if (store.escaped != NULL)
+                buffer_free(store.escaped);
+
+        parsing_context_destroy(&pc);
+        return NULL;
+}
+
+size_t parallel_next_chunk(ParallelContext *par)
+{
+        size_t chunk;
+
+#ifdef CSV_POSIX
+        pthread_mutex_lock(&par->lock);
+#endif
+        chunk = par->nextChunk;
+        if (chunk < par->chunkCount)
+                par->nextChunk += 1;
+#ifdef CSV_POSIX
+        pthread_mutex_unlock(&par->lock);
+#endif
+        return chunk;
+}
+
+void parallel_resolve_boundaries(ParallelContext *par)
+{
+        const ScanChars *chars = &par->headerContext->scanChars;
+        size_t dquotes = 0;
+        size_t position;
+        size_t previous = par->chunks[0].nominalStart;
+        int escaping;
+        size_t i;
+
+        for (i = 0; i < par->chunkCount; i++) {
+                position = par->chunks[i].nominalStart;
+                escaping = dquotes & 1;
+                dquotes += par->chunks[i].dquotes;
+
+                // The first chunk starts right after the header
+                if (i > 0) {
+                        for (; position < par->length; position++) {
+                                if (chars->quote != 0 && par->data[position] == chars->quote) {
+                                        escaping = !escaping;
+                                } else if (par->data[position] == chars->newLine && !escaping) {
+                                        position++;
+                                        break;
+                                }
+                        }
+                }
+
+                if (position < previous)
+                        position = previous;
+
+                par->chunks[i].start = position;
+                previous = position;
+        }
+
+        for (i = 0; i < par->chunkCount; i++) {
+                par->chunks[i].end = i + 1 < par->chunkCount ? par->chunks[i + 1].start : par->length;
+        }
+}
+
+void parallel_parse_chunk(ParallelContext *par, ParsingContext *pc, Chunk *chunk)
+{
+        // The chunk is parsed as if it were the whole input, but the bytes
+        // after its end can be read by the scanner
+        pc->length = chunk->end;
+        pc->padding = par->length - chunk->end;
+        pc->bufferPosition = chunk->start;
+        pc->scanBlock = NO_SCAN_BLOCK;
+        pc->flags &= ~PROCESSED_ALL_RECORDS;
+
+        if (chunk->start >= chunk->end)
+                return;
+
+        while (get_next_record(pc)) {
+                emit_record(par->reader, pc);
+        }
+}
+
+void parallel_parse_chunk_ordered(ParallelContext *par, ParsingContext *pc, size_t chunk, ChunkRecords *store)
+{
+        Chunk *current = &par->chunks[chunk];
+        size_t field = 0;
+        size_t i;
+        size_t j;
+        const char *base;
+
+        pc->length = current->end;
+        pc->padding = par->length - current->end;
+        pc->bufferPosition = current->start;
+        pc->scanBlock = NO_SCAN_BLOCK;
+        pc->flags &= ~PROCESSED_ALL_RECORDS;
+
+        store->fieldCount = 0;
+        store->recordCount = 0;
+        if (store->escaped != NULL)
+                buffer_reset(store->escaped);
+
+        while (current->start < current->end && get_next_record(pc)) {
+                chunk_records_append(pc, store);
+        }
+
+#ifdef CSV_POSIX
+        pthread_mutex_lock(&par->lock);
+        while (par->nextDelivery != chunk)
+                pthread_cond_wait(&par->turn, &par->lock);
+        pthread_mutex_unlock(&par->lock);
+#endif
+
+        for (i = 0; i < store->recordCount; i++) {
+                record_view_reset(pc->view);
+                for (j = 0; j < store->records[i]; j++, field++) {
+                        base = store->fields[field].escaped ? store->escaped->buffer : par->data;
+                        record_view_append(pc->view, base + store->fields[field].offset, store->fields[field].length);
+                }
+                emit_view(par->reader, pc);
+                // The chunks are delivered one at a time
+                par->reader->control &= ~CONTROL_SKIP;
+        }
+
+        // The next chunk is delivered by another worker
+        flush_batch(par->reader, pc);
+
+#ifdef CSV_POSIX
+        pthread_mutex_lock(&par->lock);
+        par->nextDelivery += 1;
+        pthread_cond_broadcast(&par->turn);
+        pthread_mutex_unlock(&par->lock);
+#endif
+}
+
+void chunk_records_append(ParsingContext *pc, ChunkRecords *store)
+{
+        FieldSpan *field;
+        size_t i;
+
+        if (store->recordCount >= store->recordSize) {
+                size_t newSize = store->recordSize ? 2 * store->recordSize : RECORD_SIZE;
+                size_t *newRecords = realloc(store->records, newSize * sizeof *store->records);
+                if (newRecords == NULL) {
+                        perror("Cannot alloc memory buffer for csv parsing");
+                        abort();
+                }
+                store->records = newRecords;
+                store->recordSize = newSize;
+        }
+
+        if (store->fieldCount + pc->fieldCount > store->fieldSize) {
+                size_t newSize = store->fieldSize ? store->fieldSize : RECORD_SIZE;
+                FieldSpan *newFields;
+
+                while (newSize < store->fieldCount + pc->fieldCount)
+                        newSize *= 2;
+
+                newFields = realloc(store->fields, newSize * sizeof *store->fields);
+                if (newFields == NULL) {
+                        perror("Cannot alloc memory buffer for csv parsing");
+                        abort();
+                }
+                store->fields = newFields;
+                store->fieldSize = newSize;
+        }
+
+        for (i = 0; i < pc->fieldCount; i++) {
+                field = &store->fields[store->fieldCount + i];
+                *field = pc->fields[i];
+
+                // Unescaped fields are moved from the secondary buffer to the store
+                if (field->escaped) {
+                        if (store->escaped == NULL)
+                                store->escaped = buffer_alloc(field->length + 1);
+                        if (store->escaped == NULL ||
+                            buffer_append_str(store->escaped, pc->secondaryBuffer->buffer + field->offset, field->length) == NULL) {
+                                perror("Cannot alloc memory buffer for csv parsing");
+                                abort();
+                        }
+                        field->offset = store->escaped->stringLength - field->length;
+                }
+        }
+
+        store->fieldCount += pc->fieldCount;
+        store->records[store->recordCount] = pc->fieldCount;
+        store->recordCount += 1;
+}
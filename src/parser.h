@@ -0,0 +1,726 @@
+//
+// Created by Davide on 16/10/2026.
+//
+
+#ifndef C_CSV__PARSER_H
+#define C_CSV__PARSER_H
+
+#include <ctype.h>
+#include <string.h>
+#include <time.h>
+#include "../include/csv.h"
+#include "scan.h"
+#include "columns.h"
+#include "cache.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CSV_POSIX
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#define BUFFER_SIZE 2
+#define RECORD_SIZE 2
+#define BLOCK_SIZE (1 << 20)
+#define BATCH_SIZE 1024
+
+#define HEADER_FOUND 0X01
+#define PROCESSED_ALL_RECORDS 0x02
+#define ESCAPING 0x04
+#define DQUOTE_FOUND 0x08
+#define IN_RECORD 0x10
+#define ESCAPED_FIELD 0x20
+#define FEEDING 0x40
+#define FEED_FINISHED 0x80
+#define WAITING_DATA 0x100
+#define REJECTED 0x200
+#define MULTILINE_RECORD 0x400
+#define STOPPED 0x800
+#define OWNS_INPUT 0x1000
+
+#define CONTROL_STOP 0x01
+#define CONTROL_SKIP 0x02
+#define CONTROL_PAUSE 0x04
+
+#define NEW_LINE 10
+#define CARRIAGE_RETURN 13
+
+#define is_blank(c) ((c) == ' ' || (c) == '\t')
+#define is_waiting(pc) ((pc)->flags & WAITING_DATA)
+// The current record is delivered to the next callbacks (see csv_reader_skip_record)
+#define is_delivered(reader) (!((reader)->control & (CONTROL_STOP | CONTROL_SKIP)))
+
+#define FIND_SEPARATOR 0x01
+#define FIND_LINE_ENDING 0x02
+#define FIND_DQUOTE 0x04
+#define FIND_ESCAPE 0x08
+#define NO_SCAN_BLOCK ((size_t) -1)
+#define NOT_SELECTED ((size_t) -1)
+
+#ifdef CSV_STATS
+#define stats_add(pc, counter, n) ((pc)->stats.counter += (n))
+#define stats_max(pc, counter, n) ((pc)->stats.counter = (n) > (pc)->stats.counter ? (n) : (pc)->stats.counter)
+#define timed_callback(reader, pc, call) do { \
+        if ((reader)->statsTiming) { \
+                double start_ = stats_clock(); \
+                call; \
+                (pc)->stats.callbackTime += stats_clock() - start_; \
+        } else { \
+                call; \
+        } \
+} while (0)
+#else
+#define stats_add(pc, counter, n) ((void) 0)
+#define stats_max(pc, counter, n) ((void) 0)
+#define timed_callback(reader, pc, call) call
+#endif
+
+#define is_selected(pc) ((pc)->projection == NULL || \
+                         ((pc)->column < (pc)->projectionColumns && (pc)->projection[(pc)->column] != NOT_SELECTED))
+
+/**
+ * Position of a parsed field, as an offset from the beginning of the
+ * input data (or of the secondary buffer if the field has been unescaped).
+ * Offsets are used instead of pointers because the buffers may be moved by
+ * realloc (or compacted) while the record is being read
+ */
+typedef struct {
+        size_t offset;
+        size_t length;
+        char escaped;
+} FieldSpan;
+
+/**
+ * A predicate of the reader, resolved against the header.
+ * column is the index of the column in the file, NOT_SELECTED if the
+ * header does not contain it
+ */
+typedef struct {
+        size_t column;
+        const Predicate *predicate;
+} FieldFilter;
+
+/**
+ * The blocks of a stream read in advance by a background thread
+ * (see csv_reader_set_read_ahead), private to prefetch.c
+ */
+typedef struct Prefetch_s Prefetch;
+
+/**
+ * This structure encapsulate some data
+ * structures used throughout the parsing process
+ *
+ * @param data, length The input the parser is reading: the input buffer when
+ *                     reading from a stream, the whole input when parsing
+ *                     from memory
+ *
+ * @param padding number of bytes after length which can be read (but whose
+ *                value is meaningless)
+ *
+ * @param buffer the input buffer, a sliding window on the stream. It is
+ *               filled blockSize bytes at a time; when it is refilled the
+ *               current record is moved at its beginning, so the record is
+ *               always stored contiguously and the buffer never holds more
+ *               than blockSize bytes plus the longest record.
+ *               NULL when parsing from memory
+ *
+ * @param blockSize number of bytes read from the stream at a time
+ *
+ * @param prefetch the blocks read ahead of the parser, NULL if the stream
+ *                 is read by the parser itself. When it is not NULL, data
+ *                 is either a block of prefetch or the input buffer
+ *
+ * @param record A dynamic array of strings.
+ *               Once a CSV record has been completely read by the
+ *               parser, this array contains the fields of that record.
+ *               This pointer is then passed as an argument to the
+ *               recordCallback function to process its data.
+ *
+ * @param header A dynamic array of strings which stores the fields
+ *               of the CSV header
+ *
+ * @param view, headerView Views on the current record and on the header,
+ *                         passed to the view callbacks
+ *
+ * @param columns The names of the header, referenced by the records and
+ *                by the header. NULL until the header is read
+ *
+ * @param fields The fields of the current record, as positions in buffer or
+ *               in secondaryBuffer
+ *
+ * @param projection If columns are selected, maps the index of each of the
+ *                   projectionColumns columns of the file to the index of
+ *                   its field in the record, or to NOT_SELECTED.
+ *                   Records have projectionCount fields.
+ *                   NULL if all the columns are read
+ *
+ * @param column index of the current field in the file, which differs from
+ *               fieldCount when columns are selected
+ *
+ * @param filters The filterCount predicates the records must satisfy
+ *
+ * @param stats the statistics of the parsing, added to those of the reader
+ *              by merge_stats. startTime is the time the parsing began
+ *
+ * @param secondaryBuffer Stores the quoted fields which contain escaped
+ *                        double quotes, once unescaped
+ *
+ * @param batch The records not delivered yet to the batch callback, NULL
+ *              until the first record is read
+ *
+ * @param recordBatch The records not delivered yet to the row major batch
+ *                    callback, NULL until the first record is read
+ *
+ * @param flags The first eleven bits holds some information on the parser state.
+ *               - HEADER_FOUND: The first record (header) has been processed.
+ *               - PROCESSED_ALL_RECORDS: EOF has been reached
+ *               - ESCAPING: The character that the parser is reading is
+ *                           enclosed in quotes and must be escaped
+ *                           accordingly to the syntax of the dialect;
+ *               - DQUOTE_FOUND: Two consecutive quotes (or an escape
+ *                               character) are found in the current field.
+ *                               When this happens, the field is unescaped
+ *                               in the secondary buffer.
+ *               - IN_RECORD: A record has been partially read
+ *               - ESCAPED_FIELD: The closing double quote of the current
+ *                                field has been read, the characters up to
+ *                                the next separator are discarded
+ *               - FEEDING: The input is pushed with csv_reader_feed
+ *               - FEED_FINISHED: csv_reader_finish has been invoked
+ *               - WAITING_DATA: The input pushed so far has been consumed,
+ *                               parsing is suspended until more is fed
+ *               - REJECTED: A field of the current record does not satisfy
+ *                           a predicate, the rest of the record is skipped
+ *               - MULTILINE_RECORD: A quoted field of the current record
+ *                                   contains a new line
+ *               - STOPPED: A callback has stopped the parsing (see
+ *                          csv_reader_stop), fed input is ignored
+ *               - OWNS_INPUT: The input has been opened by the parser:
+ *                             currentCsv is closed, or data is unmapped,
+ *                             when the context is destroyed
+ *              Remaining bits are currently unused.
+ *              Together with the positions, the flags are the whole state of
+ *              the parser: get_next_record can be suspended anywhere in a
+ *              record and resumed later.
+ *
+ * @param currentCsv FILE * pointer of the CSV file to parse, NULL when
+ *                   parsing from memory or from a file descriptor
+ * @param fd file descriptor of the CSV file to parse, -1 when parsing from
+ *           memory or from a FILE *
+ * @param consumed offset in the input of the first character of data: the
+ *                 number of bytes discarded by compact_buffer
+ * @param bodyStart offset in the input of the first record after the header
+ * @param recordStart offset of the first character of the current record
+ * @param fieldStart offset of the first character of the current field
+ * @param bufferPosition store the current position in data
+ * @param escapedLength length of the current field up to the end of its
+ *                      last escape sequence
+ * @param scanBlock offset of the block of data classified in
+ *                  scanMasks, NO_SCAN_BLOCK if the masks are not valid
+ * @param dialect the syntax of the input, parsed by the parser specialized
+ *                for dialectKind (see dialect_kind)
+ * @param scanChars the structural characters of the dialect
+ * @param dictionaries the dictionary of each of the dictionaryCount fields
+ *                     of the view, NULL for the columns which are not
+ *                     interned. NULL if no column is interned
+ * @param allocator the allocator of the reader, NULL for malloc
+ * @param cache the cache the records are read from instead of data (see
+ *              csv_reader_set_cache), NULL when parsing text. data is then
+ *              the text of the cache, and cacheRecord the index of the
+ *              next record to read
+ * @param typedColumns the typed column of the cache of each of the
+ *                     typedCount fields of the view, NULL until the first
+ *                     record is added to a batch
+ */
+typedef struct ParsingContext_s {
+        FILE *currentCsv;
+        int fd;
+        const Allocator *allocator;
+        const char *data;
+        size_t length;
+        size_t padding;
+        Buffer *buffer;
+        size_t blockSize;
+        Prefetch *prefetch;
+        Record *record;
+        Record *header;
+        RecordView *view;
+        RecordView *headerView;
+        ColumnMap *columns;
+        Dictionary **dictionaries;
+        size_t dictionaryCount;
+
+        size_t consumed;
+        size_t bodyStart;
+        size_t recordStart;
+        size_t fieldStart;
+        size_t bufferPosition;
+        size_t escapedLength;
+        size_t scanBlock;
+        ScanMasks scanMasks;
+
+        Dialect dialect;
+        int dialectKind;
+        ScanChars scanChars;
+
+        FieldSpan *fields;
+        size_t fieldCount;
+        size_t fieldSize;
+
+        size_t *projection;
+        size_t projectionColumns;
+        size_t projectionCount;
+        size_t column;
+
+        FieldFilter *filters;
+        size_t filterCount;
+
+        CsvStats stats;
+        double startTime;
+
+        Buffer *secondaryBuffer;
+        Batch *batch;
+        RecordBatch *recordBatch;
+        int flags;
+
+        Cache *cache;
+        size_t cacheRecord;
+        const TypedColumn **typedColumns;
+        size_t typedCount;
+} ParsingContext;
+
+
+// Private prototypes
+
+/**
+ * Execute the callback function for the currently stored record,
+ * then resets the record buffer
+ * @param reader the CsvReader
+ * @param pc the current parsing context
+ */
+void emit_record(CsvReader *reader, ParsingContext *pc);
+
+/**
+ * Execute the callback function for the record stored in the view of the
+ * parsing context. The first record is stored as the header. The control
+ * of the reader is only read, since the workers of a parallel parsing
+ * share it: the caller clears the skip request after each record
+ * @param reader the CsvReader
+ * @param pc the current parsing context
+ */
+void emit_view(CsvReader *reader, ParsingContext *pc);
+
+/**
+ * Append the record stored in the view of the parsing context to the
+ * batch, delivering the batch when it is full
+ * @param reader the CsvReader
+ * @param pc the current parsing context
+ */
+void append_batch(CsvReader *reader, ParsingContext *pc);
+
+/**
+ * Append the record stored in the view of the parsing context to the
+ * row major batch, delivering the batch when it is full
+ * @param reader the CsvReader
+ * @param pc the current parsing context
+ */
+void append_record_batch(CsvReader *reader, ParsingContext *pc);
+
+/**
+ * Deliver the records still stored in the parsing context (see
+ * flush_batch) and add its statistics to those of the reader
+ * @param reader the CsvReader
+ * @param pc the current parsing context
+ */
+void end_parsing(CsvReader *reader, ParsingContext *pc);
+
+/**
+ * Add the statistics of a parsing context to those of the reader
+ * @param reader the CsvReader
+ * @param pc the parsing context
+ */
+void merge_stats(CsvReader *reader, ParsingContext *pc);
+
+/**
+ * Update the statistics at the end of a record
+ * @param pc the parsing context
+ */
+void stats_record(ParsingContext *pc);
+
+/**
+ * @return the time of a monotonic clock, in seconds
+ */
+double stats_clock(void);
+
+/**
+ * Deliver the records stored in the batches, if any
+ * @param reader the CsvReader
+ * @param pc the current parsing context
+ */
+void flush_batch(CsvReader *reader, ParsingContext *pc);
+
+/**
+ * Store the record in the view of the parsing context as the header. If
+ * columns are selected, they are resolved against the header and the
+ * header is projected accordingly
+ * @param reader the CsvReader
+ * @param pc the current parsing context
+ */
+void resolve_header(CsvReader *reader, ParsingContext *pc);
+
+/**
+ * Find the dictionaries of the interned columns among the columns of the
+ * header (see csv_reader_intern_column)
+ * @param reader the CsvReader
+ * @param pc the current parsing context, whose header is stored
+ */
+void resolve_dictionaries(CsvReader *reader, ParsingContext *pc);
+
+/**
+ * Copy the fields of the view of the parsing context in its record,
+ * interning the values of the interned columns
+ * @param pc the current parsing context
+ */
+void build_record(ParsingContext *pc);
+
+/**
+ * Set the projection of a parsing context (see ParsingContext)
+ * @param pc the parsing context
+ * @param projection the index of the field of each column, it is copied
+ * @param columns the number of columns
+ * @param count the number of fields of a record
+ */
+void set_projection(ParsingContext *pc, const size_t *projection, size_t columns, size_t count);
+
+/**
+ * Resolve the predicates of the reader against the header stored in the
+ * view of the parsing context
+ * @param reader the CsvReader
+ * @param pc the current parsing context
+ */
+void resolve_filters(CsvReader *reader, ParsingContext *pc);
+
+/**
+ * Set the predicates of a parsing context
+ * @param pc the parsing context
+ * @param filters the predicates, they are copied
+ * @param count the number of predicates
+ */
+void set_filters(ParsingContext *pc, const FieldFilter *filters, size_t count);
+
+/**
+ * Check a field against the predicates on its column, setting REJECTED if
+ * it does not satisfy one of them
+ * @param pc the parsing context
+ * @param column the index of the column of the field
+ * @param field the field
+ * @param length the length of the field
+ */
+void filter_field(ParsingContext *pc, size_t column, const char *field, size_t length);
+
+/**
+ * Check if the record just read satisfies all the predicates. The
+ * predicates on the columns missing from the record are checked against
+ * an empty field
+ * @param pc the parsing context
+ * @return 1 if the record must be delivered, 0 if it must be skipped
+ */
+int accept_record(ParsingContext *pc);
+
+/**
+ * Check if the current field is stored: it is not if it belongs to a column
+ * which is not selected and which has no predicates, or if the record has
+ * been rejected
+ * @param pc the parsing context
+ * @return 1 if the field is needed, 0 otherwise
+ */
+int field_needed(ParsingContext *pc);
+
+/**
+ * Move the parsing context to the starting record of the reader, if any
+ * (see csv_reader_seek_record)
+ * @param reader the CsvReader
+ * @param pc the parsing context, the header must have been read
+ */
+void apply_seek(CsvReader *reader, ParsingContext *pc);
+
+/**
+ * Check that an index has been built on the input of a parsing context,
+ * comparing the length of the input with the one recorded in the index.
+ * The length of a stream is the size of its file: streams which are not
+ * regular files are not checked
+ * @param pc the parsing context
+ * @param index the index, may be NULL
+ * @return 0 if the index matches the input, -1 otherwise (errno is set to
+ *         EINVAL)
+ */
+int check_index(ParsingContext *pc, const RecordIndex *index);
+
+/**
+ * Move the parsing context to a record
+ * @param pc the parsing context, the header must have been read
+ * @param index the index of the input, may be NULL
+ * @param record the index of the record
+ * @return 0 on success, -1 if the record cannot be reached
+ */
+int seek_record(ParsingContext *pc, const RecordIndex *index, size_t record);
+
+/**
+ * Skip records without parsing them: their ends are found from the line
+ * endings and the parity of the quotes, 64 bytes at a time. Dialects with
+ * an escape character other than the quote, and fed input, are parsed
+ * instead; records read from a cache are skipped by index. Skipped
+ * records are not checked against the predicates
+ * @param pc the parsing context, at the beginning of a record
+ * @param count the number of records to skip
+ * @return the number of records skipped, fewer than count at the end of
+ *         the input
+ */
+size_t skip_records(ParsingContext *pc, size_t count);
+
+/**
+ * Move the parsing context to the beginning of a record
+ * @param pc the parsing context
+ * @param offset the offset of the record in the input
+ * @return 0 on success, -1 if the stream cannot be repositioned
+ */
+int seek_offset(ParsingContext *pc, size_t offset);
+
+/**
+ * Map the cache of a csv file, writing it first if it is missing or if it
+ * does not match the file (see csv_reader_set_cache)
+ * @param reader the CsvReader, whose dialect the file is parsed with
+ * @param path the path of the csv file
+ * @return the cache, or NULL if it cannot be read nor written
+ */
+Cache *load_cache(CsvReader *reader, const char *path);
+
+/**
+ * Read the records of a parsing context from a cache
+ * @param pc the parsing context, at the beginning of the input
+ * @param cache the cache, freed with the context
+ */
+void set_cache(ParsingContext *pc, Cache *cache);
+
+/**
+ * Read the next record from the cache of the parsing context, as
+ * get_next_record does from the text: its fields are stored in the
+ * context, and the records which do not satisfy the predicates are skipped
+ * @param pc the parsing context
+ * @return 1 if a record has been read, 0 at the end of the cache
+ */
+int get_cached_record(ParsingContext *pc);
+
+/**
+ * Find the typed columns of the cache of the parsing context which
+ * correspond to the fields of the view
+ * @param pc the parsing context, whose header is stored
+ */
+void resolve_typed_columns(ParsingContext *pc);
+
+/**
+ * Copy a record in the header of the parsing context
+ * @param pc the current parsing context
+ * @param header the header fields
+ */
+void store_header(ParsingContext *pc, RecordView *header);
+
+/**
+ * Store the position of a field of the current record. If columns are
+ * selected, the field is stored in its slot, or discarded
+ * @param pc the current parsing context
+ * @param offset offset of the field in data (or in the secondary buffer)
+ * @param length length of the field
+ * @param escaped 1 if the field is stored in the secondary buffer
+ */
+void emit_field(ParsingContext *pc, size_t offset, size_t length, char escaped);
+
+/**
+ * Read the next block of the stream in the input buffer (see compact_buffer).
+ * When the input is fed, no data is read: WAITING_DATA is set instead,
+ * unless the feed is finished
+ * @param pc parsing context
+ * @return the number of bytes read, 0 on EOF, when parsing from memory or
+ *         when waiting for data to be fed
+ */
+size_t fill_buffer(ParsingContext *pc);
+
+/**
+ * Discard the data preceding the current record, moving the record at the
+ * beginning of the input buffer: all the offsets stored in the parsing
+ * context are updated accordingly
+ * @param pc parsing context
+ */
+void compact_buffer(ParsingContext *pc);
+
+/**
+ * Discard the first shift bytes of data from the positions stored in the
+ * parsing context, whose data is going to begin shift bytes later
+ * @param pc parsing context
+ * @param shift number of bytes discarded
+ */
+void shift_offsets(ParsingContext *pc, size_t shift);
+
+/**
+ * Allocate the slots where a background thread reads a stream ahead of the
+ * parser. The thread is started by the first prefetch_fill
+ * @param pc the parsing context, reading from a stream
+ * @param blocks number of blocks read in advance
+ * @return the read-ahead state, NULL if threads are not available
+ */
+Prefetch *prefetch_alloc(ParsingContext *pc, size_t blocks);
+
+/**
+ * Stop the background thread and release its slots
+ * @param prefetch the read-ahead state, it may be NULL
+ */
+void prefetch_free(Prefetch *prefetch);
+
+/**
+ * Make the next block read by the background thread the data of the
+ * parsing context (see fill_buffer), waiting for it if it is not ready.
+ * Only the current record is copied, in front of the block
+ * @param pc parsing context
+ * @return the number of bytes read, 0 on EOF
+ */
+size_t prefetch_fill(ParsingContext *pc);
+
+/**
+ * Stop the background thread, discarding the blocks it has read in advance.
+ * The thread waits for the read in progress to complete. The next
+ * prefetch_fill restarts it
+ * @param prefetch the read-ahead state
+ * @return the offset in the input of the position of the stream
+ */
+size_t prefetch_stop(Prefetch *prefetch);
+
+/**
+ * Read at most len bytes from the stream
+ * @param pc parsing context
+ * @param destination where the data is stored
+ * @param len maximum number of bytes to read
+ * @return the number of bytes read, 0 on EOF
+ */
+size_t read_stream(ParsingContext *pc, char *destination, size_t len);
+
+/**
+ * Read a whole record, storing its fields in the parsing context.
+ * If the input is fed and it ends in the middle of the record, the function
+ * returns 0 with WAITING_DATA set, and the next invocation resumes the record.
+ * The record is read by the parser of the dialect (see parser_dialect.h),
+ * or from the cache of the context (see get_cached_record)
+ * @param pc parsing context
+ * @return 0 if there are no more records, 1 otherwise
+ */
+int get_next_record(ParsingContext *pc);
+
+/**
+ * Parse the records of the input of a parsing context, until its end or
+ * until a callback stops or pauses the parsing (see csv_reader_stop).
+ * At the end of the input the parsing is ended (see end_parsing), unless
+ * more input may be fed
+ * @param reader the CsvReader
+ * @param pc the parsing context
+ * @return CSV_END, CSV_STOPPED or CSV_PAUSED
+ */
+int parse_records(CsvReader *reader, ParsingContext *pc);
+
+/**
+ * Parse the records of a parsing context allocated with
+ * parsing_context_alloc, which is released unless the parsing is paused:
+ * it is then kept in the reader until it is resumed
+ * @param reader the CsvReader
+ * @param pc the parsing context
+ * @return CSV_END, CSV_STOPPED or CSV_PAUSED
+ */
+int run_parsing(CsvReader *reader, ParsingContext *pc);
+
+/**
+ * Check that the configuration of a reader can be changed: a paused
+ * parsing, or the input being fed, keeps pointers to its predicates, its
+ * dictionaries and its allocator
+ * @param reader the CsvReader
+ * @return 0 if it can be changed, -1 with errno set to EBUSY otherwise
+ */
+int check_reader_idle(const CsvReader *reader);
+
+/**
+ * Release the parsing paused in a reader, if any
+ * @param reader the CsvReader
+ */
+void discard_paused(CsvReader *reader);
+
+/**
+ * Resolve the positions of the fields of the current record into a view
+ * @param pc parsing context
+ * @param view the record view
+ */
+void resolve_fields(ParsingContext *pc, RecordView *view);
+
+/**
+ * Allocate the data structures of a parsing context
+ * @param reader the CsvReader
+ * @param pc the parsing context
+ */
+void parsing_context_init(CsvReader *reader, ParsingContext *pc);
+
+/**
+ * Allocate and initialize a parsing context in the heap, so that it can
+ * outlive the call which started the parsing. The parsing paused in the
+ * reader, if any, is discarded
+ * @param reader the CsvReader
+ * @return the parsing context, to be released with parsing_context_destroy
+ *         and free
+ */
+ParsingContext *parsing_context_alloc(CsvReader *reader);
+
+/**
+ * Allocate the input buffer of a parsing context which reads from a stream
+ * (currentCsv or fd must be set by the caller)
+ * @param reader the CsvReader
+ * @param pc the parsing context
+ */
+void parsing_context_init_stream(CsvReader *reader, ParsingContext *pc);
+
+/**
+ * Release the data structures of a parsing context
+ * @param pc the parsing context
+ */
+void parsing_context_destroy(ParsingContext *pc);
+
+/**
+ * Map a file in memory for sequential reading
+ * @param path the path of the file
+ * @param data output, the content of the file
+ * @param len output, the length of the file
+ * @return 0 on success, -1 on error (errno is set accordingly)
+ */
+int map_file(const char *path, const char **data, size_t *len);
+
+/**
+ * Unmap a file mapped with map_file
+ * @param data the content of the file
+ * @param len the length of the file
+ */
+void unmap_file(const char *data, size_t len);
+
+char current_char(ParsingContext *pc);
+char lookahead(ParsingContext *pc);
+
+/**
+ * A pull parser: the parsing context is advanced one record at a time
+ * by csv_iterator_next
+ *
+ * @param reader the reader which provides the configuration
+ * @param pc the parsing context, which owns the input opened by
+ *           csv_iterator_open_path (see OWNS_INPUT)
+ */
+struct CsvIterator_s {
+        CsvReader *reader;
+        ParsingContext pc;
+};
+
+#endif //C_CSV__PARSER_H
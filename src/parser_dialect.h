@@ -0,0 +1,358 @@
+//
+// Created by Davide on 16/10/2026.
+//
+
+// The record parser of a dialect. This file has no include guard: csv.c
+// includes it once for each dialect, after defining
+//  - DIALECT_NAME(name): the name of a function of the parser
+//  - DIALECT_SEPARATOR(pc), DIALECT_QUOTE(pc), DIALECT_ESCAPE(pc),
+//    DIALECT_LINE_ENDING(pc), DIALECT_TRIM(pc): the fields of the dialect
+//    (see Dialect). Those not defined take the RFC 4180 value.
+//  - DIALECT_SCAN: the function classifying a block (see scan_block)
+// When they are constants, the compiler folds the checks of the features
+// the dialect does not use. All the macros are undefined at the end
+
+#ifndef DIALECT_QUOTE
+#define DIALECT_QUOTE(pc) '"'
+#endif
+
+#ifndef DIALECT_ESCAPE
+#define DIALECT_ESCAPE(pc) '"'
+#endif
+
+#ifndef DIALECT_LINE_ENDING
+#define DIALECT_LINE_ENDING(pc) DIALECT_LINE_ANY
+#endif
+
+#ifndef DIALECT_TRIM
+#define DIALECT_TRIM(pc) 0
+#endif
+
+#define DIALECT_NEW_LINE(pc) (DIALECT_LINE_ENDING(pc) == DIALECT_LINE_CR ? CARRIAGE_RETURN : NEW_LINE)
+#define DIALECT_ESCAPING(pc) (DIALECT_ESCAPE(pc) != 0 && DIALECT_ESCAPE(pc) != DIALECT_QUOTE(pc))
+
+// Private prototypes
+
+/**
+ * Move bufferPosition to the first structural character at or after it,
+ * classifying data SCAN_BLOCK_SIZE bytes at a time and reading more data
+ * if needed. At EOF bufferPosition is moved to length
+ * @param pc parsing context
+ * @param find the characters to look for, a combination of FIND_SEPARATOR,
+ *             FIND_LINE_ENDING, FIND_DQUOTE and FIND_ESCAPE
+ */
+void DIALECT_NAME(find_structural)(ParsingContext *pc, int find);
+
+/**
+ * Read a whole record, see get_next_record
+ * @param pc parsing context
+ * @return 0 if there are no more records, 1 otherwise
+ */
+int DIALECT_NAME(get_next_record)(ParsingContext *pc);
+
+/**
+ * Read the rest of a quoted field. fieldStart must point to the first
+ * character after the opening quote, when the function returns
+ * bufferPosition points to the first character after the closing quote
+ * @param pc parsing context
+ * @return 1 if the field has been read, 0 if waiting for more data
+ */
+int DIALECT_NAME(get_escaped_sequence)(ParsingContext *pc);
+
+/**
+ * Skip the escape character at bufferPosition and the character it escapes
+ * @param pc parsing context
+ * @return 1 on success, 0 if waiting for more data
+ */
+int DIALECT_NAME(skip_escape)(ParsingContext *pc);
+
+/**
+ * Store the unquoted field which ends at bufferPosition, removing the
+ * carriage return before the line ending and the spaces around the field
+ * if required by the dialect
+ * @param pc parsing context
+ * @param c the character at bufferPosition
+ */
+void DIALECT_NAME(end_field)(ParsingContext *pc, char c);
+
+/**
+ * Copy a field in the secondary buffer, replacing each pair of quotes
+ * with a single one or removing the escape characters
+ * @param pc parsing context
+ * @param start offset of the first character of the field
+ * @param end offset of the character after the field
+ */
+void DIALECT_NAME(end_escaped_sequence)(ParsingContext *pc, size_t start, size_t end);
+
+
+// Private Implementation
+
+void DIALECT_NAME(find_structural)(ParsingContext *pc, int find)
+{
+        size_t block;
+        uint64_t mask;
+
+        for (;;) {
+                block = pc->bufferPosition & ~((size_t) SCAN_BLOCK_SIZE - 1);
+                mask = ~(uint64_t) 0 << (pc->bufferPosition - block);
+
+                for (; block < pc->length; block += SCAN_BLOCK_SIZE) {
+                        if (pc->scanBlock != block) {
+                                if (block + SCAN_BLOCK_SIZE <= pc->length + pc->padding)
+                                        DIALECT_SCAN(pc->data + block, &pc->scanChars, &pc->scanMasks);
+                                else
+                                        scan_partial_block(pc->data + block, pc->length - block,
+                                                           &pc->scanChars, &pc->scanMasks);
+                                pc->scanBlock = block;
+                        }
+
+                        mask &= (find & FIND_SEPARATOR ? pc->scanMasks.separator : 0) |
+                                (find & FIND_LINE_ENDING ? pc->scanMasks.newLine : 0) |
+                                (find & FIND_DQUOTE ? pc->scanMasks.dquote : 0) |
+                                (find & FIND_ESCAPE ? pc->scanMasks.escape : 0);
+
+                        if (pc->length - block < SCAN_BLOCK_SIZE)
+                                mask &= ~(~(uint64_t) 0 << (pc->length - block));
+
+                        if (mask) {
+                                pc->bufferPosition = block + scan_first_bit(mask);
+                                return;
+                        }
+
+                        mask = ~(uint64_t) 0;
+                }
+
+                // Everything up to length has been classified, read some more data
+                pc->bufferPosition = pc->length;
+                if (fill_buffer(pc) == 0)
+                        return;
+        }
+}
+
+int DIALECT_NAME(get_next_record)(ParsingContext *pc)
+{
+        char c;
+
+        // Records which do not satisfy the predicates are skipped
+        do {
+                if (!(pc->flags & IN_RECORD)) {
+                        // The last record may have ended at EOF without a line ending
+                        if (pc->bufferPosition > pc->length)
+                                pc->bufferPosition = pc->length;
+
+                        pc->fieldCount = 0;
+                        pc->column = 0;
+                        pc->recordStart = pc->bufferPosition;
+
+                        if (pc->secondaryBuffer != NULL) {
+                                buffer_reset(pc->secondaryBuffer);
+                        }
+
+                        if (pc->bufferPosition >= pc->length && fill_buffer(pc) == 0) {
+                                if (!is_waiting(pc))
+                                        pc->flags |= PROCESSED_ALL_RECORDS;
+                                return 0;
+                        }
+
+                        pc->flags |= IN_RECORD;
+                        pc->flags &= ~MULTILINE_RECORD;
+                        pc->fieldStart = pc->bufferPosition;
+
+                        // Selected columns missing from the record are empty
+                        for (; pc->fieldCount < pc->projectionCount; pc->fieldCount++) {
+                                pc->fields[pc->fieldCount].offset = 0;
+                                pc->fields[pc->fieldCount].length = 0;
+                                pc->fields[pc->fieldCount].escaped = 0;
+                        }
+                }
+
+                for (;;) {
+                        if ((pc->flags & ESCAPING) && !DIALECT_NAME(get_escaped_sequence)(pc))
+                                return 0;
+
+                        if (pc->flags & ESCAPED_FIELD) {
+                                // Characters between the closing quote and the separator are discarded
+                                DIALECT_NAME(find_structural)(pc, FIND_SEPARATOR | FIND_LINE_ENDING);
+                                if (is_waiting(pc))
+                                        return 0;
+                                c = current_char(pc);
+                        } else {
+                                DIALECT_NAME(find_structural)(pc, FIND_SEPARATOR | FIND_LINE_ENDING | FIND_DQUOTE |
+                                                                  (DIALECT_ESCAPING(pc) ? FIND_ESCAPE : 0));
+                                if (is_waiting(pc))
+                                        return 0;
+                                c = current_char(pc);
+
+                                if (DIALECT_QUOTE(pc) != 0 && c == DIALECT_QUOTE(pc)) {
+                                        // Characters before the quote are discarded
+                                        pc->flags |= ESCAPING;
+                                        pc->flags &= ~DQUOTE_FOUND;
+                                        pc->bufferPosition += 1;
+                                        pc->fieldStart = pc->bufferPosition;
+                                        continue;
+                                } else if (DIALECT_ESCAPING(pc) && c == DIALECT_ESCAPE(pc)) {
+                                        if (!DIALECT_NAME(skip_escape)(pc))
+                                                return 0;
+                                        continue;
+                                }
+
+                                DIALECT_NAME(end_field)(pc, c);
+                        }
+
+                        pc->flags &= ~ESCAPED_FIELD;
+                        pc->bufferPosition += 1;
+                        pc->fieldStart = pc->bufferPosition;
+
+                        if (c != DIALECT_SEPARATOR(pc))
+                                break;
+                }
+
+                pc->flags &= ~IN_RECORD;
+                stats_record(pc);
+        } while (pc->filterCount > 0 && !accept_record(pc));
+
+        return 1;
+}
+
+int DIALECT_NAME(get_escaped_sequence)(ParsingContext *pc)
+{
+        while (pc->flags & ESCAPING) {
+                DIALECT_NAME(find_structural)(pc, FIND_DQUOTE | (DIALECT_ESCAPING(pc) ? FIND_ESCAPE : 0));
+
+                if (is_waiting(pc))
+                        return 0;
+
+                if (pc->bufferPosition >= pc->length) {
+                        // Unterminated quoted field
+                        break;
+                }
+
+                if (DIALECT_ESCAPING(pc)) {
+                        if (current_char(pc) == DIALECT_QUOTE(pc))
+                                pc->flags &= ~ESCAPING;
+                        else if (!DIALECT_NAME(skip_escape)(pc))
+                                return 0;
+                        continue;
+                }
+
+                // The lookahead may be in the next block
+                if (pc->bufferPosition + 1 >= pc->length) {
+                        fill_buffer(pc);
+                        if (is_waiting(pc))
+                                return 0;
+                }
+
+                if (DIALECT_ESCAPE(pc) != 0 && lookahead(pc) == DIALECT_QUOTE(pc)) {
+                        pc->flags |= DQUOTE_FOUND;
+                        pc->bufferPosition += 2;
+                } else {
+                        pc->flags &= ~ESCAPING;
+                }
+        }
+
+#ifdef CSV_STATS
+        pc->stats.quotedFields += 1;
+        if (memchr(pc->data + pc->fieldStart, DIALECT_NEW_LINE(pc), pc->bufferPosition - pc->fieldStart) != NULL)
+                pc->flags |= MULTILINE_RECORD;
+#endif
+
+        // The fields which are not needed are not unescaped
+        if ((pc->flags & DQUOTE_FOUND) && field_needed(pc)) {
+                DIALECT_NAME(end_escaped_sequence)(pc, pc->fieldStart, pc->bufferPosition);
+        } else {
+                emit_field(pc, pc->fieldStart, pc->bufferPosition - pc->fieldStart, 0);
+        }
+
+        pc->flags &= ~(ESCAPING | DQUOTE_FOUND);
+        pc->flags |= ESCAPED_FIELD;
+        pc->bufferPosition += 1;
+        return 1;
+}
+
+int DIALECT_NAME(skip_escape)(ParsingContext *pc)
+{
+        // The escaped character may be in the next block
+        if (pc->bufferPosition + 1 >= pc->length) {
+                fill_buffer(pc);
+                if (is_waiting(pc))
+                        return 0;
+        }
+
+        pc->flags |= DQUOTE_FOUND;
+        pc->bufferPosition += 2;
+        pc->escapedLength = pc->bufferPosition - pc->fieldStart;
+        return 1;
+}
+
+void DIALECT_NAME(end_field)(ParsingContext *pc, char c)
+{
+        size_t start = pc->fieldStart;
+        size_t end = pc->bufferPosition;
+        // Escaped characters are never removed
+        size_t limit = DIALECT_ESCAPING(pc) && (pc->flags & DQUOTE_FOUND) ? start + pc->escapedLength : start;
+
+        if (limit > end)
+                limit = end;
+
+        if (DIALECT_LINE_ENDING(pc) == DIALECT_LINE_ANY && c == NEW_LINE && end > limit &&
+            pc->data[end - 1] == CARRIAGE_RETURN)
+                end--;
+
+        if (DIALECT_TRIM(pc)) {
+                while (end > limit && is_blank(pc->data[end - 1]))
+                        end--;
+                while (start < end && is_blank(pc->data[start]))
+                        start++;
+        }
+
+        if (DIALECT_ESCAPING(pc) && (pc->flags & DQUOTE_FOUND)) {
+                pc->flags &= ~DQUOTE_FOUND;
+                if (field_needed(pc)) {
+                        DIALECT_NAME(end_escaped_sequence)(pc, start, end);
+                        return;
+                }
+        }
+
+        emit_field(pc, start, end - start, 0);
+}
+
+void DIALECT_NAME(end_escaped_sequence)(ParsingContext *pc, size_t start, size_t end)
+{
+        size_t offset;
+        size_t i;
+
+        if (pc->secondaryBuffer == NULL) {
+                pc->secondaryBuffer = buffer_alloc_with(end - start + 1, pc->allocator);
+        }
+
+        if (pc->secondaryBuffer == NULL || buffer_reserve(pc->secondaryBuffer, end - start) == NULL) {
+                perror("Cannot alloc memory buffer for csv parsing");
+                abort();
+        }
+
+        offset = pc->secondaryBuffer->stringLength;
+
+        for (i = start; i < end; i++) {
+                if (DIALECT_ESCAPING(pc)) {
+                        if (pc->data[i] == DIALECT_ESCAPE(pc) && i + 1 < end)
+                                i++;
+                        buffer_append(pc->secondaryBuffer, pc->data[i]);
+                } else {
+                        buffer_append(pc->secondaryBuffer, pc->data[i]);
+                        if (pc->data[i] == DIALECT_QUOTE(pc))
+                                i++;
+                }
+        }
+
+        emit_field(pc, offset, pc->secondaryBuffer->stringLength - offset, 1);
+}
+
+#undef DIALECT_NAME
+#undef DIALECT_SEPARATOR
+#undef DIALECT_QUOTE
+#undef DIALECT_ESCAPE
+#undef DIALECT_LINE_ENDING
+#undef DIALECT_TRIM
+#undef DIALECT_SCAN
+#undef DIALECT_NEW_LINE
+#undef DIALECT_ESCAPING
@@ -0,0 +1,123 @@
+//
+// Created by Davide on 16/10/2026.
+//
+
+#include <utils.h>
+#include "parser.h"
+
+// Private prototypes
+
+/**
+ * Append a predicate to the reader
+ * @param reader the CsvReader
+ * @param type the type of the predicate
+ * @param column the name of the column, it is copied
+ * @param value the value of the predicate, it is copied. May be NULL
+ * @return the predicate, or NULL on error
+ */
+Predicate *add_predicate(CsvReader *reader, int type, const char *column, const char *value);
+
+
+// Public Implementation
+
+int csv_reader_filter_equals(CsvReader *reader, const char *column, const char *value)
+{
+        return add_predicate(reader, PREDICATE_EQUALS, column, value) != NULL ? 0 : -1;
+}
+
+int csv_reader_filter_prefix(CsvReader *reader, const char *column, const char *prefix)
+{
+        return add_predicate(reader, PREDICATE_PREFIX, column, prefix) != NULL ? 0 : -1;
+}
+
+int csv_reader_filter_range(CsvReader *reader, const char *column, double min, double max)
+{
+        Predicate *predicate = add_predicate(reader, PREDICATE_RANGE, column, NULL);
+
+        if (predicate == NULL)
+                return -1;
+
+        predicate->min = min;
+        predicate->max = max;
+        return 0;
+}
+
+int csv_reader_filter_empty(CsvReader *reader, const char *column, int empty)
+{
+        Predicate *predicate = add_predicate(reader, PREDICATE_EMPTY, column, NULL);
+
+        if (predicate == NULL)
+                return -1;
+
+        predicate->empty = empty != 0;
+        return 0;
+}
+
+int csv_reader_filter_clear(CsvReader *reader)
+{
+        size_t i;
+
+        if (check_reader_idle(reader) < 0)
+                return -1;
+
+        for (i = 0; i < reader->predicateCount; i++) {
+                free(reader->predicates[i].column);
+                free(reader->predicates[i].value);
+        }
+
+        free(reader->predicates);
+        reader->predicates = NULL;
+        reader->predicateCount = 0;
+        return 0;
+}
+
+int predicate_match(const Predicate *predicate, const char *field, size_t len)
+{
+        double value;
+
+        switch (predicate->type) {
+                case PREDICATE_EQUALS:
+                        return len == predicate->length && memcmp(field, predicate->value, len) == 0;
+                case PREDICATE_PREFIX:
+                        return len >= predicate->length && memcmp(field, predicate->value, predicate->length) == 0;
+                case PREDICATE_RANGE:
+                        return string_to_double(field, len, &value) == 0 &&
+                               value >= predicate->min && value <= predicate->max;
+                default:
+                        return (string_type_len(field, len) == STRING_TYPE_EMPTY) == predicate->empty;
+        }
+}
+
+// Private Implementation
+
+Predicate *add_predicate(CsvReader *reader, int type, const char *column, const char *value)
+{
+        Predicate *predicates;
+        Predicate *result;
+
+        if (check_reader_idle(reader) < 0)
+                return NULL;
+
+        predicates = realloc(reader->predicates, sizeof(Predicate) * (reader->predicateCount + 1));
+        if (predicates == NULL)
+                return NULL;
+
+        reader->predicates = predicates;
+        result = &predicates[reader->predicateCount];
+        result->type = type;
+        result->column = string_duplicate(column, strlen(column));
+        result->value = value != NULL ? string_duplicate(value, strlen(value)) : NULL;
+        result->length = value != NULL ? strlen(value) : 0;
+        result->min = 0;
+        result->max = 0;
+        result->empty = 1;
+
+        if (result->column == NULL || (value != NULL && result->value == NULL)) {
+                free(result->column);
+                free(result->value);
+                return NULL;
+        }
+
+        reader->predicateCount += 1;
+        return result;
+}
@@ -0,0 +1,45 @@
+//
+// Created by Davide on 16/10/2026.
+//
+
+#ifndef C_CSV__PREDICATE_H
+#define C_CSV__PREDICATE_H
+
+#include <stdlib.h>
+
+#define PREDICATE_EQUALS 0
+#define PREDICATE_PREFIX 1
+#define PREDICATE_RANGE 2
+#define PREDICATE_EMPTY 3
+
+/**
+ * A condition on a field of a record, checked on the bytes of the field
+ * before the record is delivered.
+ * column is the name of the column the condition applies to, type is one of
+ *  - PREDICATE_EQUALS: the field is equal to value
+ *  - PREDICATE_PREFIX: the field begins with value
+ *  - PREDICATE_RANGE: the field is a number between min and max (included)
+ *  - PREDICATE_EMPTY: the field is empty (or it contains only spaces) if
+ *                     empty is 1, it is not empty if empty is 0
+ * A missing field is empty
+ */
+typedef struct Predicate_s {
+        int type;
+        char *column;
+        char *value;
+        size_t length;
+        double min;
+        double max;
+        int empty;
+} Predicate;
+
+/**
+ * Check a field against a predicate
+ * @param predicate the predicate
+ * @param field the field, it may not be null terminated
+ * @param len length of the field
+ * @return 1 if the field satisfies the predicate, 0 otherwise
+ */
+int predicate_match(const Predicate *predicate, const char *field, size_t len);
+
+#endif //C_CSV__PREDICATE_H
@@ -0,0 +1,306 @@
+//
+// Created by Davide on 16/10/2026.
+//
+
+#include "parser.h"
+
+#ifdef CSV_POSIX
+#include <pthread.h>
+
+#define PREFETCH_HEADROOM (64 << 10)
+
+/**
+ * The blocks of a stream read ahead of the parser by an I/O thread.
+ * The blocks are stored in a ring of slotCount slots: the thread fills the
+ * slots up to produced, the parser takes them up to taken and gives them
+ * back up to released. The parser holds the slot its data points to, the
+ * thread reads at most slotCount - 1 blocks ahead of it.
+ * Each slot has headroom bytes before its block, where the parser moves the
+ * incomplete record at the end of the previous block: records are stored
+ * contiguously without copying the blocks
+ *
+ * @param pc the parsing context, whose stream is read by the thread
+ * @param slots, lengths the slots and the length of the block they store
+ * @param position offset in the input of the end of the last block read
+ * @param finished 1 when the thread has reached the end of the stream
+ * @param stop 1 when the thread must terminate
+ * @param running 1 while the thread is running
+ */
+struct Prefetch_s {
+        ParsingContext *pc;
+        char **slots;
+        size_t *lengths;
+        size_t slotCount;
+        size_t headroom;
+
+        size_t produced;
+        size_t taken;
+        size_t released;
+        size_t position;
+        int finished;
+        int stop;
+        int running;
+
+        pthread_t thread;
+        pthread_mutex_t lock;
+        pthread_cond_t changed;
+};
+
+
+// Private prototypes
+
+/**
+ * Start the I/O thread, which reads from the current position of the stream
+ * @param prefetch the read-ahead state
+ * @return 0 on success, -1 if the thread cannot be created
+ */
+int prefetch_start(Prefetch *prefetch);
+
+/**
+ * The I/O thread: read blocks until the end of the stream or until it is
+ * stopped
+ * @param arg the read-ahead state
+ * @return NULL
+ */
+void *prefetch_run(void *arg);
+
+/**
+ * Give back to the I/O thread the slots taken by the parser
+ * @param prefetch the read-ahead state
+ * @param keep number of slots, among the last taken, which are still in use
+ */
+void prefetch_release(Prefetch *prefetch, size_t keep);
+
+
+// Public Implementation
+
+Prefetch *prefetch_alloc(ParsingContext *pc, size_t blocks)
+{
+        Prefetch *result = allocator_malloc(pc->allocator, sizeof(Prefetch));
+        size_t i;
+
+        if (result == NULL) {
+                perror("Cannot alloc memory buffer for csv parsing");
+                abort();
+        }
+
+        result->pc = pc;
+        result->slotCount = blocks + 1;
+        result->headroom = PREFETCH_HEADROOM;
+        result->slots = allocator_malloc(pc->allocator, sizeof(char *) * result->slotCount);
+        result->lengths = allocator_malloc(pc->allocator, sizeof(size_t) * result->slotCount);
+
+        if (result->slots == NULL || result->lengths == NULL) {
+                perror("Cannot alloc memory buffer for csv parsing");
+                abort();
+        }
+
+        for (i = 0; i < result->slotCount; i++) {
+                result->slots[i] = allocator_malloc(pc->allocator,
+                                                    result->headroom + pc->blockSize + pc->padding + 1);
+                if (result->slots[i] == NULL) {
+                        perror("Cannot alloc memory buffer for csv parsing");
+                        abort();
+                }
+        }
+
+        result->running = 0;
+        pthread_mutex_init(&result->lock, NULL);
+        pthread_cond_init(&result->changed, NULL);
+        return result;
+}
+
+void prefetch_free(Prefetch *prefetch)
+{
+        const Allocator *allocator;
+        size_t i;
+
+        if (prefetch == NULL)
+                return;
+
+        prefetch_stop(prefetch);
+        pthread_mutex_destroy(&prefetch->lock);
+        pthread_cond_destroy(&prefetch->changed);
+
+        allocator = prefetch->pc->allocator;
+        for (i = 0; i < prefetch->slotCount; i++) {
+                allocator_free(allocator, prefetch->slots[i]);
+        }
+
+        allocator_free(allocator, prefetch->slots);
+        allocator_free(allocator, prefetch->lengths);
+        allocator_free(allocator, prefetch);
+}
+
+size_t prefetch_fill(ParsingContext *pc)
+{
+        Prefetch *prefetch = pc->prefetch;
+        Buffer *buffer = pc->buffer;
+        size_t available;
+        size_t tail;
+        size_t slot;
+        size_t n;
+        char *block;
+
+        if (!prefetch->running && prefetch_start(prefetch) < 0) {
+                // Without the thread, the stream is read by the parser
+                prefetch_free(prefetch);
+                pc->prefetch = NULL;
+                return fill_buffer(pc);
+        }
+
+        pthread_mutex_lock(&prefetch->lock);
+        while (prefetch->taken == prefetch->produced && !prefetch->finished)
+                pthread_cond_wait(&prefetch->changed, &prefetch->lock);
+
+        if (prefetch->taken == prefetch->produced) {
+                pthread_mutex_unlock(&prefetch->lock);
+                pc->flags |= PROCESSED_ALL_RECORDS;
+                return 0;
+        }
+
+        slot = prefetch->taken % prefetch->slotCount;
+        n = prefetch->lengths[slot];
+        prefetch->taken += 1;
+        pthread_mutex_unlock(&prefetch->lock);
+
+        block = prefetch->slots[slot] + prefetch->headroom;
+        tail = pc->length - pc->recordStart;
+
+        if (tail <= prefetch->headroom) {
+                // The incomplete record is moved just before the block
+                memcpy(block - tail, pc->data + pc->recordStart, tail);
+                shift_offsets(pc, pc->recordStart);
+                pc->data = block - tail;
+                pc->length = tail + n;
+                prefetch_release(prefetch, 1);
+                return n;
+        }
+
+        // Records longer than the headroom are stored in the input buffer
+        available = buffer->bufferLength;
+        if (pc->data == buffer->buffer) {
+                compact_buffer(pc);
+        } else {
+                buffer_reset(buffer);
+                if (buffer_append_str(buffer, pc->data + pc->recordStart, tail) == NULL) {
+                        perror("Cannot alloc memory buffer for csv parsing");
+                        abort();
+                }
+                shift_offsets(pc, pc->recordStart);
+        }
+
+        if (buffer_append_str(buffer, block, n) == NULL || buffer_reserve(buffer, pc->padding) == NULL) {
+                perror("Cannot alloc memory buffer for csv parsing");
+                abort();
+        }
+        stats_add(pc, bufferGrowths, buffer->bufferLength != available);
+
+        pc->data = buffer->buffer;
+        pc->length = buffer->stringLength;
+        prefetch_release(prefetch, 0);
+        return n;
+}
+
+size_t prefetch_stop(Prefetch *prefetch)
+{
+        if (!prefetch->running)
+                return prefetch->pc->consumed + prefetch->pc->length;
+
+        pthread_mutex_lock(&prefetch->lock);
+        prefetch->stop = 1;
+        pthread_cond_signal(&prefetch->changed);
+        pthread_mutex_unlock(&prefetch->lock);
+
+        pthread_join(prefetch->thread, NULL);
+        prefetch->running = 0;
+        return prefetch->position;
+}
+
+
+// Private Implementation
+
+int prefetch_start(Prefetch *prefetch)
+{
+        prefetch->produced = 0;
+        prefetch->taken = 0;
+        prefetch->released = 0;
+        prefetch->position = prefetch->pc->consumed + prefetch->pc->length;
+        prefetch->finished = 0;
+        prefetch->stop = 0;
+
+        if (pthread_create(&prefetch->thread, NULL, &prefetch_run, prefetch) != 0)
+                return -1;
+
+        prefetch->running = 1;
+        return 0;
+}
+
+void *prefetch_run(void *arg)
+{
+        Prefetch *prefetch = arg;
+        size_t slot;
+        size_t n;
+
+        for (;;) {
+                pthread_mutex_lock(&prefetch->lock);
+                while (!prefetch->stop && prefetch->produced - prefetch->released == prefetch->slotCount)
+                        pthread_cond_wait(&prefetch->changed, &prefetch->lock);
+
+                if (prefetch->stop) {
+                        pthread_mutex_unlock(&prefetch->lock);
+                        return NULL;
+                }
+
+                slot = prefetch->produced % prefetch->slotCount;
+                pthread_mutex_unlock(&prefetch->lock);
+
+                n = read_stream(prefetch->pc, prefetch->slots[slot] + prefetch->headroom, prefetch->pc->blockSize);
+
+                pthread_mutex_lock(&prefetch->lock);
+                prefetch->lengths[slot] = n;
+                prefetch->position += n;
+                if (n > 0)
+                        prefetch->produced += 1;
+                else
+                        prefetch->finished = 1;
+                pthread_cond_signal(&prefetch->changed);
+                pthread_mutex_unlock(&prefetch->lock);
+
+                if (n == 0)
+                        return NULL;
+        }
+}
+
+void prefetch_release(Prefetch *prefetch, size_t keep)
+{
+        pthread_mutex_lock(&prefetch->lock);
+        prefetch->released = prefetch->taken - keep;
+        pthread_cond_signal(&prefetch->changed);
+        pthread_mutex_unlock(&prefetch->lock);
+}
+
+#else
+
+// Without threads the stream is always read by the parser
+
+Prefetch *prefetch_alloc(ParsingContext *pc, size_t blocks)
+{
+        return NULL;
+}
+
+void prefetch_free(Prefetch *prefetch)
+{
+}
+
+size_t prefetch_fill(ParsingContext *pc)
+{
+        return fill_buffer(pc);
+}
+
+size_t prefetch_stop(Prefetch *prefetch)
+{
+        return 0;
+}
+
+#endif
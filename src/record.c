@@ -6,6 +6,8 @@
 #include <utils.h>
 #include "record.h"
 
+#define RECORD_ARENA_SIZE 256
+
 void record_resize(Record *record, size_t size);
 int record_realloc(Record *record);
 
@@ -26,12 +28,48 @@ Record *record_alloc(size_t size)
         }
 
         result->arraySize = 0;
+        result->arena = NULL;
+        result->columns = NULL;
+        result->codes = NULL;
+        return result;
+}
+
+Record *record_alloc_with(size_t size, const Allocator *allocator)
+{
+        Record *result = allocator_malloc(allocator, sizeof(Record));
+
+        if (result == NULL)
+                return NULL;
+
+        result->bufferSize = 1;
+        record_resize(result, size);
+        result->fields = allocator_malloc(allocator, sizeof(char *) * (result->bufferSize));
+        result->arena = arena_alloc(RECORD_ARENA_SIZE, allocator);
+
+        if (result->fields == NULL || result->arena == NULL) {
+                allocator_free(allocator, result->fields);
+                if (result->arena != NULL)
+                        arena_free(result->arena);
+                allocator_free(allocator, result);
+                return NULL;
+        }
+
+        result->arraySize = 0;
+        result->columns = NULL;
+        result->codes = NULL;
         return result;
 }
 
 inline void record_reset(Record *r) 
 {
         size_t i;
+
+        if (r->arena != NULL) {
+                arena_reset(r->arena);
+                r->arraySize = 0;
+                return;
+        }
+
         for (i = 0; i < r->arraySize; i++) {
                 free(r->fields[i]);
         }
@@ -47,6 +85,17 @@ void record_resize(Record *record, size_t size)
 
 void record_free(Record *r)
 {
+        const Allocator *allocator;
+
+        if (r->arena != NULL) {
+                allocator = r->arena->allocator;
+                arena_free(r->arena);
+                allocator_free(allocator, r->fields);
+                allocator_free(allocator, r->codes);
+                allocator_free(allocator, r);
+                return;
+        }
+
         record_reset(r);
         free(r->fields);
         free(r);
@@ -59,17 +108,113 @@ char **record_append_str(Record *r, const char *field, size_t len)
                 record_realloc(r);
         }
 
-        r->fields[r->arraySize] = string_duplicate(field, len);
+        if (r->arena != NULL)
+                r->fields[r->arraySize] = arena_strdup(r->arena, field, len);
+        else
+                r->fields[r->arraySize] = string_duplicate(field, len);
+        if (r->codes != NULL)
+                r->codes[r->arraySize] = CSV_NO_CODE;
+        r->arraySize += 1;
+        return r->fields;
+}
+
+char **record_append_interned(Record *r, const char *value, uint32_t code)
+{
+        size_t i;
+
+        if ((r->arraySize + 1) >= r->bufferSize) {
+                r->bufferSize *= 2;
+                record_realloc(r);
+        }
+
+        // The fields appended so far are not interned
+        if (r->codes == NULL) {
+                r->codes = allocator_malloc(r->arena->allocator, r->bufferSize * sizeof *r->codes);
+                if (r->codes == NULL)
+                        return NULL;
+                for (i = 0; i < r->arraySize; i++) {
+                        r->codes[i] = CSV_NO_CODE;
+                }
+        }
+
+        r->fields[r->arraySize] = (char *) value;
+        r->codes[r->arraySize] = code;
         r->arraySize += 1;
         return r->fields;
 }
 
 int record_realloc(Record *record)
 {
-        char **newRecords = realloc(record->fields, record->bufferSize * sizeof *record->fields);
+        char **newRecords;
+        uint32_t *newCodes;
+
+        if (record->arena != NULL)
+                newRecords = allocator_realloc(record->arena->allocator, record->fields,
+                                               record->arraySize * sizeof *record->fields,
+                                               record->bufferSize * sizeof *record->fields);
+        else
+                newRecords = realloc(record->fields, record->bufferSize * sizeof *record->fields);
+
         if (newRecords == NULL) {
                 return -1;
         }
         record->fields = newRecords;
+
+        if (record->codes != NULL) {
+                newCodes = allocator_realloc(record->arena->allocator, record->codes,
+                                             record->arraySize * sizeof *record->codes,
+                                             record->bufferSize * sizeof *record->codes);
+                if (newCodes == NULL)
+                        return -1;
+                record->codes = newCodes;
+        }
         return 0;
-}
\ No newline at end of file
+}
+
+RecordView *record_view_alloc(size_t size)
+{
+        RecordView *result = malloc(sizeof(RecordView));
+
+        if (result == NULL)
+                return NULL;
+
+        for (result->bufferSize = 1; result->bufferSize < size; result->bufferSize *= 2);
+        result->fields = malloc(sizeof(FieldView) * (result->bufferSize));
+
+        if (result->fields == NULL) {
+                free(result);
+                return NULL;
+        }
+
+        result->arraySize = 0;
+        result->columns = NULL;
+        return result;
+}
+
+void record_view_free(RecordView *r)
+{
+        free(r->fields);
+        free(r);
+}
+
+inline void record_view_reset(RecordView *r)
+{
+        r->arraySize = 0;
+}
+
+FieldView *record_view_append(RecordView *r, const char *field, size_t len)
+{
+        if (r->arraySize >= r->bufferSize) {
+                FieldView *newFields = realloc(r->fields, 2 * r->bufferSize * sizeof *r->fields);
+                if (newFields == NULL) {
+                        return NULL;
+                }
+                r->fields = newFields;
+                r->bufferSize *= 2;
+        }
+
+        r->fields[r->arraySize].data = field;
+        r->fields[r->arraySize].length = len;
+        r->arraySize += 1;
+        return r->fields;
+}
@@ -5,21 +5,62 @@
 #ifndef C_CSV__RECORD_H
 #define C_CSV__RECORD_H
 
+#include <stdint.h>
 #include <stdlib.h>
 
+#include "arena.h"
+
+#define CSV_NO_COLUMN ((size_t) -1)
+#define CSV_NO_CODE UINT32_MAX
+
+/**
+ * The names of the columns of a header (see csv_record_get)
+ */
+struct ColumnMap_s;
+
 /**
  * A data structure yelding the data contained in a record
  * fields is a array of strings, containing the actual value,
  * size is the number of fields
  * buffer_size the size of the fields vector
  * size <= buffer_size, there are always buffer_size - size free spaces at the end fields
+ * arena, if not NULL, owns the memory of the fields
+ * columns, if not NULL, maps the names of the header to the fields
+ * codes, if not NULL, holds the code of each field in the dictionary of
+ * its column, CSV_NO_CODE if the field is not interned (see
+ * csv_reader_intern_column)
  */
 typedef struct Record_s {
         char **fields;
         size_t arraySize;
         size_t bufferSize;
+        Arena *arena;
+        const struct ColumnMap_s *columns;
+        uint32_t *codes;
 } Record;
 
+/**
+ * A non owning slice of a field.
+ * data points inside the parser buffers and it is NOT null terminated,
+ * length is the number of bytes of the field
+ */
+typedef struct FieldView_s {
+        const char *data;
+        size_t length;
+} FieldView;
+
+/**
+ * Same as Record, but fields are views on the parser buffers instead of
+ * heap allocated strings.
+ * Views are valid only until the callback that received them returns
+ */
+typedef struct RecordView_s {
+        FieldView *fields;
+        size_t arraySize;
+        size_t bufferSize;
+        const struct ColumnMap_s *columns;
+} RecordView;
+
 /**
  * Allocate a record
  * @param len initial record size
@@ -27,6 +68,16 @@ typedef struct Record_s {
  */
 Record *record_alloc(size_t len);
 
+/**
+ * Allocate a record whose fields are stored in an arena: appending a field
+ * does not allocate in steady state and record_reset is O(1)
+ * @param len initial record size
+ * @param allocator allocator used for the record and for the arena chunks,
+ *                  if NULL malloc is used. It must outlive the record
+ * @return the record, or NULL on error
+ */
+Record *record_alloc_with(size_t len, const Allocator *allocator);
+
 /**
  * Free an allocated record
  * @param r the record
@@ -47,4 +98,42 @@ void record_reset(Record *r);
  */
 char **record_append_str(Record *r, const char *field, size_t len);
 
+/**
+ * Store an interned value in the record, the value is not copied.
+ * Only for records whose fields are stored in an arena
+ * @param r the record
+ * @param value the value, it must outlive the record
+ * @param code the code of the value in its dictionary
+ * @return the underlying array, or NULL on error
+ */
+char **record_append_interned(Record *r, const char *value, uint32_t code);
+
+/**
+ * Allocate a record view
+ * @param len initial record size
+ * @return the record view, or NULL on error
+ */
+RecordView *record_view_alloc(size_t len);
+
+/**
+ * Free an allocated record view. Viewed data is not touched
+ * @param r the record view
+ */
+void record_view_free(RecordView *r);
+
+/**
+ * Reset a record view without reallocating it
+ * @param r the record view
+ */
+void record_view_reset(RecordView *r);
+
+/**
+ * Store a view on the field in the record, the field is not copied
+ * @param r the record view
+ * @param field pointer to the first byte of the field
+ * @param len length of the field
+ * @return the underlying array, or NULL on error
+ */
+FieldView *record_view_append(RecordView *r, const char *field, size_t len);
+
 #endif //C_CSV__RECORD_H
@@ -0,0 +1,247 @@
+//
+// Created by Davide on 16/10/2026.
+//
+
+#include <string.h>
+
+#include "scan.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define SCAN_X86
+#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SCAN_INLINE static inline __attribute__((always_inline))
+#define SCAN_INLINE_TARGET(isa) static inline __attribute__((target(isa), always_inline))
+// The level may be selected by several threads at once: they all store the
+// same value, so relaxed atomics are enough to make the race harmless
+#define scan_load_level() __atomic_load_n(&scanLevel, __ATOMIC_RELAXED)
+#define scan_store_level(level) __atomic_store_n(&scanLevel, (level), __ATOMIC_RELAXED)
+#else
+#define SCAN_INLINE static inline
+#define scan_load_level() (scanLevel)
+#define scan_store_level(level) (scanLevel = (level))
+#endif
+
+#define SCAN_LEVEL_SCALAR 0
+#define SCAN_LEVEL_SSE2 1
+#define SCAN_LEVEL_AVX2 2
+#define SCAN_LEVEL_AVX512 3
+#define SCAN_LEVELS 4
+
+#define scan_quoted(quote) ((quote) != 0)
+#define scan_escaped(quote, escape) ((escape) != 0 && (escape) != (quote))
+
+typedef void (*ScanKernel)(const char *, const ScanChars *, ScanMasks *);
+
+void scan_block_generic(const char *block, const ScanChars *chars, ScanMasks *masks);
+int scan_select_level(void);
+
+static int scanLevel = -1;
+static const char *scanLevelNames[SCAN_LEVELS] = {"scalar", "sse2", "avx2", "avx512"};
+
+// Kernels
+// Each kernel is written once, taking the structural characters as
+// arguments, and it is inlined in a function for each dialect: the
+// characters of CSV, TSV and PSV are constants, the generic dialect reads
+// them from a ScanChars at runtime
+
+SCAN_INLINE void scan_chars_scalar(const char *block, char separator, char quote, char newLine, char escape,
+                                   ScanMasks *masks)
+{
+        unsigned i;
+
+        masks->separator = 0;
+        masks->dquote = 0;
+        masks->newLine = 0;
+        masks->escape = 0;
+
+        for (i = 0; i < SCAN_BLOCK_SIZE; i++) {
+                masks->separator |= (uint64_t) (block[i] == separator) << i;
+                masks->newLine |= (uint64_t) (block[i] == newLine) << i;
+                if (scan_quoted(quote))
+                        masks->dquote |= (uint64_t) (block[i] == quote) << i;
+                if (scan_escaped(quote, escape))
+                        masks->escape |= (uint64_t) (block[i] == escape) << i;
+        }
+}
+
+#ifdef SCAN_X86
+
+SCAN_INLINE_TARGET("sse2") uint64_t scan_eq_sse2(const __m128i chunks[4], char c)
+{
+        __m128i pattern = _mm_set1_epi8(c);
+        uint64_t result = 0;
+        int i;
+
+        for (i = 0; i < 4; i++) {
+                result |= (uint64_t) (uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(chunks[i], pattern)) << (16 * i);
+        }
+        return result;
+}
+
+SCAN_INLINE_TARGET("sse2") void scan_chars_sse2(const char *block, char separator, char quote, char newLine,
+                                                char escape, ScanMasks *masks)
+{
+        __m128i chunks[4];
+        int i;
+
+        for (i = 0; i < 4; i++) {
+                chunks[i] = _mm_loadu_si128((const __m128i *) (block + 16 * i));
+        }
+
+        masks->separator = scan_eq_sse2(chunks, separator);
+        masks->dquote = scan_quoted(quote) ? scan_eq_sse2(chunks, quote) : 0;
+        masks->newLine = scan_eq_sse2(chunks, newLine);
+        masks->escape = scan_escaped(quote, escape) ? scan_eq_sse2(chunks, escape) : 0;
+}
+
+SCAN_INLINE_TARGET("avx2") uint64_t scan_eq_avx2(__m256i low, __m256i high, char c)
+{
+        __m256i pattern = _mm256_set1_epi8(c);
+        uint64_t lowMask = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(low, pattern));
+        uint64_t highMask = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(high, pattern));
+        return lowMask | (highMask << 32);
+}
+
+SCAN_INLINE_TARGET("avx2") void scan_chars_avx2(const char *block, char separator, char quote, char newLine,
+                                                char escape, ScanMasks *masks)
+{
+        __m256i low = _mm256_loadu_si256((const __m256i *) block);
+        __m256i high = _mm256_loadu_si256((const __m256i *) (block + 32));
+
+        masks->separator = scan_eq_avx2(low, high, separator);
+        masks->dquote = scan_quoted(quote) ? scan_eq_avx2(low, high, quote) : 0;
+        masks->newLine = scan_eq_avx2(low, high, newLine);
+        masks->escape = scan_escaped(quote, escape) ? scan_eq_avx2(low, high, escape) : 0;
+}
+
+SCAN_INLINE_TARGET("avx512f,avx512bw") void scan_chars_avx512(const char *block, char separator, char quote,
+                                                              char newLine, char escape, ScanMasks *masks)
+{
+        __m512i data = _mm512_loadu_si512((const void *) block);
+
+        masks->separator = _mm512_cmpeq_epi8_mask(data, _mm512_set1_epi8(separator));
+        masks->dquote = scan_quoted(quote) ? _mm512_cmpeq_epi8_mask(data, _mm512_set1_epi8(quote)) : 0;
+        masks->newLine = _mm512_cmpeq_epi8_mask(data, _mm512_set1_epi8(newLine));
+        masks->escape = scan_escaped(quote, escape) ? _mm512_cmpeq_epi8_mask(data, _mm512_set1_epi8(escape)) : 0;
+}
+
+#define SCAN_X86_KERNELS(name, separator, quote, newLine, escape) \
+__attribute__((target("sse2"))) \
+static void scan_block_##name##_sse2(const char *block, const ScanChars *chars, ScanMasks *masks) \
+{ \
+        (void) chars; \
+        scan_chars_sse2(block, separator, quote, newLine, escape, masks); \
+} \
+__attribute__((target("avx2"))) \
+static void scan_block_##name##_avx2(const char *block, const ScanChars *chars, ScanMasks *masks) \
+{ \
+        (void) chars; \
+        scan_chars_avx2(block, separator, quote, newLine, escape, masks); \
+} \
+__attribute__((target("avx512f,avx512bw"))) \
+static void scan_block_##name##_avx512(const char *block, const ScanChars *chars, ScanMasks *masks) \
+{ \
+        (void) chars; \
+        scan_chars_avx512(block, separator, quote, newLine, escape, masks); \
+}
+#define scan_x86_kernel(name, isa) &scan_block_##name##_##isa
+
+#else
+
+#define SCAN_X86_KERNELS(name, separator, quote, newLine, escape)
+#define scan_x86_kernel(name, isa) &scan_block_##name##_scalar
+
+#endif
+
+/**
+ * Define the kernels of a dialect and the function scan_block_<name>
+ * dispatching to the one selected for the CPU
+ */
+#define SCAN_KERNELS(name, separator, quote, newLine, escape) \
+static void scan_block_##name##_scalar(const char *block, const ScanChars *chars, ScanMasks *masks) \
+{ \
+        (void) chars; \
+        scan_chars_scalar(block, separator, quote, newLine, escape, masks); \
+} \
+SCAN_X86_KERNELS(name, separator, quote, newLine, escape) \
+static const ScanKernel scanKernels_##name[SCAN_LEVELS] = { \
+        &scan_block_##name##_scalar, \
+        scan_x86_kernel(name, sse2), \
+        scan_x86_kernel(name, avx2), \
+        scan_x86_kernel(name, avx512) \
+}; \
+void scan_block_##name(const char *block, const ScanChars *chars, ScanMasks *masks) \
+{ \
+        int level = scan_load_level(); \
+        if (level < 0) \
+                level = scan_select_level(); \
+        scanKernels_##name[level](block, chars, masks); \
+}
+
+SCAN_KERNELS(csv, ',', '"', '\n', '"')
+SCAN_KERNELS(tsv, '\t', '"', '\n', '"')
+SCAN_KERNELS(psv, '|', '"', '\n', '"')
+SCAN_KERNELS(generic, chars->separator, chars->quote, chars->newLine, chars->escape)
+
+// Dispatch
+
+int scan_select_level(void)
+{
+        int level = SCAN_LEVEL_SCALAR;
+
+#ifdef SCAN_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512bw"))
+                level = SCAN_LEVEL_AVX512;
+        else if (__builtin_cpu_supports("avx2"))
+                level = SCAN_LEVEL_AVX2;
+        else if (__builtin_cpu_supports("sse2"))
+                level = SCAN_LEVEL_SSE2;
+#endif
+
+        scan_store_level(level);
+        return level;
+}
+
+void scan_block(const char *block, const ScanChars *chars, ScanMasks *masks)
+{
+        scan_block_generic(block, chars, masks);
+}
+
+void scan_partial_block(const char *block, size_t len, const ScanChars *chars, ScanMasks *masks)
+{
+        char padded[SCAN_BLOCK_SIZE] = {0};
+
+        memcpy(padded, block, len < SCAN_BLOCK_SIZE ? len : SCAN_BLOCK_SIZE);
+        scan_block_generic(padded, chars, masks);
+}
+
+size_t scan_count_quotes(const char *data, size_t len, const ScanChars *chars)
+{
+        ScanMasks masks;
+        size_t count = 0;
+        size_t i;
+
+        for (i = 0; i + SCAN_BLOCK_SIZE <= len; i += SCAN_BLOCK_SIZE) {
+                scan_block_generic(data + i, chars, &masks);
+                count += scan_count_bits(masks.dquote);
+        }
+
+        if (i < len) {
+                scan_partial_block(data + i, len - i, chars, &masks);
+                count += scan_count_bits(masks.dquote);
+        }
+
+        return count;
+}
+
+const char *scan_kernel_name(void)
+{
+        int level = scan_load_level();
+        if (level < 0)
+                level = scan_select_level();
+        return scanLevelNames[level];
+}
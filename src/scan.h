@@ -0,0 +1,130 @@
+//
+// Created by Davide on 16/10/2026.
+//
+
+#ifndef C_CSV__SCAN_H
+#define C_CSV__SCAN_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#define SCAN_BLOCK_SIZE 64
+
+/**
+ * The structural characters of a dialect. A quote or an escape equal to 0
+ * is never matched, nor is an escape equal to the quote
+ */
+typedef struct ScanChars_s {
+        char separator;
+        char quote;
+        char newLine;
+        char escape;
+} ScanChars;
+
+/**
+ * Positions of the structural characters of a block of SCAN_BLOCK_SIZE bytes:
+ * bit i of each mask is set if the i-th byte of the block is respectively
+ * a separator, a quote, a new line or an escape character
+ */
+typedef struct ScanMasks_s {
+        uint64_t separator;
+        uint64_t dquote;
+        uint64_t newLine;
+        uint64_t escape;
+} ScanMasks;
+
+/**
+ * Classify a block of SCAN_BLOCK_SIZE bytes.
+ * The kernel (scalar, SSE2, AVX2 or AVX-512) is chosen at runtime the first
+ * time the function is invoked, accordingly to the instruction sets
+ * supported by the CPU
+ * @param block the block, SCAN_BLOCK_SIZE bytes must be readable
+ * @param chars the characters to look for
+ * @param masks output masks
+ */
+void scan_block(const char *block, const ScanChars *chars, ScanMasks *masks);
+
+/**
+ * Same as scan_block, with the characters of the CSV, TSV and PSV dialects
+ * built into the kernels. chars is ignored
+ */
+void scan_block_csv(const char *block, const ScanChars *chars, ScanMasks *masks);
+void scan_block_tsv(const char *block, const ScanChars *chars, ScanMasks *masks);
+void scan_block_psv(const char *block, const ScanChars *chars, ScanMasks *masks);
+
+/**
+ * Classify the last bytes of a buffer, which are less than SCAN_BLOCK_SIZE.
+ * Bits after len are cleared
+ * @param block the first byte to classify
+ * @param len number of readable bytes
+ * @param chars the characters to look for
+ * @param masks output masks
+ */
+void scan_partial_block(const char *block, size_t len, const ScanChars *chars, ScanMasks *masks);
+
+/**
+ * Count the quotes in a buffer
+ * @param data the buffer
+ * @param len the length of the buffer
+ * @param chars the characters of the dialect
+ * @return the number of quotes
+ */
+size_t scan_count_quotes(const char *data, size_t len, const ScanChars *chars);
+
+/**
+ * @return the name of the kernel used by scan_block
+ */
+const char *scan_kernel_name(void);
+
+/**
+ * @param mask a non zero mask
+ * @return the position of the lowest bit set in the mask
+ */
+static inline unsigned scan_first_bit(uint64_t mask)
+{
+#if defined(__GNUC__) || defined(__clang__)
+        return (unsigned) __builtin_ctzll(mask);
+#else
+        unsigned i = 0;
+        while (!(mask & 1)) {
+                mask >>= 1;
+                i++;
+        }
+        return i;
+#endif
+}
+
+/**
+ * @param mask a mask
+ * @return the number of bits set in the mask
+ */
+static inline unsigned scan_count_bits(uint64_t mask)
+{
+#if defined(__GNUC__) || defined(__clang__)
+        return (unsigned) __builtin_popcountll(mask);
+#else
+        unsigned count = 0;
+        for (; mask; mask &= mask - 1)
+                count++;
+        return count;
+#endif
+}
+
+/**
+ * @param mask a mask
+ * @return a mask whose bit i is the parity of the bits of mask up to i:
+ *         given the quotes of a block, the bytes inside quotes (opening
+ *         quotes included, closing quotes excluded)
+ */
+static inline uint64_t scan_prefix_xor(uint64_t mask)
+{
+        mask ^= mask << 1;
+        mask ^= mask << 2;
+        mask ^= mask << 4;
+        mask ^= mask << 8;
+        mask ^= mask << 16;
+        mask ^= mask << 32;
+        return mask;
+}
+
+#endif //C_CSV__SCAN_H
@@ -0,0 +1,188 @@
+//
+// Created by Davide on 16/10/2026.
+//
+
+#include <utils.h>
+#include "parser.h"
+
+#define SCHEMA_SIZE 16
+
+// Private prototypes
+
+/**
+ * Grow the columns of a schema, the new columns have no non empty field
+ * and they are null in all the records sampled so far
+ * @param schema the schema
+ * @param count the new number of columns
+ * @return 0 on success, -1 on error
+ */
+int schema_resize(Schema *schema, size_t count);
+
+/**
+ * Update a column schema with a field
+ * @param column the column schema
+ * @param field the field
+ */
+void column_schema_update(ColumnSchema *column, const FieldView *field);
+
+
+// Public Implementation
+
+Schema *csv_iterator_infer_schema(CsvIterator *iterator, size_t samples, size_t stride)
+{
+        RecordView *header = csv_iterator_header(iterator);
+        RecordView *record;
+        Schema *result;
+        size_t i = 0;
+
+        if (header == NULL)
+                return NULL;
+
+        result = schema_alloc(header);
+        if (result == NULL)
+                return NULL;
+
+        if (stride == 0)
+                stride = 1;
+
+        while ((samples == 0 || result->sampledRecords < samples) &&
+               csv_iterator_next(iterator, NULL, &record)) {
+                if (i++ % stride != 0)
+                        continue;
+
+                if (schema_update(result, record) < 0) {
+                        schema_free(result);
+                        return NULL;
+                }
+        }
+
+        return result;
+}
+
+Schema *csv_reader_infer_schema(CsvReader *reader, const char *path, size_t samples, size_t stride)
+{
+        CsvIterator *iterator = csv_iterator_open_path(reader, path);
+        Schema *result;
+
+        if (iterator == NULL)
+                return NULL;
+
+        result = csv_iterator_infer_schema(iterator, samples, stride);
+        csv_iterator_close(iterator);
+        return result;
+}
+
+Schema *schema_alloc(RecordView *header)
+{
+        Schema *result = malloc(sizeof(Schema));
+        size_t i;
+
+        if (result == NULL)
+                return NULL;
+
+        result->names = record_alloc(header->arraySize > 0 ? header->arraySize : 1);
+        result->columns = NULL;
+        result->columnCount = 0;
+        result->sampledRecords = 0;
+
+        if (result->names == NULL) {
+                schema_free(result);
+                return NULL;
+        }
+
+        for (i = 0; i < header->arraySize; i++) {
+                if (record_append_str(result->names, header->fields[i].data, header->fields[i].length) == NULL) {
+                        schema_free(result);
+                        return NULL;
+                }
+        }
+
+        if (schema_resize(result, header->arraySize) < 0) {
+                schema_free(result);
+                return NULL;
+        }
+
+        return result;
+}
+
+int schema_update(Schema *schema, RecordView *record)
+{
+        size_t i;
+
+        if (record->arraySize > schema->columnCount && schema_resize(schema, record->arraySize) < 0)
+                return -1;
+
+        for (i = 0; i < record->arraySize; i++) {
+                column_schema_update(&schema->columns[i], &record->fields[i]);
+        }
+
+        // Missing fields are null
+        for (; i < schema->columnCount; i++) {
+                schema->columns[i].nullCount++;
+        }
+
+        schema->sampledRecords++;
+        return 0;
+}
+
+inline int column_schema_nullable(const ColumnSchema *column)
+{
+        return column->nullCount > 0;
+}
+
+void schema_free(Schema *schema)
+{
+        if (schema == NULL)
+                return;
+
+        if (schema->names != NULL)
+                record_free(schema->names);
+        free(schema->columns);
+        free(schema);
+}
+
+// Private Implementation
+
+int schema_resize(Schema *schema, size_t count)
+{
+        ColumnSchema *columns;
+        size_t size = SCHEMA_SIZE;
+        size_t i;
+
+        while (size < count)
+                size *= 2;
+
+        columns = realloc(schema->columns, sizeof(ColumnSchema) * size);
+        if (columns == NULL)
+                return -1;
+
+        for (i = schema->columnCount; i < count; i++) {
+                columns[i].type = STRING_TYPE_EMPTY;
+                columns[i].nullCount = schema->sampledRecords;
+                columns[i].minWidth = 0;
+                columns[i].maxWidth = 0;
+        }
+
+        schema->columns = columns;
+        schema->columnCount = count;
+        return 0;
+}
+
+void column_schema_update(ColumnSchema *column, const FieldView *field)
+{
+        char type = string_type_len(field->data, field->length);
+
+        if (type == STRING_TYPE_EMPTY) {
+                column->nullCount++;
+                return;
+        }
+
+        if (column->type == STRING_TYPE_EMPTY || field->length < column->minWidth)
+                column->minWidth = field->length;
+        if (field->length > column->maxWidth)
+                column->maxWidth = field->length;
+
+        // Types are ordered by width: int, float, text
+        if (type > column->type)
+                column->type = type;
+}
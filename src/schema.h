@@ -0,0 +1,71 @@
+//
+// Created by Davide on 16/10/2026.
+//
+
+#ifndef C_CSV__SCHEMA_H
+#define C_CSV__SCHEMA_H
+
+#include <stdlib.h>
+
+#include "record.h"
+
+/**
+ * The inferred type of a column
+ * type is the widest type of its non empty fields: STRING_TYPE_INT,
+ * STRING_TYPE_FLOAT or STRING_TYPE_TEXT (see string_type_len), or
+ * STRING_TYPE_EMPTY if all the sampled fields are empty.
+ * nullCount is the number of sampled records whose field is empty or
+ * missing: the column is nullable if it is not 0.
+ * minWidth and maxWidth are the lengths in bytes of the shortest and of the
+ * longest non empty field (once unescaped), 0 if there are none
+ */
+typedef struct ColumnSchema_s {
+        char type;
+        size_t nullCount;
+        size_t minWidth;
+        size_t maxWidth;
+} ColumnSchema;
+
+/**
+ * The inferred schema of a csv file
+ * names is a copy of the header, columns holds columnCount column schemas,
+ * one for each field of the header, plus one for each field found past
+ * the end of the header in the sampled records.
+ * sampledRecords is the number of records the schema is inferred from
+ */
+typedef struct Schema_s {
+        Record *names;
+        ColumnSchema *columns;
+        size_t columnCount;
+        size_t sampledRecords;
+} Schema;
+
+/**
+ * Allocate an empty schema
+ * @param header the header of the csv file
+ * @return the schema, or NULL on error
+ */
+Schema *schema_alloc(RecordView *header);
+
+/**
+ * Update the schema with the fields of a record
+ * @param schema the schema
+ * @param record the record
+ * @return 0 on success, -1 on error
+ */
+int schema_update(Schema *schema, RecordView *record);
+
+/**
+ * Check if a column contains empty fields
+ * @param column the column schema
+ * @return 1 if the column is nullable, 0 otherwise
+ */
+int column_schema_nullable(const ColumnSchema *column);
+
+/**
+ * Free a schema
+ * @param schema the schema
+ */
+void schema_free(Schema *schema);
+
+#endif //C_CSV__SCHEMA_H
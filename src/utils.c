@@ -3,52 +3,759 @@
 //
 
 
+#include <errno.h>
+#include <float.h>
+#include <stdio.h>
 #include "utils.h"
+#include "powers.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define NUMBER_C_LOCALE
+#include <locale.h>
+#include <pthread.h>
+#endif
+
+#define is_space(c) ((c) == ' ' || ((c) >= '\t' && (c) <= '\r'))
+#define is_digit(c) ((c) >= '0' && (c) <= '9')
+
+#define NUMBER_LENGTH 64
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+#define EXACT_DOUBLE_LIMIT 9007199254740992.0
+#define EXACT_POWER_MAX 22
+#define MANTISSA_DIGITS 19
+#define EXPONENT_LIMIT 100000
+
+static const char digitPairs[] = "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+                                 "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+                                 "8081828384858687888990919293949596979899";
+
+#ifdef NUMBER_C_LOCALE
+typedef locale_t NumberLocale;
+
+// The C locale, whose decimal point is '.', created once
+static locale_t cLocale = (locale_t) 0;
+static pthread_once_t cLocaleOnce = PTHREAD_ONCE_INIT;
+#else
+typedef int NumberLocale;
+#endif
+
+// The powers of ten which are exactly represented by a double
+static const double powersOfTen[EXACT_POWER_MAX + 1] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                                        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21,
+                                                        1e22};
+
+// Private prototypes
+
+/**
+ * Count the decimal digits at the beginning of a string, 8 at a time
+ * @param str the string
+ * @param len length of the string
+ * @return the number of leading digits
+ */
+size_t count_digits(const char *str, size_t len);
+
+/**
+ * Check if the 8 bytes of a word are decimal digits
+ * @param word the bytes
+ * @return 1 if they are all digits, 0 otherwise
+ */
+int is_eight_digits(uint64_t word);
+
+/**
+ * Convert 8 decimal digits to their value with a few multiplications
+ * (SWAR), instead of one multiplication per digit
+ * @param str the digits, checked by is_eight_digits
+ * @return the value of the digits
+ */
+uint64_t parse_eight_digits(const char *str);
+
+/**
+ * Accumulate the decimal digits at the beginning of a string, 8 at a time.
+ * The value wraps around if there are more than 19 digits
+ * @param str the string
+ * @param len length of the string
+ * @param value input/output, the value of the digits is appended to it
+ * @return the number of digits
+ */
+size_t parse_digits(const char *str, size_t len, uint64_t *value);
+
+/**
+ * Compute the double nearest to mantissa * 10^exponent with the
+ * Eisel-Lemire algorithm: the mantissa is multiplied by a 128 bit
+ * approximation of the power of ten, which almost always determines the
+ * rounding
+ * @param mantissa the decimal mantissa, not zero
+ * @param exponent the decimal exponent
+ * @param value output, the absolute value of the double
+ * @return 0 on success, -1 if the approximation is not precise enough to
+ *         round correctly
+ */
+int eisel_lemire(uint64_t mantissa, int64_t exponent, double *value);
+
+/**
+ * Compute the full 128 bit product of two 64 bit integers
+ * @param a, b the factors
+ * @param low output, the low 64 bits of the product
+ * @return the high 64 bits of the product
+ */
+uint64_t multiply_128(uint64_t a, uint64_t b, uint64_t *low);
+
+/**
+ * Convert a number with strtod, for the few values that the fast paths
+ * cannot round correctly
+ * @param str the number
+ * @param len length of the number
+ * @param value output, the value
+ * @return 0 on success, -1 if the value is out of range
+ */
+int slow_string_to_double(const char *str, size_t len, double *value);
+
+/**
+ * Switch the calling thread to the C locale, for the numbers converted by
+ * the C library: strtod and printf read and write the decimal point of
+ * LC_NUMERIC, which is ',' in many locales
+ * @return the previous locale of the thread, to be restored with
+ *         number_locale_end
+ */
+NumberLocale number_locale_begin(void);
+
+/**
+ * Restore the locale of the calling thread (see number_locale_begin)
+ * @param previous the locale returned by number_locale_begin
+ */
+void number_locale_end(NumberLocale previous);
+
+#ifdef NUMBER_C_LOCALE
+/**
+ * Create the C locale, once
+ */
+void number_locale_init(void);
+#endif
+
+/**
+ * Copy a number in a null terminated string
+ * @param str the number
+ * @param len length of the number
+ * @param number a buffer of NUMBER_LENGTH bytes, used if the number fits
+ * @return the copy, number or a copy in the heap for longer numbers, to be
+ *         freed. NULL on error
+ */
+char *copy_number(const char *str, size_t len, char *number);
+
+/**
+ * Check that a number has been completely converted by strtod
+ * @param end the first character which has not been converted
+ * @return 0 if the rest of the string is made of spaces and the value is
+ *         in range, -1 otherwise
+ */
+int check_number_end(const char *end);
+
+/**
+ * Write the decimal digits of an unsigned integer, two at a time
+ * @param value the value
+ * @param minDigits the minimum number of digits, the value is padded with
+ *                  zeros
+ * @param str output, at least 20 bytes
+ * @return the number of digits
+ */
+size_t write_digits(uint64_t value, size_t minDigits, char *str);
+
+/**
+ * Convert a double to the shortest string which reads back as the same
+ * value (see double_to_string)
+ * @param value the value
+ * @param str output
+ * @return the length of the string
+ */
+size_t double_to_shortest_string(double value, char *str);
+
+
+// Public Implementation
 
 char *string_duplicate(const char *string, size_t len)
 {
         char *duplicate = malloc(sizeof(char) * (len + 1));
-        strcpy(duplicate, string);
+        if (duplicate == NULL)
+                return NULL;
+        memcpy(duplicate, string, len);
+        duplicate[len] = 0;
         return duplicate;
 }
 
 
-char string_type(const char *str)
+inline char string_type(const char *str)
 {
+        return string_type_len(str, strlen(str));
+}
+
+char string_type_len(const char *str, size_t len)
+{
+        size_t i = 0;
+        size_t digits;
         char type = STRING_TYPE_INT;
+
+        // Trim the string
+        while (len > 0 && is_space(str[len - 1]))
+                len--;
+        while (i < len && is_space(str[i]))
+                i++;
+
+        if (i == len)
+                return STRING_TYPE_EMPTY;
+
+        if (str[i] == '+' || str[i] == '-')
+                i++;
+
+        digits = count_digits(str + i, len - i);
+        i += digits;
+
+        if (i < len && str[i] == '.') {
+                type = STRING_TYPE_FLOAT;
+                i++;
+                digits += count_digits(str + i, len - i);
+                i += count_digits(str + i, len - i);
+        }
+
+        // At least a digit in the mantissa
+        if (digits == 0)
+                return STRING_TYPE_TEXT;
+
+        if (i < len && (str[i] == 'e' || str[i] == 'E')) {
+                type = STRING_TYPE_FLOAT;
+                i++;
+                if (i < len && (str[i] == '+' || str[i] == '-'))
+                        i++;
+                digits = count_digits(str + i, len - i);
+                if (digits == 0)
+                        return STRING_TYPE_TEXT;
+                i += digits;
+        }
+
+        return i == len ? type : STRING_TYPE_TEXT;
+}
+
+int string_to_int64(const char *str, size_t len, int64_t *value)
+{
         size_t i = 0;
-        char accept_sign = 1;
-        char decimal_found = 0;
+        size_t zeros;
+        size_t digits;
+        uint64_t magnitude = 0;
+        int negative = 0;
 
-        // Left trim the string
-        while (isspace(str[i]))
+        while (len > 0 && is_space(str[len - 1]))
+                len--;
+        while (i < len && is_space(str[i]))
                 i++;
 
-        while (str[i] != 0) {
+        if (i < len && (str[i] == '+' || str[i] == '-'))
+                negative = str[i++] == '-';
 
-                if (accept_sign && (str[i] == '+' || str[i] == '-')) {
-                        accept_sign = 0;
-                }
-                        // Search for the first decimal
-                else if (type <= STRING_TYPE_FLOAT && str[i] == '.' && !decimal_found) {
-                        decimal_found = 1;
-                        type = STRING_TYPE_FLOAT;
-                } else if (!isdigit(str[i])) {
-
-                        // Right trimming
-                        // the first non digit is a space, so find the first character
-                        // which is not a space
-                        while (isspace(str[i]))
+        // Leading zeros do not count towards the overflow
+        zeros = i;
+        while (i < len && str[i] == '0')
+                i++;
+        zeros = i - zeros;
+
+        digits = parse_digits(str + i, len - i, &magnitude);
+        if (zeros + digits == 0 || i + digits != len) {
+                errno = EINVAL;
+                return -1;
+        }
+
+        if (digits > MANTISSA_DIGITS || magnitude > (uint64_t) INT64_MAX + (uint64_t) negative) {
+                errno = ERANGE;
+                return -1;
+        }
+
+        *value = negative ? -(int64_t) (magnitude - 1) - 1 : (int64_t) magnitude;
+        return 0;
+}
+
+int string_to_double(const char *str, size_t len, double *value)
+{
+        size_t start;
+        size_t i = 0;
+        size_t zeros;
+        size_t integer;
+        size_t fraction = 0;
+        size_t exponentLength;
+        uint64_t mantissa = 0;
+        uint64_t exponentValue = 0;
+        int64_t exponent = 0;
+        int negative = 0;
+        int negativeExponent;
+        double result;
+
+        while (len > 0 && is_space(str[len - 1]))
+                len--;
+        while (i < len && is_space(str[i]))
+                i++;
+
+        start = i;
+        if (i < len && (str[i] == '+' || str[i] == '-'))
+                negative = str[i++] == '-';
+
+        // Leading zeros are not significant digits of the mantissa
+        zeros = i;
+        while (i < len && str[i] == '0')
+                i++;
+        zeros = i - zeros;
+
+        integer = parse_digits(str + i, len - i, &mantissa);
+        i += integer;
+
+        if (i < len && str[i] == '.') {
+                i++;
+                if (integer == 0) {
+                        exponent = (int64_t) i;
+                        while (i < len && str[i] == '0')
                                 i++;
+                        exponent -= (int64_t) i;
+                        zeros += (size_t) -exponent;
+                }
+                fraction = parse_digits(str + i, len - i, &mantissa);
+                i += fraction;
+                exponent -= (int64_t) fraction;
+        }
+
+        if (zeros + integer + fraction == 0) {
+                errno = EINVAL;
+                return -1;
+        }
 
-                        // It s the end of the string, so break
-                        if (str[i] == 0) {
-                                break;
-                        } else { // It is a character and the string is text
-                                return STRING_TYPE_TEXT;
-                        }
+        if (i < len && (str[i] == 'e' || str[i] == 'E')) {
+                i++;
+                negativeExponent = i < len && str[i] == '-';
+                if (i < len && (str[i] == '+' || str[i] == '-'))
+                        i++;
+                exponentLength = parse_digits(str + i, len - i, &exponentValue);
+                if (exponentLength == 0) {
+                        errno = EINVAL;
+                        return -1;
                 }
+                // Beyond the limit the value is zero or infinity anyway
+                if (exponentLength > 9 || exponentValue > EXPONENT_LIMIT)
+                        exponentValue = EXPONENT_LIMIT;
+                exponent += negativeExponent ? -(int64_t) exponentValue : (int64_t) exponentValue;
+                i += exponentLength;
+        }
+
+        if (i != len) {
+                errno = EINVAL;
+                return -1;
+        }
+
+        if (integer + fraction > MANTISSA_DIGITS)
+                return slow_string_to_double(str + start, len - start, value);
+
+        if (mantissa == 0) {
+                *value = negative ? -0.0 : 0.0;
+                return 0;
+        }
+
+#if FLT_EVAL_METHOD == 0
+        // Both the mantissa and the power of ten are exact, so the result is correctly rounded
+        if (mantissa <= (uint64_t) EXACT_DOUBLE_LIMIT && exponent >= -EXACT_POWER_MAX && exponent <= EXACT_POWER_MAX) {
+                result = (double) mantissa;
+                result = exponent < 0 ? result / powersOfTen[-exponent] : result * powersOfTen[exponent];
+                *value = negative ? -result : result;
+                return 0;
+        }
+#endif
+
+        if (eisel_lemire(mantissa, exponent, &result) < 0)
+                return slow_string_to_double(str + start, len - start, value);
+
+        if (result == 0 || result > DBL_MAX) {
+                errno = ERANGE;
+                return -1;
+        }
+
+        *value = negative ? -result : result;
+        return 0;
+}
+
+size_t int64_to_string(int64_t value, char *str)
+{
+        size_t len = 0;
+
+        if (value < 0)
+                str[len++] = '-';
+
+        len += write_digits(value < 0 ? 0 - (uint64_t) value : (uint64_t) value, 1, str + len);
+        str[len] = 0;
+        return len;
+}
+
+size_t double_to_string(double value, int decimals, char *str)
+{
+        NumberLocale locale;
+        double scaled;
+        uint64_t rounded;
+        uint64_t power;
+        size_t len = 0;
+
+        if (decimals < 0)
+                return double_to_shortest_string(value, str);
+
+        if (decimals > DOUBLE_MAX_DECIMALS)
+                decimals = DOUBLE_MAX_DECIMALS;
+
+        // NaN fails both comparisons
+        scaled = value * powersOfTen[decimals];
+        if (!(scaled > -EXACT_DOUBLE_LIMIT && scaled < EXACT_DOUBLE_LIMIT)) {
+                // The decimal point is '.' whatever the locale
+                locale = number_locale_begin();
+                len = (size_t) snprintf(str, NUMBER_STRING_LENGTH, "%.*f", decimals, value);
+                number_locale_end(locale);
+                return len;
+        }
+
+        if (scaled < 0) {
+                scaled = -scaled;
+                str[len++] = '-';
+        }
+
+        rounded = (uint64_t) (scaled + 0.5);
+        power = (uint64_t) powersOfTen[decimals];
+
+        // A value rounded to zero has no sign
+        if (rounded == 0)
+                len = 0;
+
+        len += write_digits(rounded / power, 1, str + len);
+        if (decimals > 0) {
+                str[len++] = '.';
+                len += write_digits(rounded % power, (size_t) decimals, str + len);
+        }
+
+        str[len] = 0;
+        return len;
+}
+
+uint64_t string_hash(const char *str, size_t len, uint64_t seed)
+{
+        uint64_t hash = FNV_OFFSET ^ (seed * FNV_PRIME);
+        size_t i;
+
+        for (i = 0; i < len; i++) {
+                hash ^= (unsigned char) str[i];
+                hash *= FNV_PRIME;
+        }
+
+        return hash ^ (hash >> 32);
+}
+
+// Private Implementation
+
+char *copy_number(const char *str, size_t len, char *number)
+{
+        // All the digits of a long mantissa may be needed to round it
+        if (len >= NUMBER_LENGTH)
+                return string_duplicate(str, len);
+
+        memcpy(number, str, len);
+        number[len] = 0;
+        return number;
+}
+
+int check_number_end(const char *end)
+{
+        // Trailing spaces are accepted by string_type_len
+        while (is_space(*end))
+                end++;
+
+        if (errno == ERANGE)
+                return -1;
+
+        if (*end != 0) {
+                errno = EINVAL;
+                return -1;
+        }
+        return 0;
+}
+
+size_t write_digits(uint64_t value, size_t minDigits, char *str)
+{
+        char digits[20];
+        size_t i = sizeof digits;
+        size_t len;
+
+        while (value >= 100) {
+                i -= 2;
+                memcpy(digits + i, digitPairs + 2 * (value % 100), 2);
+                value /= 100;
+        }
+
+        if (value >= 10) {
+                i -= 2;
+                memcpy(digits + i, digitPairs + 2 * value, 2);
+        } else {
+                digits[--i] = (char) ('0' + value);
+        }
+
+        while (sizeof digits - i < minDigits)
+                digits[--i] = '0';
+
+        len = sizeof digits - i;
+        memcpy(str, digits + i, len);
+        return len;
+}
+
+size_t double_to_shortest_string(double value, char *str)
+{
+        NumberLocale locale;
+        int precision;
+        int len = 0;
+
+        // Integers are exact, their digits are the shortest representation
+        if (value > -EXACT_DOUBLE_LIMIT && value < EXACT_DOUBLE_LIMIT && value == (double) (int64_t) value)
+                return int64_to_string((int64_t) value, str);
+
+        // 15 significant digits are always exact, 17 always read back as the
+        // same value. The decimal point is '.' whatever the locale
+        locale = number_locale_begin();
+        for (precision = 15; precision <= 17; precision++) {
+                len = snprintf(str, NUMBER_STRING_LENGTH, "%.*g", precision, value);
+                if (strtod(str, NULL) == value)
+                        break;
+        }
+        number_locale_end(locale);
+        return (size_t) len;
+}
+
+size_t count_digits(const char *str, size_t len)
+{
+        size_t i = 0;
+        uint64_t word;
+
+        for (; i + 8 <= len; i += 8) {
+                memcpy(&word, str + i, sizeof word);
+                if (!is_eight_digits(word))
+                        break;
+        }
+
+        while (i < len && is_digit(str[i]))
                 i++;
+
+        return i;
+}
+
+inline int is_eight_digits(uint64_t word)
+{
+        // Each byte is a digit iff its high nibble is 3 and adding 6 does not carry into it
+        return ((word & 0xF0F0F0F0F0F0F0F0) |
+                (((word + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) == 0x3333333333333333;
+}
+
+inline uint64_t parse_eight_digits(const char *str)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        uint64_t value = 0;
+        size_t i;
+
+        for (i = 0; i < 8; i++) {
+                value = value * 10 + (uint64_t) (str[i] - '0');
+        }
+        return value;
+#else
+        uint64_t word;
+
+        // The first digit is in the lowest byte: adjacent digits, then pairs,
+        // then quadruples are merged by multiplying by 10, 100 and 10000
+        memcpy(&word, str, sizeof word);
+        word = ((word & 0x0F0F0F0F0F0F0F0F) * 2561) >> 8;
+        word = ((word & 0x00FF00FF00FF00FF) * 6553601) >> 16;
+        return ((word & 0x0000FFFF0000FFFF) * 42949672960001) >> 32;
+#endif
+}
+
+size_t parse_digits(const char *str, size_t len, uint64_t *value)
+{
+        size_t i = 0;
+        uint64_t result = *value;
+        uint64_t word;
+
+        for (; i + 8 <= len; i += 8) {
+                memcpy(&word, str + i, sizeof word);
+                if (!is_eight_digits(word))
+                        break;
+                result = result * 100000000 + parse_eight_digits(str + i);
+        }
+
+        for (; i < len && is_digit(str[i]); i++) {
+                result = result * 10 + (uint64_t) (str[i] - '0');
+        }
+
+        *value = result;
+        return i;
+}
+
+int eisel_lemire(uint64_t mantissa, int64_t exponent, double *value)
+{
+        const uint64_t *power;
+        uint64_t high;
+        uint64_t low;
+        uint64_t secondHigh;
+        uint64_t secondLow;
+        uint64_t bits;
+        int64_t power2;
+        int upper;
+        int shift = 0;
+
+        if (exponent < POWER_OF_FIVE_MIN) {
+                *value = 0;
+                return 0;
+        }
+        if (exponent > POWER_OF_FIVE_MAX) {
+                *value = DBL_MAX * 2;
+                return 0;
+        }
+
+#if defined(__GNUC__)
+        shift = __builtin_clzll(mantissa);
+#else
+        while (!(mantissa << shift & 0x8000000000000000))
+                shift++;
+#endif
+        mantissa <<= shift;
+
+        // 10^q = 5^q * 2^q: the power of two only moves the binary exponent
+        power = powersOfFive[exponent - POWER_OF_FIVE_MIN];
+        high = multiply_128(mantissa, power[0], &low);
+
+        // The bits below the 55 bits of the result are all ones, they may be
+        // changed by the truncated part of the power
+        if ((high & 0x1FF) == 0x1FF) {
+                secondHigh = multiply_128(mantissa, power[1], &secondLow);
+                low += secondHigh;
+                if (secondHigh > low)
+                        high++;
+                if (low == 0xFFFFFFFFFFFFFFFF && (exponent < -27 || exponent > 55))
+                        return -1;
         }
-        return type;
-}
\ No newline at end of file
+
+        upper = (int) (high >> 63);
+        bits = high >> (upper + 9);
+        // floor(log2(10^q)) + 63, plus the bias of the exponent
+        power2 = ((217706 * exponent) >> 16) + 63 + upper - shift + 1023;
+
+        if (power2 <= 0) {
+                // Subnormal, the exponent is stored as 0
+                if (-power2 + 1 >= 64) {
+                        *value = 0;
+                        return 0;
+                }
+                bits >>= -power2 + 1;
+                bits += bits & 1;
+                bits >>= 1;
+                power2 = bits < (1ULL << 52) ? 0 : 1;
+        } else {
+                // Exactly halfway between two doubles: round to even
+                if (low <= 1 && exponent >= -4 && exponent <= 23 && (bits & 3) == 1 &&
+                    (bits << (upper + 9)) == high)
+                        bits &= ~(uint64_t) 1;
+
+                bits += bits & 1;
+                bits >>= 1;
+                if (bits >= (2ULL << 52)) {
+                        bits = 1ULL << 52;
+                        power2++;
+                }
+
+                if (power2 >= 0x7FF) {
+                        *value = DBL_MAX * 2;
+                        return 0;
+                }
+        }
+
+        bits = (bits & ((1ULL << 52) - 1)) | (uint64_t) power2 << 52;
+        memcpy(value, &bits, sizeof *value);
+        return 0;
+}
+
+inline uint64_t multiply_128(uint64_t a, uint64_t b, uint64_t *low)
+{
+#if defined(__SIZEOF_INT128__)
+        __extension__ unsigned __int128 product = (unsigned __int128) a * b;
+
+        *low = (uint64_t) product;
+        return (uint64_t) (product >> 64);
+#else
+        uint64_t aLow = a & 0xFFFFFFFF;
+        uint64_t aHigh = a >> 32;
+        uint64_t bLow = b & 0xFFFFFFFF;
+        uint64_t bHigh = b >> 32;
+        uint64_t lowLow = aLow * bLow;
+        uint64_t highLow = aHigh * bLow;
+        uint64_t lowHigh = aLow * bHigh;
+        uint64_t middle = (lowLow >> 32) + (highLow & 0xFFFFFFFF) + lowHigh;
+
+        *low = (middle << 32) | (lowLow & 0xFFFFFFFF);
+        return aHigh * bHigh + (highLow >> 32) + (middle >> 32);
+#endif
+}
+
+int slow_string_to_double(const char *str, size_t len, double *value)
+{
+        char buffer[NUMBER_LENGTH];
+        char *number = copy_number(str, len, buffer);
+        NumberLocale locale;
+        char *end;
+        int result;
+        int error;
+
+        if (number == NULL)
+                return -1;
+
+        locale = number_locale_begin();
+        errno = 0;
+        *value = strtod(number, &end);
+        // Subnormal values are accepted, as by the fast paths
+        if (errno == ERANGE && *value != 0 && *value >= -DBL_MAX && *value <= DBL_MAX)
+                errno = 0;
+        result = check_number_end(end);
+        error = errno;
+        number_locale_end(locale);
+        errno = error;
+
+        if (number != buffer) {
+                error = errno;
+                free(number);
+                errno = error;
+        }
+        return result;
+}
+
+#ifdef NUMBER_C_LOCALE
+NumberLocale number_locale_begin(void)
+{
+        pthread_once(&cLocaleOnce, &number_locale_init);
+
+        // Without the C locale the numbers are converted in the current one
+        if (cLocale == (locale_t) 0)
+                return (locale_t) 0;
+        return uselocale(cLocale);
+}
+
+void number_locale_end(NumberLocale previous)
+{
+        if (previous != (locale_t) 0)
+                uselocale(previous);
+}
+
+void number_locale_init(void)
+{
+        cLocale = newlocale(LC_ALL_MASK, "C", (locale_t) 0);
+}
+#else
+NumberLocale number_locale_begin(void)
+{
+        return 0;
+}
+
+void number_locale_end(NumberLocale previous)
+{
+}
+#endif
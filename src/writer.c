@@ -0,0 +1,514 @@
+//
+// Created by Davide on 16/10/2026.
+//
+
+#include <errno.h>
+#include <utils.h>
+#include "parser.h"
+
+#ifdef CSV_POSIX
+#include <sys/uio.h>
+#endif
+
+/**
+ * A buffered CSV writer
+ *
+ * @param file, fd the output: file is NULL when writing to a file
+ *                 descriptor, fd is -1 when writing to a FILE *
+ * @param ownsOutput 1 if the output has been opened by csv_writer_open_path
+ *                   and must be closed with the writer
+ * @param buffer the output buffer, holding length bytes out of capacity
+ * @param dialect the syntax of the output
+ * @param scanChars the characters which require a field to be quoted, but
+ *                  the escape (the carriage return is stored as escape)
+ * @param special 1 for the characters which require a field to be quoted
+ * @param fieldCount number of fields written in the current record
+ * @param error the errno of the first failed write, 0 if none failed
+ */
+struct CsvWriter_s {
+        FILE *file;
+        int fd;
+        int ownsOutput;
+        char *buffer;
+        size_t length;
+        size_t capacity;
+        Dialect dialect;
+        ScanChars scanChars;
+        char special[256];
+        size_t fieldCount;
+        int error;
+};
+
+
+// Private prototypes
+
+/**
+ * Allocate a writer with the default dialect
+ * @return the writer, or NULL on error
+ */
+CsvWriter *writer_alloc(void);
+
+/**
+ * Write bytes to the output, bypassing the buffer
+ * @param writer the writer
+ * @param data the bytes
+ * @param len number of bytes
+ */
+void writer_output(CsvWriter *writer, const char *data, size_t len);
+
+/**
+ * Write the buffer to the output
+ * @param writer the writer
+ */
+void writer_flush_buffer(CsvWriter *writer);
+
+/**
+ * Append bytes to the buffer. Data larger than the buffer is written
+ * together with the buffer, with a single writev when possible
+ * @param writer the writer
+ * @param data the bytes
+ * @param len number of bytes
+ */
+void writer_append(CsvWriter *writer, const char *data, size_t len);
+
+/**
+ * Append a character to the buffer
+ * @param writer the writer
+ * @param c the character
+ */
+void writer_append_char(CsvWriter *writer, char c);
+
+/**
+ * Check if a field must be quoted (or escaped, if the dialect has no quote).
+ * Long fields are checked 64 bytes at a time by the scan kernels, the rest
+ * a byte at a time
+ * @param writer the writer
+ * @param field the field
+ * @param len length of the field
+ * @return 1 if the field contains a delimiter, a quote, a line ending or an
+ *         escape character, or if it must be protected from trimming
+ */
+int writer_needs_quotes(const CsvWriter *writer, const char *field, size_t len);
+
+/**
+ * Append a field which must be quoted. Quotes are doubled a span at a time
+ * @param writer the writer
+ * @param field the field
+ * @param len length of the field
+ * @return 0 on success, -1 if the dialect cannot represent the field: it
+ *         has neither a quote nor an escape character, or the field
+ *         contains a quote and the dialect has no escape character. The
+ *         error of the writer is then set to EINVAL
+ */
+int writer_quote(CsvWriter *writer, const char *field, size_t len);
+
+/**
+ * Append a field putting the escape character of the dialect before each
+ * character which needs it
+ * @param writer the writer
+ * @param field the field
+ * @param len length of the field
+ * @param quoted 1 if the field is enclosed in quotes: only quotes and
+ *               escape characters are escaped, otherwise delimiters, line
+ *               endings and, if the dialect trims the fields, blanks are
+ */
+void writer_escape(CsvWriter *writer, const char *field, size_t len, int quoted);
+
+/**
+ * @param writer the writer
+ * @return 0 if no write failed, -1 otherwise (errno is set accordingly)
+ */
+int writer_status(const CsvWriter *writer);
+
+
+// Public Implementation
+
+CsvWriter *csv_writer_open(FILE *csvFile)
+{
+        CsvWriter *result = writer_alloc();
+        if (result == NULL)
+                return NULL;
+        result->file = csvFile;
+        return result;
+}
+
+#ifdef CSV_POSIX
+CsvWriter *csv_writer_open_fd(int fd)
+{
+        CsvWriter *result = writer_alloc();
+        if (result == NULL)
+                return NULL;
+        result->fd = fd;
+        return result;
+}
+#endif
+
+CsvWriter *csv_writer_open_path(const char *path)
+{
+        CsvWriter *result;
+#ifdef CSV_POSIX
+        int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+        if (fd < 0)
+                return NULL;
+
+        result = csv_writer_open_fd(fd);
+        if (result == NULL) {
+                close(fd);
+                return NULL;
+        }
+#else
+        FILE *csvFile = fopen(path, "wb");
+
+        if (csvFile == NULL)
+                return NULL;
+
+        result = csv_writer_open(csvFile);
+        if (result == NULL) {
+                fclose(csvFile);
+                return NULL;
+        }
+#endif
+        result->ownsOutput = 1;
+        return result;
+}
+
+int csv_writer_set_dialect(CsvWriter *writer, const Dialect *dialect)
+{
+        if (!dialect_valid(dialect)) {
+                errno = EINVAL;
+                return -1;
+        }
+
+        writer->dialect = *dialect;
+        writer->scanChars.separator = dialect->delimiter;
+        writer->scanChars.quote = dialect->quote;
+        writer->scanChars.newLine = NEW_LINE;
+        writer->scanChars.escape = CARRIAGE_RETURN;
+
+        memset(writer->special, 0, sizeof writer->special);
+        writer->special[(unsigned char) dialect->delimiter] = 1;
+        writer->special[(unsigned char) dialect->quote] = 1;
+        writer->special[(unsigned char) dialect->escape] = 1;
+        writer->special[NEW_LINE] = 1;
+        writer->special[CARRIAGE_RETURN] = 1;
+        // A quote or an escape equal to 0 is not a character
+        writer->special[0] = 0;
+        return 0;
+}
+
+int csv_writer_field(CsvWriter *writer, const char *field, size_t len)
+{
+        if (writer->fieldCount > 0)
+                writer_append_char(writer, writer->dialect.delimiter);
+        writer->fieldCount += 1;
+
+        if (!writer_needs_quotes(writer, field, len))
+                writer_append(writer, field, len);
+        else if (writer_quote(writer, field, len) < 0)
+                return -1;
+
+        return writer_status(writer);
+}
+
+int csv_writer_field_int64(CsvWriter *writer, int64_t value)
+{
+        char number[NUMBER_STRING_LENGTH];
+        return csv_writer_field(writer, number, int64_to_string(value, number));
+}
+
+int csv_writer_field_double(CsvWriter *writer, double value, int decimals)
+{
+        char number[NUMBER_STRING_LENGTH];
+        return csv_writer_field(writer, number, double_to_string(value, decimals, number));
+}
+
+int csv_writer_end_record(CsvWriter *writer)
+{
+        writer_append_char(writer, dialect_new_line(&writer->dialect));
+        writer->fieldCount = 0;
+        return writer_status(writer);
+}
+
+int csv_writer_write_record(CsvWriter *writer, const Record *record)
+{
+        size_t i;
+
+        for (i = 0; i < record->arraySize; i++) {
+                csv_writer_field(writer, record->fields[i], strlen(record->fields[i]));
+        }
+        return csv_writer_end_record(writer);
+}
+
+int csv_writer_write_view(CsvWriter *writer, const RecordView *record)
+{
+        size_t i;
+
+        for (i = 0; i < record->arraySize; i++) {
+                csv_writer_field(writer, record->fields[i].data, record->fields[i].length);
+        }
+        return csv_writer_end_record(writer);
+}
+
+int csv_writer_flush(CsvWriter *writer)
+{
+        writer_flush_buffer(writer);
+
+        if (writer->file != NULL && !writer->error && fflush(writer->file) != 0)
+                writer->error = errno;
+
+        return writer_status(writer);
+}
+
+int csv_writer_close(CsvWriter *writer)
+{
+        int result = csv_writer_flush(writer);
+        int error = writer->error;
+
+        if (writer->ownsOutput) {
+#ifdef CSV_POSIX
+                if (close(writer->fd) < 0 && result == 0) {
+                        error = errno;
+                        result = -1;
+                }
+#else
+                if (fclose(writer->file) != 0 && result == 0) {
+                        error = errno;
+                        result = -1;
+                }
+#endif
+        }
+
+        free(writer->buffer);
+        free(writer);
+
+        if (result < 0)
+                errno = error;
+        return result;
+}
+
+// Private Implementation
+
+CsvWriter *writer_alloc(void)
+{
+        CsvWriter *result = malloc(sizeof(CsvWriter));
+        Dialect dialect;
+
+        if (result == NULL)
+                return NULL;
+
+        result->capacity = BLOCK_SIZE;
+        result->buffer = malloc(result->capacity);
+        if (result->buffer == NULL) {
+                free(result);
+                return NULL;
+        }
+
+        result->file = NULL;
+        result->fd = -1;
+        result->ownsOutput = 0;
+        result->length = 0;
+        result->fieldCount = 0;
+        result->error = 0;
+
+        dialect_init(&dialect, ',');
+        csv_writer_set_dialect(result, &dialect);
+        return result;
+}
+
+void writer_output(CsvWriter *writer, const char *data, size_t len)
+{
+#ifdef CSV_POSIX
+        ssize_t written;
+#endif
+
+        if (writer->error || len == 0)
+                return;
+
+#ifdef CSV_POSIX
+        if (writer->fd >= 0) {
+                while (len > 0) {
+                        written = write(writer->fd, data, len);
+                        if (written < 0 && errno == EINTR)
+                                continue;
+                        if (written < 0) {
+                                writer->error = errno;
+                                return;
+                        }
+                        data += written;
+                        len -= (size_t) written;
+                }
+                return;
+        }
+#endif
+
+        if (fwrite(data, 1, len, writer->file) != len)
+                writer->error = errno != 0 ? errno : EIO;
+}
+
+void writer_flush_buffer(CsvWriter *writer)
+{
+        writer_output(writer, writer->buffer, writer->length);
+        writer->length = 0;
+}
+
+void writer_append(CsvWriter *writer, const char *data, size_t len)
+{
+#ifdef CSV_POSIX
+        struct iovec vector[2];
+        ssize_t written;
+#endif
+
+        if (len <= writer->capacity - writer->length) {
+                memcpy(writer->buffer + writer->length, data, len);
+                writer->length += len;
+                return;
+        }
+
+        if (len < writer->capacity) {
+                writer_flush_buffer(writer);
+                memcpy(writer->buffer, data, len);
+                writer->length = len;
+                return;
+        }
+
+#ifdef CSV_POSIX
+        if (writer->fd >= 0 && !writer->error) {
+                vector[0].iov_base = writer->buffer;
+                vector[0].iov_len = writer->length;
+                vector[1].iov_base = (void *) data;
+                vector[1].iov_len = len;
+
+                do {
+                        written = writev(writer->fd, vector, 2);
+                } while (written < 0 && errno == EINTR);
+
+                if (written < 0) {
+                        writer->error = errno;
+                        return;
+                }
+
+                // The rest of a partial write is written normally
+                if ((size_t) written < writer->length) {
+                        writer_output(writer, writer->buffer + written, writer->length - (size_t) written);
+                        written = (ssize_t) writer->length;
+                }
+                writer->length = 0;
+                writer_output(writer, data + ((size_t) written - vector[0].iov_len),
+                              len - ((size_t) written - vector[0].iov_len));
+                return;
+        }
+#endif
+
+        writer_flush_buffer(writer);
+        writer_output(writer, data, len);
+}
+
+inline void writer_append_char(CsvWriter *writer, char c)
+{
+        if (writer->length == writer->capacity)
+                writer_flush_buffer(writer);
+        writer->buffer[writer->length++] = c;
+}
+
+int writer_needs_quotes(const CsvWriter *writer, const char *field, size_t len)
+{
+        ScanMasks masks;
+        size_t i = 0;
+
+        if (writer->dialect.trim && len > 0 && (is_blank(field[0]) || is_blank(field[len - 1])))
+                return 1;
+
+        if (len >= SCAN_BLOCK_SIZE) {
+                // The escape character is not among the scanned ones
+                if (writer->special[(unsigned char) writer->dialect.escape] &&
+                    writer->dialect.escape != writer->dialect.quote &&
+                    memchr(field, writer->dialect.escape, len) != NULL)
+                        return 1;
+
+                for (; i + SCAN_BLOCK_SIZE <= len; i += SCAN_BLOCK_SIZE) {
+                        scan_block(field + i, &writer->scanChars, &masks);
+                        if (masks.separator | masks.dquote | masks.newLine | masks.escape)
+                                return 1;
+                }
+        }
+
+        for (; i < len; i++) {
+                if (writer->special[(unsigned char) field[i]])
+                        return 1;
+        }
+
+        return 0;
+}
+
+int writer_quote(CsvWriter *writer, const char *field, size_t len)
+{
+        const char quote = writer->dialect.quote;
+        const char escape = writer->dialect.escape;
+        const char *end = field + len;
+        const char *found;
+
+        // The field would be read back differently: the writer fails, as
+        // the record cannot be completed
+        if ((quote == 0 && escape == 0) || (escape == 0 && memchr(field, quote, len) != NULL)) {
+                if (!writer->error)
+                        writer->error = EINVAL;
+                errno = writer->error;
+                return -1;
+        }
+
+        // Without quotes the special characters are escaped
+        if (quote == 0) {
+                writer_escape(writer, field, len, 0);
+                return 0;
+        }
+
+        writer_append_char(writer, quote);
+
+        if (escape == quote) {
+                // Each span ending with a quote is copied, then the quote is doubled
+                while ((found = memchr(field, quote, (size_t) (end - field))) != NULL) {
+                        writer_append(writer, field, (size_t) (found - field) + 1);
+                        writer_append_char(writer, quote);
+                        field = found + 1;
+                }
+                writer_append(writer, field, (size_t) (end - field));
+        } else if (escape != 0) {
+                writer_escape(writer, field, len, 1);
+        } else {
+                writer_append(writer, field, len);
+        }
+
+        writer_append_char(writer, quote);
+        return 0;
+}
+
+void writer_escape(CsvWriter *writer, const char *field, size_t len, int quoted)
+{
+        const Dialect *dialect = &writer->dialect;
+        size_t start = 0;
+        size_t i;
+        char c;
+
+        for (i = 0; i < len; i++) {
+                c = field[i];
+                if (c == dialect->escape || (quoted ? c == dialect->quote :
+                                             c == dialect->delimiter || c == NEW_LINE || c == CARRIAGE_RETURN ||
+                                             (dialect->trim && is_blank(c)))) {
+                        writer_append(writer, field + start, i - start);
+                        writer_append_char(writer, dialect->escape);
+                        start = i;
+                }
+        }
+
+        writer_append(writer, field + start, len - start);
+}
+
+inline int writer_status(const CsvWriter *writer)
+{
+        if (writer->error) {
+                errno = writer->error;
+                return -1;
+        }
+        return 0;
+}
@@ -2,63 +2,284 @@
 // Created by Davide on 30/10/2021.
 //
 
+#include <locale.h>
 #include <stdio.h>
-#include <time.h>
-#include <sys/time.h>
-#include "csv.h"
+#include <string.h>
 
-size_t fields = 0;
-size_t records = 0;
+#include "test.h"
 
+int testFailures = 0;
 
+const size_t testBlockSizes[TEST_BLOCK_SIZES] = {0, 1, 2, 5, 16, 4096};
 
-void headerCallback(void *ctx, Record *header)
+static uint64_t testSeed = 1;
+
+// Helpers
+
+static void test_records_reserve(TestRecords *records, size_t len)
 {
-        fields += header->arraySize;
-        records += 1;
-        printf("Record [%lu]:\n", header->arraySize);
-        for (int i = 0; i < header->arraySize; i++) {
-                printf("\t%d: %s\n", i, header->fields[i]);
+        if (records->length + len <= records->capacity) return;
+        while (records->length + len > records->capacity)
+                records->capacity = records->capacity > 0 ? records->capacity * 2 : 4096;
+        records->data = realloc(records->data, records->capacity);
+        if (records->data == NULL) {
+                perror("Cannot alloc test records");
+                abort();
         }
 }
 
-void recordCallback(void *ctx, Record *header, Record *record) { headerCallback(ctx, record); }
+void test_records_append_field(TestRecords *records, const char *field, size_t len)
+{
+        test_records_reserve(records, len + 1);
+        memcpy(records->data + records->length, field, len);
+        records->length += len;
+        records->data[records->length++] = TEST_FIELD_END;
+}
 
-int main()
+void test_records_end(TestRecords *records)
+{
+        test_records_reserve(records, 1);
+        records->data[records->length++] = TEST_RECORD_END;
+        records->records++;
+}
+
+void test_records_append_view(TestRecords *records, const RecordView *record)
+{
+        size_t i;
+        for (i = 0; i < record->arraySize; i++)
+                test_records_append_field(records, record->fields[i].data, record->fields[i].length);
+        test_records_end(records);
+}
+
+void test_records_append(TestRecords *records, const Record *record)
+{
+        size_t i;
+        for (i = 0; i < record->arraySize; i++)
+                test_records_append_field(records, record->fields[i], strlen(record->fields[i]));
+        test_records_end(records);
+}
+
+int test_records_equal(const TestRecords *a, const TestRecords *b)
+{
+        return a->records == b->records && a->length == b->length &&
+               (a->length == 0 || memcmp(a->data, b->data, a->length) == 0);
+}
+
+void test_records_free(TestRecords *records)
+{
+        free(records->data);
+        memset(records, 0, sizeof(TestRecords));
+}
+
+void test_random_seed(uint64_t seed)
+{
+        testSeed = seed;
+}
+
+unsigned test_random(unsigned bound)
+{
+        testSeed = testSeed * 6364136223846793005ULL + 1442695040888963407ULL;
+        return (unsigned) (testSeed >> 33) % bound;
+}
+
+void test_header_view(void *context, RecordView *header) { test_records_append_view(context, header); }
+
+void test_record_view(void *context, RecordView *header, RecordView *record) { test_records_append_view(context, record); }
+
+void test_header(void *context, Record *header) { test_records_append(context, header); }
+
+void test_record(void *context, Record *header, Record *record) { test_records_append(context, record); }
+
+char *test_read_file(const char *path, size_t *len)
+{
+        FILE *file = fopen(path, "rb");
+        char *data;
+        long size;
+        if (file == NULL) return NULL;
+        fseek(file, 0, SEEK_END);
+        size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+        data = malloc(size > 0 ? size : 1);
+        if (data == NULL || fread(data, 1, size, file) != (size_t) size) {
+                free(data);
+                fclose(file);
+                return NULL;
+        }
+        fclose(file);
+        *len = size;
+        return data;
+}
+
+int test_write_file(const char *path, const char *data, size_t len)
 {
+        FILE *file = fopen(path, "wb");
+        if (file == NULL) return -1;
+        if (fwrite(data, 1, len, file) != len) {
+                fclose(file);
+                return -1;
+        }
+        return fclose(file) == 0 ? 0 : -1;
+}
+
+int test_comma_locale(void)
+{
+        static const char *locales[] = {"de_DE.UTF-8", "de_DE.utf8", "fr_FR.UTF-8", "fr_FR.utf8", "it_IT.UTF-8",
+                                        "it_IT.utf8", "nl_NL.UTF-8", "ru_RU.UTF-8", "de_DE", "fr_FR"};
         size_t i;
-        double sum = 0.0;
-        int iterations = 1;
-        for (i = 0; i < iterations; i++) {
-                struct timeval start, end;
-                gettimeofday(&start, NULL);
 
-                CsvReader *reader = csv_reader_alloc(&headerCallback, &recordCallback, NULL);
-                FILE *csv = fopen("../test/test2.csv", "r");
+        for (i = 0; i < sizeof(locales) / sizeof(locales[0]); i++) {
+                if (setlocale(LC_NUMERIC, locales[i]) != NULL && strcmp(localeconv()->decimal_point, ",") == 0)
+                        return 1;
+        }
+        setlocale(LC_NUMERIC, "C");
+        return 0;
+}
 
-                if (!csv) fprintf(stderr, "Cannot open file\n");
+// Views
 
-                csv_reader_parse(reader, csv);
+/**
+ * Parse a file with views and with records, from a stream read in blocks
+ * of blockSize bytes and from memory
+ */
+static void test_views_file(const char *path, const TestRecords *expected, size_t count)
+{
+        size_t i, len;
+        char *data = test_read_file(path, &len);
+        TEST_ASSERT(data != NULL);
+        if (data == NULL) return;
+
+        for (i = 0; i < TEST_BLOCK_SIZES; i++) {
+                TestRecords views = {0}, records = {0}, memory = {0};
+                CsvReader *reader = csv_reader_alloc_view(&test_header_view, &test_record_view, &views);
+                CsvReader *recordReader = csv_reader_alloc(&test_header, &test_record, &records);
+                FILE *csv = fopen(path, "rb");
+                TEST_ASSERT(csv != NULL);
+                if (csv == NULL) break;
 
+                csv_reader_set_block_size(reader, testBlockSizes[i]);
+                TEST_ASSERT(csv_reader_parse(reader, csv) == 0);
                 fclose(csv);
+                csv = fopen(path, "rb");
+                csv_reader_set_block_size(recordReader, testBlockSizes[i]);
+                TEST_ASSERT(csv_reader_parse(recordReader, csv) == 0);
+                fclose(csv);
+                csv_reader_free(reader);
+                csv_reader_free(recordReader);
+
+                reader = csv_reader_alloc_view(&test_header_view, &test_record_view, &memory);
+                TEST_ASSERT(csv_reader_parse_memory(reader, data, len) == 0);
                 csv_reader_free(reader);
-                gettimeofday(&end, NULL);
-                sum += (end.tv_sec * 1000.0) + (end.tv_usec / 1000.0) - (start.tv_sec * 1000.0) - (start.tv_usec / 1000.0);
+
+                TEST_ASSERT(views.records == count);
+                TEST_ASSERT(test_records_equal(&views, &records));
+                TEST_ASSERT(test_records_equal(&views, &memory));
+                if (expected != NULL) TEST_ASSERT(test_records_equal(&views, expected));
+                test_records_free(&views);
+                test_records_free(&records);
+                test_records_free(&memory);
         }
+        free(data);
+}
 
-        printf("Read %lu records %lu fields in %.3lf ms\n", records/iterations, fields/iterations, sum/iterations);
-        return 0;
+/**
+ * Parse a string with views, from memory and from a stream read in blocks
+ * of every size in testBlockSizes, and compare the fields with the expected
+ * ones: fields are separated by '|' and records by '$' in expected
+ */
+static void test_views_string(const char *csv, const char *expected)
+{
+        TestRecords wanted = {0};
+        const char *field = expected, *c;
+        size_t i;
+
+        for (c = expected; ; c++) {
+                if (*c == '|' || *c == '$' || *c == '\0') {
+                        if (*c == '\0' && c == field) break;
+                        test_records_append_field(&wanted, field, c - field);
+                        if (*c != '|') test_records_end(&wanted);
+                        if (*c == '\0') break;
+                        field = c + 1;
+                }
+        }
+
+        for (i = 0; i < TEST_BLOCK_SIZES; i++) {
+                TestRecords views = {0};
+                CsvReader *reader = csv_reader_alloc_view(&test_header_view, &test_record_view, &views);
+                FILE *stream = fmemopen((void *) csv, strlen(csv), "r");
+                csv_reader_set_block_size(reader, testBlockSizes[i]);
+                TEST_ASSERT(csv_reader_parse(reader, stream) == 0);
+                fclose(stream);
+                csv_reader_free(reader);
+                if (!test_records_equal(&views, &wanted)) {
+                        fprintf(stderr, "views of \"%s\" with blocks of %lu bytes differ\n", csv, testBlockSizes[i]);
+                        testFailures++;
+                }
+                test_records_free(&views);
+        }
+
+        {
+                TestRecords views = {0};
+                CsvReader *reader = csv_reader_alloc_view(&test_header_view, &test_record_view, &views);
+                TEST_ASSERT(csv_reader_parse_memory(reader, csv, strlen(csv)) == 0);
+                csv_reader_free(reader);
+                if (!test_records_equal(&views, &wanted)) {
+                        fprintf(stderr, "views of \"%s\" in memory differ\n", csv);
+                        testFailures++;
+                }
+                test_records_free(&views);
+        }
+        test_records_free(&wanted);
 }
 
-int main2()
+void test_views(void)
 {
-        CsvReader *reader = csv_reader_alloc(&headerCallback, &recordCallback, NULL);
-        FILE *csv = fopen("../test/test.csv", "r");
+        TestRecords expected = {0};
+        test_records_append_field(&expected, "ciao", 4);
+        test_records_append_field(&expected, " mondo", 6);
+        test_records_append_field(&expected, "quoted nell'\"header\"", 20);
+        test_records_end(&expected);
+        test_records_append_field(&expected, "1", 1);
+        test_records_append_field(&expected, "2", 1);
+        test_records_append_field(&expected, "3\n4,5,6\"", 8);
+        test_records_end(&expected);
+        test_records_append_field(&expected, "7", 1);
+        test_records_append_field(&expected, "8", 1);
+        test_records_append_field(&expected, "9", 1);
+        test_records_end(&expected);
+        test_views_file("../test/test.csv", &expected, 3);
+        test_records_free(&expected);
+
+        test_views_file("../test/test2.csv", NULL, 8615);
 
-        if (!csv) fprintf(stderr, "Cannot open file\n");
+        // Quoted, escaped and multiline fields, CRLF and a missing final new line
+        test_views_string("a,b,c\n\"x\",\"\",\"\"\"\"\n", "a|b|c$x||\"$");
+        test_views_string("a,b\r\n\"1\"\"2\",\"3\r\n4\"\r\n5,6", "a|b$1\"2|3\r\n4$5|6$");
+        test_views_string("h\n\"\n\n\"\n\"a\"\"\"\"b\"\n", "h$\n\n$a\"\"b$");
+        test_views_string("a,b\n,\n\"long quoted field, with a comma and an \"\"escaped\"\" quote\",x\n",
+                          "a|b$|$long quoted field, with a comma and an \"escaped\" quote|x$");
+}
 
-        csv_reader_parse(reader, csv);
+int main()
+{
+        test_views();
+        test_allocator();
+        test_iterator();
+        test_index();
+        test_writer();
+        test_dictionary();
+        test_number();
+        test_count();
+        test_control();
+        test_cache();
+        test_batch();
+        test_columns();
+        test_stats();
+        test_schema();
 
-        fclose(csv);
-        csv_reader_free(reader);
-}
\ No newline at end of file
+        if (testFailures > 0) {
+                fprintf(stderr, "%d assertions failed\n", testFailures);
+                return 1;
+        }
+        printf("All tests passed\n");
+        return 0;
+}
@@ -0,0 +1,152 @@
+//
+// Created by Davide on 17/10/2026.
+//
+
+#ifndef C_CSV_TEST_H
+#define C_CSV_TEST_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "csv.h"
+
+/**
+ * Number of failed assertions
+ */
+extern int testFailures;
+
+/**
+ * Count and report a failed assertion, without stopping the test
+ */
+#define TEST_ASSERT(condition) do { \
+        if (!(condition)) { \
+                fprintf(stderr, "%s:%d: assertion failed: %s\n", __FILE__, __LINE__, #condition); \
+                testFailures++; \
+        } \
+} while (0)
+
+/**
+ * The sizes of the blocks streams are read in, 0 for the default size
+ */
+#define TEST_BLOCK_SIZES 6
+extern const size_t testBlockSizes[TEST_BLOCK_SIZES];
+
+/**
+ * The records received by a reader, with the fields of each record
+ * separated by TEST_FIELD_END and the records by TEST_RECORD_END, so that
+ * the output of two readers can be compared with a single memcmp
+ */
+typedef struct TestRecords_s {
+        char *data;
+        size_t length;
+        size_t capacity;
+        size_t records;
+} TestRecords;
+
+#define TEST_FIELD_END '\x1f'
+#define TEST_RECORD_END '\x1e'
+
+/**
+ * Append a field to the current record
+ * @param records the collected records
+ * @param field the field
+ * @param len length of the field
+ */
+void test_records_append_field(TestRecords *records, const char *field, size_t len);
+
+/**
+ * End the current record
+ * @param records the collected records
+ */
+void test_records_end(TestRecords *records);
+
+/**
+ * Append a record view to the collected records
+ * @param records the collected records
+ * @param record the record
+ */
+void test_records_append_view(TestRecords *records, const RecordView *record);
+
+/**
+ * Append a record to the collected records
+ * @param records the collected records
+ * @param record the record
+ */
+void test_records_append(TestRecords *records, const Record *record);
+
+/**
+ * Check that two collections hold the same records
+ * @return 1 if they are equal, 0 otherwise
+ */
+int test_records_equal(const TestRecords *a, const TestRecords *b);
+
+/**
+ * Free the collected records and empty the collection
+ */
+void test_records_free(TestRecords *records);
+
+/**
+ * Seed the generator of test_random, so that each test generates the same
+ * data whatever the tests run before it
+ */
+void test_random_seed(uint64_t seed);
+
+/**
+ * Generate a pseudo random number with a linear congruential generator
+ * @param bound the upper bound, greater than 0
+ * @return a number from 0 to bound - 1
+ */
+unsigned test_random(unsigned bound);
+
+/**
+ * View callbacks appending the header and the records to the TestRecords
+ * passed as context
+ */
+void test_header_view(void *context, RecordView *header);
+void test_record_view(void *context, RecordView *header, RecordView *record);
+
+/**
+ * Record callbacks appending the header and the records to the TestRecords
+ * passed as context
+ */
+void test_header(void *context, Record *header);
+void test_record(void *context, Record *header, Record *record);
+
+/**
+ * Read a whole file in memory
+ * @param path the path of the file
+ * @param len output, the length of the file
+ * @return the content of the file, to be freed, or NULL on error
+ */
+char *test_read_file(const char *path, size_t *len);
+
+/**
+ * Write a file
+ * @return 0 on success, -1 on error
+ */
+int test_write_file(const char *path, const char *data, size_t len);
+
+/**
+ * Set LC_NUMERIC to a locale whose decimal point is a comma, if one is
+ * installed. It is restored with setlocale(LC_NUMERIC, "C")
+ * @return 1 on success, 0 if no such locale is installed
+ */
+int test_comma_locale(void);
+
+void test_views(void);
+void test_allocator(void);
+void test_iterator(void);
+void test_index(void);
+void test_writer(void);
+void test_dictionary(void);
+void test_number(void);
+void test_count(void);
+void test_control(void);
+void test_cache(void);
+void test_batch(void);
+void test_columns(void);
+void test_stats(void);
+void test_schema(void);
+
+#endif //C_CSV_TEST_H
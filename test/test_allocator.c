@@ -0,0 +1,69 @@
+//
+// Created by Davide on 17/10/2026.
+//
+
+#include <string.h>
+
+#include "test.h"
+
+/**
+ * An allocator counting the allocations, and the allocations seen by the
+ * record callback
+ */
+typedef struct CountingAllocator_s {
+        size_t allocations;
+        size_t releases;
+        size_t records;
+        size_t steadyAllocations;
+} CountingAllocator;
+
+static void *counting_alloc(void *context, size_t size)
+{
+        ((CountingAllocator *) context)->allocations++;
+        return malloc(size);
+}
+
+static void counting_free(void *context, void *ptr)
+{
+        ((CountingAllocator *) context)->releases++;
+        free(ptr);
+}
+
+static void counting_record(void *context, Record *header, Record *record)
+{
+        CountingAllocator *counter = context;
+        // The first records are the warm up: the largest one is the second
+        if (++counter->records == 4)
+                counter->steadyAllocations = counter->allocations;
+}
+
+void test_allocator(void)
+{
+        CountingAllocator counter = {0};
+        CsvReader *reader = csv_reader_alloc(NULL, &counting_record, &counter);
+        size_t i, j, len = 0;
+        char *csv = malloc(1 << 20);
+
+        // Records alternating between a few short fields and many long ones,
+        // each of them filling several chunks of the record arena
+        len += sprintf(csv, "a,b\n");
+        for (i = 0; i < 200; i++) {
+                if (i % 2 == 0) {
+                        len += sprintf(csv + len, "1,2\n");
+                        continue;
+                }
+                for (j = 0; j < 300; j++)
+                        len += sprintf(csv + len, "%s%012lu", j > 0 ? "," : "", j);
+                csv[len++] = '\n';
+        }
+
+        csv_reader_set_allocator(reader, &counting_alloc, &counting_free, &counter);
+        TEST_ASSERT(csv_reader_parse_memory(reader, csv, len) == 0);
+        TEST_ASSERT(counter.records == 200);
+        // Resetting the record keeps its chunks: once they have been
+        // allocated, the records do not allocate any more
+        TEST_ASSERT(counter.allocations == counter.steadyAllocations);
+        csv_reader_free(reader);
+        TEST_ASSERT(counter.allocations == counter.releases);
+        free(csv);
+}
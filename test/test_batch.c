@@ -0,0 +1,163 @@
+//
+// Created by Davide on 17/10/2026.
+//
+
+#include <string.h>
+
+#include "test.h"
+#include "batch.h"
+
+#define BATCH_DEFAULT_SIZE 1024
+
+static const size_t batchSizes[] = {1, 2, 0};
+static const size_t parallelBatchSizes[] = {3, 7, 1000};
+
+/**
+ * The records delivered in row major batches
+ */
+typedef struct BatchContext_s {
+        TestRecords records;
+        size_t capacity;
+        size_t batches;
+        size_t partial;
+        const RecordBatch *batch;
+        int ordered;
+} BatchContext;
+
+static void batch_record(void *context, RecordView *header, RecordBatch *batch)
+{
+        BatchContext *delivered = context;
+        RecordView record;
+        const char *data = batch->data->buffer;
+        size_t i, j;
+
+        if (delivered->batches == 0)
+                test_records_append_view(&delivered->records, header);
+        delivered->batches += 1;
+
+        TEST_ASSERT(batch->length > 0 && batch->length <= delivered->capacity);
+        if (batch->length < delivered->capacity)
+                delivered->partial += 1;
+
+        // A sequential parsing reuses the same batch
+        if (!delivered->ordered && delivered->batch != NULL)
+                TEST_ASSERT(batch == delivered->batch);
+        delivered->batch = batch;
+
+        for (i = 0; i < batch->length; i++) {
+                record_batch_get(batch, i, &record);
+                // The fields are copied in the data block of the batch
+                for (j = 0; j < record.arraySize; j++) {
+                        TEST_ASSERT(record.fields[j].length == 0 || (record.fields[j].data >= data &&
+                                    record.fields[j].data + record.fields[j].length <= data + batch->data->stringLength));
+                }
+                test_records_append_view(&delivered->records, &record);
+        }
+}
+
+/**
+ * Parse a csv stored in memory with views, then deliver its records in
+ * batches from streams read in blocks of every size in testBlockSizes and
+ * from memory: the records must be the same
+ */
+static void batch_check(const char *csv, size_t len)
+{
+        TestRecords expected = {0};
+        CsvReader *reader = csv_reader_alloc_view(&test_header_view, &test_record_view, &expected);
+        size_t i, j, records;
+
+        TEST_ASSERT(csv_reader_parse_memory(reader, csv, len) == CSV_END);
+        csv_reader_free(reader);
+        records = expected.records > 0 ? expected.records - 1 : 0;
+
+        for (i = 0; i < sizeof(batchSizes) / sizeof(batchSizes[0]); i++) {
+                for (j = 0; j <= TEST_BLOCK_SIZES; j++) {
+                        BatchContext delivered = {0};
+                        FILE *stream = fmemopen((void *) csv, len, "r");
+
+                        delivered.capacity = batchSizes[i] > 0 ? batchSizes[i] : BATCH_DEFAULT_SIZE;
+                        reader = csv_reader_alloc_view(NULL, NULL, &delivered);
+                        csv_reader_set_record_batch(reader, &batch_record, batchSizes[i]);
+
+                        // The last round parses from memory
+                        if (j < TEST_BLOCK_SIZES) {
+                                csv_reader_set_block_size(reader, testBlockSizes[j]);
+                                TEST_ASSERT(csv_reader_parse(reader, stream) == CSV_END);
+                        } else {
+                                TEST_ASSERT(csv_reader_parse_memory(reader, csv, len) == CSV_END);
+                        }
+                        fclose(stream);
+                        csv_reader_free(reader);
+
+                        // Only the last batch may be partial
+                        TEST_ASSERT(delivered.batches == (records + delivered.capacity - 1) / delivered.capacity);
+                        TEST_ASSERT(delivered.partial == (records % delivered.capacity != 0));
+                        if (records > 0 && !test_records_equal(&delivered.records, &expected)) {
+                                fprintf(stderr, "batches of %zu records with blocks of %zu bytes differ\n",
+                                        batchSizes[i], j < TEST_BLOCK_SIZES ? testBlockSizes[j] : 0);
+                                testFailures++;
+                        }
+                        test_records_free(&delivered.records);
+                }
+        }
+
+        test_records_free(&expected);
+}
+
+/**
+ * Parse in parallel, in order: each worker flushes its batch at the end of
+ * its chunk, so batches may be partial, but the records keep their order
+ */
+static void batch_check_parallel(const char *csv, size_t len)
+{
+        TestRecords expected = {0};
+        CsvReader *reader = csv_reader_alloc_view(&test_header_view, &test_record_view, &expected);
+        size_t i;
+
+        TEST_ASSERT(csv_reader_parse_memory(reader, csv, len) == CSV_END);
+        csv_reader_free(reader);
+
+        for (i = 0; i < sizeof(parallelBatchSizes) / sizeof(parallelBatchSizes[0]); i++) {
+                BatchContext delivered = {0};
+
+                delivered.capacity = parallelBatchSizes[i];
+                delivered.ordered = 1;
+                reader = csv_reader_alloc_view(NULL, NULL, &delivered);
+                csv_reader_set_record_batch(reader, &batch_record, parallelBatchSizes[i]);
+                csv_reader_parse_memory_parallel(reader, csv, len, 4, 1);
+                csv_reader_free(reader);
+
+                TEST_ASSERT(delivered.batches >= (expected.records - 1 + delivered.capacity - 1) / delivered.capacity);
+                TEST_ASSERT(test_records_equal(&delivered.records, &expected));
+                test_records_free(&delivered.records);
+        }
+
+        test_records_free(&expected);
+}
+
+void test_batch(void)
+{
+        static const char *strings[] = {"a,b,c\n\"x\",\"\",\"\"\"\"\n", "a,b\r\n\"1\"\"2\",\"3\r\n4\"\r\n5,6",
+                                        "h\n\"\n\n\"\n\"a\"\"\"\"b\"\n", "a,b\n,\n\"quoted, \"\"escaped\"\"\",x\ny,z\n",
+                                        "h\n1\n2\n3\n4\n5\n"};
+        size_t i, len;
+        char *data;
+
+        for (i = 0; i < sizeof(strings) / sizeof(strings[0]); i++)
+                batch_check(strings[i], strlen(strings[i]));
+
+        data = test_read_file("../test/test.csv", &len);
+        TEST_ASSERT(data != NULL);
+        if (data != NULL)
+                batch_check(data, len);
+        free(data);
+
+        // 8614 records, which the sizes of the batches do not divide
+        data = test_read_file("../test/test2.csv", &len);
+        TEST_ASSERT(data != NULL);
+        if (data != NULL) {
+                batch_check(data, len);
+                batch_check_parallel(data, len);
+        }
+        free(data);
+}
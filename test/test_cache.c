@@ -0,0 +1,299 @@
+//
+// Created by Davide on 17/10/2026.
+//
+
+#include <fcntl.h>
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "test.h"
+#include "cache.h"
+#include "utils.h"
+
+#define CACHE_PATH "c-csv-test-cache.csv"
+#define CACHE_FILE CACHE_PATH CSV_CACHE_SUFFIX
+#define CACHE_RECORDS 5000
+
+#define CONFIG_ALL 0
+#define CONFIG_SELECTION 1
+#define CONFIG_PREDICATES 2
+#define CONFIG_SEEK 3
+#define CONFIG_INDEX 4
+#define CONFIGS 5
+
+/**
+ * Generate a csv file whose columns are integers, numbers with empty
+ * fields, and quoted strings with escaped quotes and line endings. A few
+ * records are shorter or longer than the header. It is larger than the
+ * blocks hashed to identify the file
+ * @return the content of the file, to be freed
+ */
+static char *cache_generate(size_t *len)
+{
+        char *csv = malloc(80 * CACHE_RECORDS + 64);
+        size_t i, length = (size_t) sprintf(csv, "id,price,name,\"note\"\r\n");
+
+        for (i = 0; i < CACHE_RECORDS; i++) {
+                if (i % 1000 == 999) {
+                        length += (size_t) sprintf(csv + length, "%zu,1.5\n", i);
+                        continue;
+                }
+                length += (size_t) sprintf(csv + length, "%zu,%s%zu.%02zu,name %zu,\"a \"\"%zu\"\"\r\nb\"%s\n", i,
+                                           i % 7 == 0 ? "-" : "", i % 1000, i % 100, i % 37, i,
+                                           i % 500 == 3 ? ",extra" : "");
+                if (i % 11 == 0)
+                        length += (size_t) sprintf(csv + length, "%zu,,,\n", i);
+        }
+        *len = length;
+        return csv;
+}
+
+/**
+ * Format the rows of a batch as records, with the converted values
+ */
+static void cache_batch(void *context, RecordView *header, Batch *batch)
+{
+        TestRecords *records = context;
+        const Column *column;
+        char value[64];
+        size_t row, i;
+        int length;
+
+        for (row = 0; row < batch->length; row++) {
+                for (i = 0; i < batch->columnCount; i++) {
+                        column = &batch->columns[i];
+                        if (!(column->validity[row / 8] >> (row % 8) & 1)) {
+                                test_records_append_field(records, "null", 4);
+                                continue;
+                        }
+                        switch (column->type) {
+                        case STRING_TYPE_INT:
+                                length = snprintf(value, sizeof value, "%lld", (long long) column->ints[row]);
+                                test_records_append_field(records, value, (size_t) length);
+                                break;
+                        case STRING_TYPE_FLOAT:
+                                length = snprintf(value, sizeof value, "%.17g", column->floats[row]);
+                                test_records_append_field(records, value, (size_t) length);
+                                break;
+                        default:
+                                test_records_append_field(records, column->data->buffer + column->offsets[row],
+                                                          column->offsets[row + 1] - column->offsets[row]);
+                                break;
+                        }
+                }
+                test_records_end(records);
+        }
+}
+
+/**
+ * Configure a reader for one of the ways of reading the file
+ */
+static void cache_configure(CsvReader *reader, int config, const RecordIndex *index)
+{
+        switch (config) {
+        case CONFIG_SELECTION:
+                TEST_ASSERT(csv_reader_select_column(reader, "name") == 0);
+                TEST_ASSERT(csv_reader_select_index(reader, 0) == 0);
+                TEST_ASSERT(csv_reader_select_column(reader, "missing") == 0);
+                TEST_ASSERT(csv_reader_select_index(reader, 4) == 0);
+                break;
+        case CONFIG_PREDICATES:
+                TEST_ASSERT(csv_reader_filter_equals(reader, "name", "name 5") == 0);
+                TEST_ASSERT(csv_reader_filter_range(reader, "price", -100, 500) == 0);
+                TEST_ASSERT(csv_reader_select_column(reader, "note") == 0);
+                TEST_ASSERT(csv_reader_select_column(reader, "price") == 0);
+                break;
+        case CONFIG_SEEK:
+                TEST_ASSERT(csv_reader_seek_record(reader, 3777) == 0);
+                break;
+        case CONFIG_INDEX:
+                csv_reader_set_index(reader, index);
+                TEST_ASSERT(csv_reader_seek_record(reader, 4001) == 0);
+                break;
+        default:
+                break;
+        }
+}
+
+/**
+ * Read the file with views, records and typed batches, and with an
+ * iterator, from its cache or not
+ */
+static void cache_read(int cached, int config, const Schema *schema, const RecordIndex *index, TestRecords *views,
+                       TestRecords *records, TestRecords *batches, TestRecords *iterated)
+{
+        CsvReader *reader = csv_reader_alloc_view(&test_header_view, &test_record_view, views);
+        CsvReader *recordReader = csv_reader_alloc(&test_header, &test_record, records);
+        CsvReader *batchReader = csv_reader_alloc_view(NULL, NULL, batches);
+        CsvIterator *iterator;
+        RecordView *record;
+
+        csv_reader_set_cache(reader, cached);
+        csv_reader_set_cache(recordReader, cached);
+        csv_reader_set_cache(batchReader, cached);
+        cache_configure(reader, config, index);
+        cache_configure(recordReader, config, index);
+        cache_configure(batchReader, config, index);
+        // The schema describes all the columns of the file
+        csv_reader_set_batch(batchReader, &cache_batch,
+                             config == CONFIG_SELECTION || config == CONFIG_PREDICATES ? NULL : schema, 100);
+
+        TEST_ASSERT(csv_reader_parse_path(reader, CACHE_PATH) == CSV_END);
+        TEST_ASSERT(csv_reader_parse_path(recordReader, CACHE_PATH) == CSV_END);
+        TEST_ASSERT(csv_reader_parse_path(batchReader, CACHE_PATH) == CSV_END);
+
+        iterator = csv_iterator_open_path(reader, CACHE_PATH);
+        TEST_ASSERT(iterator != NULL);
+        if (iterator != NULL) {
+                test_records_append_view(iterated, csv_iterator_header(iterator));
+                while (csv_iterator_next(iterator, NULL, &record))
+                        test_records_append_view(iterated, record);
+                csv_iterator_close(iterator);
+        }
+
+        csv_reader_free(reader);
+        csv_reader_free(recordReader);
+        csv_reader_free(batchReader);
+}
+
+/**
+ * Read the file from its cache and by parsing it, in every way and with
+ * every configuration, and check that the records are the same
+ * @return 1 if they are the same, 0 otherwise
+ */
+static int cache_check(const Schema *schema, const RecordIndex *index)
+{
+        CsvReader *reader = csv_reader_alloc_view(NULL, NULL, NULL);
+        size_t parsedCount = 0, cachedCount = 0;
+        int config, equal = 1;
+
+        for (config = 0; config < CONFIGS; config++) {
+                TestRecords parsed[4] = {{0}}, cached[4] = {{0}};
+                size_t i;
+
+                cache_read(0, config, schema, index, &parsed[0], &parsed[1], &parsed[2], &parsed[3]);
+                cache_read(1, config, schema, index, &cached[0], &cached[1], &cached[2], &cached[3]);
+                for (i = 0; i < 4; i++) {
+                        if (parsed[i].records == 0 || !test_records_equal(&parsed[i], &cached[i])) {
+                                fprintf(stderr, "cached records of reader %zu with configuration %d differ\n", i,
+                                        config);
+                                equal = 0;
+                        }
+                        test_records_free(&parsed[i]);
+                        test_records_free(&cached[i]);
+                }
+        }
+
+        TEST_ASSERT(csv_count_records(reader, CACHE_PATH, &parsedCount) == 0);
+        csv_reader_set_cache(reader, 1);
+        TEST_ASSERT(csv_count_records(reader, CACHE_PATH, &cachedCount) == 0);
+        if (parsedCount != cachedCount)
+                equal = 0;
+        csv_reader_free(reader);
+        return equal;
+}
+
+/**
+ * Corrupt the cache file, then check that it is rejected: the file is
+ * parsed, and its cache is written again
+ * @param field the offset of the 64 bit field of the header locating the
+ *              section to corrupt, or of the header field itself if
+ *              element is negative
+ * @param element the 64 bit element of the section to corrupt
+ * @param value the value written
+ */
+static void cache_corrupt(const Schema *schema, const RecordIndex *index, size_t field, long element,
+                          uint64_t value)
+{
+        size_t len, position;
+        char *data = test_read_file(CACHE_FILE, &len);
+        uint64_t offset;
+
+        TEST_ASSERT(data != NULL && len > sizeof(CacheHeader));
+        if (data == NULL)
+                return;
+
+        memcpy(&offset, data + field, sizeof offset);
+        position = element < 0 ? field : (size_t) offset + (size_t) element * sizeof(uint64_t);
+        TEST_ASSERT(position + sizeof value <= len);
+        if (position + sizeof value <= len) {
+                memcpy(data + position, &value, sizeof value);
+                TEST_ASSERT(test_write_file(CACHE_FILE, data, len) == 0);
+                TEST_ASSERT(cache_check(schema, index));
+        }
+        free(data);
+
+        // The cache has been written again
+        data = test_read_file(CACHE_FILE, &position);
+        TEST_ASSERT(data != NULL && position == len);
+        free(data);
+}
+
+void test_cache(void)
+{
+        CsvReader *reader = csv_reader_alloc_view(NULL, NULL, NULL);
+        size_t len, cacheLength;
+        char *csv = cache_generate(&len);
+        char *cache;
+        Schema *schema;
+        RecordIndex *index;
+        struct stat info;
+        struct timespec times[2];
+        const size_t ends = offsetof(CacheHeader, endsOffset);
+        const size_t entries = offsetof(CacheHeader, entriesOffset);
+
+        remove(CACHE_FILE);
+        TEST_ASSERT(test_write_file(CACHE_PATH, csv, len) == 0);
+        schema = csv_reader_infer_schema(reader, CACHE_PATH, 0, 1);
+        index = csv_index_build(reader, CACHE_PATH, 1000);
+        TEST_ASSERT(schema != NULL && index != NULL);
+
+        // The first reading writes the cache, the next ones map it
+        TEST_ASSERT(cache_check(schema, index));
+        TEST_ASSERT(access(CACHE_FILE, R_OK) == 0);
+        TEST_ASSERT(cache_check(schema, index));
+
+        // The source changes in the middle, where it is not hashed, keeping
+        // its size and the second of its modification time
+        TEST_ASSERT(stat(CACHE_PATH, &info) == 0);
+        csv[len / 2] = csv[len / 2] == '9' ? '8' : '9';
+        TEST_ASSERT(test_write_file(CACHE_PATH, csv, len) == 0);
+        times[0].tv_sec = info.st_atime;
+        times[0].tv_nsec = 0;
+        times[1].tv_sec = info.st_mtime;
+        times[1].tv_nsec = 123456789;
+        TEST_ASSERT(utimensat(AT_FDCWD, CACHE_PATH, times, 0) == 0);
+        TEST_ASSERT(cache_check(schema, index));
+
+        // Replaced by another file with the same content
+        TEST_ASSERT(test_write_file(CACHE_PATH ".new", csv, len) == 0);
+        TEST_ASSERT(rename(CACHE_PATH ".new", CACHE_PATH) == 0);
+        TEST_ASSERT(cache_check(schema, index));
+
+        // Corrupted sidecars are rejected
+        cache_corrupt(schema, index, offsetof(CacheHeader, records), -1, CACHE_RECORDS * 1000);
+        cache_corrupt(schema, index, offsetof(CacheHeader, textLength), -1, 12345);
+        cache_corrupt(schema, index, offsetof(CacheHeader, endsOffset), -1, 1);
+        cache_corrupt(schema, index, ends, 7, 0xffffffffffffffffULL);
+        cache_corrupt(schema, index, ends, CACHE_RECORDS, 0xffff0000ffff0000ULL);
+        // Entries hold a field, a text offset and a file offset
+        cache_corrupt(schema, index, entries, 3 * 100 + 1, 1);
+        cache_corrupt(schema, index, entries, 3 * 100, 1ULL << 40);
+        cache_corrupt(schema, index, entries, 3 * 2000 + 2, 0);
+        cache_corrupt(schema, index, entries, 3 * 2000 + 1, 1ULL << 40);
+
+        // A truncated sidecar
+        cache = test_read_file(CACHE_FILE, &cacheLength);
+        TEST_ASSERT(cache != NULL && test_write_file(CACHE_FILE, cache, cacheLength / 2) == 0);
+        TEST_ASSERT(cache_check(schema, index));
+        free(cache);
+
+        remove(CACHE_PATH);
+        remove(CACHE_FILE);
+        schema_free(schema);
+        csv_index_free(index);
+        csv_reader_free(reader);
+        free(csv);
+}
@@ -0,0 +1,199 @@
+//
+// Created by Davide on 17/10/2026.
+//
+
+#include <string.h>
+
+#include "test.h"
+#include "columns.h"
+
+#define COLUMNS_WIDE 3000
+
+static const char columnsCsv[] = "id,name,id,value\n1,x,2,3\n4,y\n5,z,6,7,8\n";
+static const char *columnsIds[] = {"1", "4", "5"};
+static const char *columnsValues[] = {"3", NULL, "7"};
+// The selected columns are always delivered, empty if they are missing
+static const char *columnsProjected[] = {"3", "", "7"};
+
+typedef struct ColumnsContext_s {
+        size_t headers;
+        size_t records;
+        int projected;
+} ColumnsContext;
+
+static int columns_field_equals(const FieldView *field, const char *expected)
+{
+        if (field == NULL || expected == NULL)
+                return field == NULL && expected == NULL;
+        return field->length == strlen(expected) && memcmp(field->data, expected, field->length) == 0;
+}
+
+static int columns_string_equals(const char *field, const char *expected)
+{
+        if (field == NULL || expected == NULL)
+                return field == NULL && expected == NULL;
+        return strcmp(field, expected) == 0;
+}
+
+static void columns_header_view(void *context, RecordView *header)
+{
+        ColumnsContext *columns = context;
+
+        columns->headers++;
+        if (columns->projected) {
+                // The indexes are those of the selected columns
+                TEST_ASSERT(csv_record_view_column(header, "value") == 0);
+                TEST_ASSERT(csv_record_view_column(header, "id") == 1);
+                TEST_ASSERT(csv_record_view_column(header, "missing") == 2);
+                TEST_ASSERT(csv_record_view_column(header, "name") == CSV_NO_COLUMN);
+                return;
+        }
+
+        // The first of the duplicated names is found
+        TEST_ASSERT(csv_record_view_column(header, "id") == 0);
+        TEST_ASSERT(csv_record_view_column(header, "name") == 1);
+        TEST_ASSERT(csv_record_view_column(header, "value") == 3);
+        TEST_ASSERT(csv_record_view_column(header, "missing") == CSV_NO_COLUMN);
+        TEST_ASSERT(csv_record_view_column(header, "") == CSV_NO_COLUMN);
+        TEST_ASSERT(csv_record_view_get(header, "value") == &header->fields[3]);
+}
+
+static void columns_record_view(void *context, RecordView *header, RecordView *record)
+{
+        ColumnsContext *columns = context;
+        size_t i = columns->records++;
+
+        TEST_ASSERT(i < 3);
+        if (i >= 3)
+                return;
+
+        TEST_ASSERT(columns_field_equals(csv_record_view_get(record, "id"), columnsIds[i]));
+        TEST_ASSERT(csv_record_view_field(record, CSV_NO_COLUMN) == NULL);
+        if (columns->projected) {
+                TEST_ASSERT(columns_field_equals(csv_record_view_get(record, "value"), columnsProjected[i]));
+                TEST_ASSERT(columns_field_equals(csv_record_view_get(record, "missing"), ""));
+                TEST_ASSERT(csv_record_view_get(record, "value") == csv_record_view_field(record, 0));
+                TEST_ASSERT(csv_record_view_get(record, "name") == NULL);
+                return;
+        }
+
+        // The second record is shorter than the header
+        TEST_ASSERT(columns_field_equals(csv_record_view_get(record, "value"), columnsValues[i]));
+        TEST_ASSERT(csv_record_view_get(record, "missing") == NULL);
+        TEST_ASSERT(csv_record_view_get(record, "name") == &record->fields[1]);
+}
+
+static void columns_header(void *context, Record *header)
+{
+        int projected = ((ColumnsContext *) context)->projected;
+
+        TEST_ASSERT(csv_record_column(header, "id") == (projected ? 1 : 0));
+        TEST_ASSERT(columns_string_equals(csv_record_get(header, "value"), "value"));
+        TEST_ASSERT(columns_string_equals(csv_record_get(header, "missing"), projected ? "missing" : NULL));
+}
+
+static void columns_record(void *context, Record *header, Record *record)
+{
+        // The view callback has already counted the record
+        ColumnsContext *columns = context;
+        size_t i = columns->records - 1;
+        size_t column = csv_record_column(header, "value");
+
+        if (i >= 3)
+                return;
+        TEST_ASSERT(columns_string_equals(csv_record_get(record, "id"), columnsIds[i]));
+        TEST_ASSERT(csv_record_field(record, CSV_NO_COLUMN) == NULL);
+        if (columns->projected) {
+                TEST_ASSERT(column == 0 && csv_record_get(record, "name") == NULL);
+                TEST_ASSERT(columns_string_equals(csv_record_field(record, column), columnsProjected[i]));
+                TEST_ASSERT(columns_string_equals(csv_record_get(record, "missing"), ""));
+                return;
+        }
+        TEST_ASSERT(columns_string_equals(csv_record_field(record, column), columnsValues[i]));
+        TEST_ASSERT(csv_record_get(record, "missing") == NULL);
+}
+
+/**
+ * Look the columns up in the header and in the records delivered by a
+ * reader, as records and as views, with all the columns and with some of
+ * them selected
+ */
+static void columns_reader(int projected)
+{
+        ColumnsContext columns = {0};
+        CsvReader *reader = csv_reader_alloc_view(&columns_header_view, &columns_record_view, &columns);
+
+        reader->header = &columns_header;
+        reader->record = &columns_record;
+        columns.projected = projected;
+        if (projected) {
+                TEST_ASSERT(csv_reader_select_column(reader, "value") == 0);
+                TEST_ASSERT(csv_reader_select_column(reader, "id") == 0);
+                TEST_ASSERT(csv_reader_select_column(reader, "missing") == 0);
+        }
+
+        TEST_ASSERT(csv_reader_parse_memory(reader, columnsCsv, sizeof columnsCsv - 1) == CSV_END);
+        TEST_ASSERT(columns.headers == 1 && columns.records == 3);
+        csv_reader_free(reader);
+}
+
+/**
+ * Build the table of a header directly: a small one is perfect, a wide
+ * one is not, then the names are found by linear probing
+ */
+static void columns_map(void)
+{
+        RecordView *header = record_view_alloc(COLUMNS_WIDE);
+        char *names = malloc(16 * COLUMNS_WIDE);
+        ColumnMap *map;
+        size_t i, len;
+
+        record_view_append(header, "a", 1);
+        record_view_append(header, "b", 1);
+        record_view_append(header, "a", 1);
+        map = column_map_build(header, NULL);
+        TEST_ASSERT(map != NULL && map->perfect);
+        TEST_ASSERT(column_map_find(map, "a", 1) == 0);
+        TEST_ASSERT(column_map_find(map, "b", 1) == 1);
+        // The name may not be null terminated
+        TEST_ASSERT(column_map_find(map, "bc", 1) == 1);
+        TEST_ASSERT(column_map_find(map, "c", 1) == CSV_NO_COLUMN);
+        TEST_ASSERT(column_map_find(map, "ab", 2) == CSV_NO_COLUMN);
+        column_map_free(map);
+
+        // The last names repeat the first ones
+        header->arraySize = 0;
+        for (i = 0, len = 0; i < COLUMNS_WIDE; i++) {
+                size_t length = (size_t) sprintf(names + len, "column %zu", i % (COLUMNS_WIDE - 100));
+                record_view_append(header, names + len, length);
+                len += length;
+        }
+        map = column_map_build(header, NULL);
+        // No seed makes the table perfect, the first one is used
+        TEST_ASSERT(map != NULL && !map->perfect && map->seed == 0);
+        for (i = 0; i < COLUMNS_WIDE; i++) {
+                const FieldView *field = &header->fields[i];
+                TEST_ASSERT(column_map_find(map, field->data, field->length) == i % (COLUMNS_WIDE - 100));
+        }
+        TEST_ASSERT(column_map_find(map, "column", 6) == CSV_NO_COLUMN);
+        TEST_ASSERT(column_map_find(map, "column 3000", 11) == CSV_NO_COLUMN);
+        column_map_free(map);
+
+        record_view_free(header);
+        free(names);
+}
+
+void test_columns(void)
+{
+        Record record = {0};
+        RecordView view = {0};
+
+        // Records which have not been delivered by a reader have no header
+        TEST_ASSERT(csv_record_column(&record, "id") == CSV_NO_COLUMN);
+        TEST_ASSERT(csv_record_get(&record, "id") == NULL);
+        TEST_ASSERT(csv_record_view_get(&view, "id") == NULL);
+
+        columns_reader(0);
+        columns_reader(1);
+        columns_map();
+}
@@ -0,0 +1,265 @@
+//
+// Created by Davide on 17/10/2026.
+//
+
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+
+#include "test.h"
+
+#define CONTROL_RECORDS 20000
+
+typedef struct ControlContext_s {
+        CsvReader *reader;
+        TestRecords views;
+        TestRecords records;
+        size_t seen;
+        size_t pauseEvery;
+} ControlContext;
+
+static void control_header_view(void *context, RecordView *header)
+{
+        ControlContext *control = context;
+        test_records_append_view(&control->views, header);
+        // The header cannot be skipped
+        csv_reader_skip_record(control->reader);
+}
+
+static void control_header(void *context, Record *header)
+{
+        test_records_append(&((ControlContext *) context)->records, header);
+}
+
+static void control_record_view(void *context, RecordView *header, RecordView *record)
+{
+        ControlContext *control = context;
+        if (control->seen++ % 2 == 1)
+                csv_reader_skip_record(control->reader);
+        else
+                test_records_append_view(&control->views, record);
+}
+
+static void control_record(void *context, Record *header, Record *record)
+{
+        test_records_append(&((ControlContext *) context)->records, record);
+}
+
+static pthread_mutex_t controlLock = PTHREAD_MUTEX_INITIALIZER;
+
+static void control_pause_header(void *context, RecordView *header)
+{
+        test_records_append_view(&((ControlContext *) context)->views, header);
+}
+
+static void control_pause_view(void *context, RecordView *header, RecordView *record)
+{
+        ControlContext *control = context;
+        test_records_append_view(&control->views, record);
+        if (control->pauseEvery > 0 && ++control->seen % control->pauseEvery == 0)
+                csv_reader_pause(control->reader);
+}
+
+static void control_pause_record(void *context, Record *header, Record *record)
+{
+        ControlContext *control = context;
+        test_records_append(&control->records, record);
+        if (control->pauseEvery > 0 && ++control->seen % control->pauseEvery == 0)
+                csv_reader_pause(control->reader);
+}
+
+/**
+ * Out of order the records are delivered by several threads at once
+ */
+static void control_record_locked(void *context, RecordView *header, RecordView *record)
+{
+        pthread_mutex_lock(&controlLock);
+        test_records_append_view(context, record);
+        pthread_mutex_unlock(&controlLock);
+}
+
+/**
+ * Generate a csv file with a header and the given number of records
+ * @return the length of the file
+ */
+static size_t control_generate(char *csv, size_t records)
+{
+        size_t len = (size_t) sprintf(csv, "id,name,\"quoted\"\n");
+        size_t i;
+
+        for (i = 0; i < records; i++)
+                len += (size_t) sprintf(csv + len, "%zu,name %zu,\"a,\"\"%zu\"\"\nb\"\n", i, i % 97, i);
+        return len;
+}
+
+/**
+ * Skip every other record from the view callback: the record callback
+ * receives only the records which were not skipped
+ */
+static void control_skip(const char *csv, size_t len)
+{
+        ControlContext control = {0};
+
+        // Both kinds of callbacks, the view ones are invoked first
+        control.reader = csv_reader_alloc_view(&control_header_view, &control_record_view, &control);
+        control.reader->header = &control_header;
+        control.reader->record = &control_record;
+        TEST_ASSERT(csv_reader_parse_memory(control.reader, csv, len) == CSV_END);
+        TEST_ASSERT(control.views.records == 1 + CONTROL_RECORDS / 2);
+        TEST_ASSERT(test_records_equal(&control.views, &control.records));
+
+        test_records_free(&control.views);
+        test_records_free(&control.records);
+        csv_reader_free(control.reader);
+}
+
+/**
+ * Parse in parallel, the records in order and out of order, and compare
+ * them with a sequential parsing
+ */
+static void control_parallel(const char *csv, size_t len)
+{
+        TestRecords sequential = {0}, ordered = {0}, unordered = {0};
+        CsvReader *reader = csv_reader_alloc_view(&test_header_view, &test_record_view, &sequential);
+
+        TEST_ASSERT(csv_reader_parse_memory(reader, csv, len) == CSV_END);
+        csv_reader_free(reader);
+
+        reader = csv_reader_alloc_view(&test_header_view, &test_record_view, &ordered);
+        csv_reader_parse_memory_parallel(reader, csv, len, 4, 1);
+        csv_reader_free(reader);
+        TEST_ASSERT(test_records_equal(&sequential, &ordered));
+
+        reader = csv_reader_alloc_view(&test_header_view, &control_record_locked, &unordered);
+        csv_reader_parse_memory_parallel(reader, csv, len, 4, 0);
+        csv_reader_free(reader);
+        TEST_ASSERT(unordered.records == sequential.records && unordered.length == sequential.length);
+
+        test_records_free(&sequential);
+        test_records_free(&ordered);
+        test_records_free(&unordered);
+}
+
+/**
+ * The predicates cannot be changed while a parsing is paused or input is
+ * being fed, the filters of the parsing point to them
+ */
+static void control_pause_filters(const char *csv, size_t len)
+{
+        ControlContext control = {0};
+        TestRecords expected = {0};
+        CsvReader *reader = csv_reader_alloc_view(&test_header_view, &test_record_view, &expected);
+        size_t fed;
+        int status;
+
+        // Only the records with "name 5" are delivered
+        TEST_ASSERT(csv_reader_filter_equals(reader, "name", "name 5") == 0);
+        TEST_ASSERT(csv_reader_parse_memory(reader, csv, len) == CSV_END);
+        csv_reader_free(reader);
+
+        control.reader = csv_reader_alloc_view(&control_pause_header, &control_pause_view, &control);
+        control.pauseEvery = 50;
+        TEST_ASSERT(csv_reader_filter_equals(control.reader, "name", "name 5") == 0);
+        status = csv_reader_parse_memory(control.reader, csv, len);
+        TEST_ASSERT(status == CSV_PAUSED);
+        while (status == CSV_PAUSED) {
+                errno = 0;
+                TEST_ASSERT(csv_reader_filter_prefix(control.reader, "id", "1") == -1 && errno == EBUSY);
+                TEST_ASSERT(csv_reader_filter_range(control.reader, "id", 0, 10) == -1 && errno == EBUSY);
+                TEST_ASSERT(csv_reader_filter_empty(control.reader, "id", 0) == -1 && errno == EBUSY);
+                errno = 0;
+                TEST_ASSERT(csv_reader_filter_clear(control.reader) == -1 && errno == EBUSY);
+                status = csv_reader_resume(control.reader);
+        }
+        TEST_ASSERT(status == CSV_END);
+        TEST_ASSERT(test_records_equal(&control.views, &expected));
+        test_records_free(&control.views);
+
+        // Stopping ends the paused parsing
+        TEST_ASSERT(csv_reader_parse_memory(control.reader, csv, len) == CSV_PAUSED);
+        csv_reader_stop(control.reader);
+        TEST_ASSERT(csv_reader_filter_clear(control.reader) == 0);
+        TEST_ASSERT(csv_reader_filter_equals(control.reader, "name", "name 5") == 0);
+        test_records_free(&control.views);
+
+        // Fed input keeps its filters until it is finished
+        control.pauseEvery = 0;
+        for (fed = 0; fed < len; fed += 4096) {
+                TEST_ASSERT(csv_reader_feed(control.reader, csv + fed, len - fed < 4096 ? len - fed : 4096) == CSV_END);
+                errno = 0;
+                TEST_ASSERT(csv_reader_filter_equals(control.reader, "id", "1") == -1 && errno == EBUSY);
+        }
+        TEST_ASSERT(csv_reader_finish(control.reader) == CSV_END);
+        TEST_ASSERT(test_records_equal(&control.views, &expected));
+        TEST_ASSERT(csv_reader_filter_clear(control.reader) == 0);
+
+        test_records_free(&control.views);
+        test_records_free(&expected);
+        csv_reader_free(control.reader);
+}
+
+/**
+ * The dictionaries and the allocator cannot be changed either while a
+ * parsing is paused or input is being fed: its records point to the
+ * dictionaries, its buffers come from the allocator
+ */
+static void control_pause_interning(const char *csv, size_t len)
+{
+        ControlContext control = {0};
+        TestRecords expected = {0};
+        CsvReader *reader = csv_reader_alloc(&test_header, &test_record, &expected);
+        size_t fed;
+        int status;
+
+        TEST_ASSERT(csv_reader_intern_column(reader, "name", 0) == 0);
+        TEST_ASSERT(csv_reader_parse_memory(reader, csv, len) == CSV_END);
+        csv_reader_free(reader);
+
+        control.reader = csv_reader_alloc(&control_header, &control_pause_record, &control);
+        control.pauseEvery = 1000;
+        TEST_ASSERT(csv_reader_intern_column(control.reader, "name", 0) == 0);
+        status = csv_reader_parse_memory(control.reader, csv, len);
+        TEST_ASSERT(status == CSV_PAUSED);
+        while (status == CSV_PAUSED) {
+                errno = 0;
+                TEST_ASSERT(csv_reader_intern_clear(control.reader) == -1 && errno == EBUSY);
+                errno = 0;
+                TEST_ASSERT(csv_reader_intern_column(control.reader, "id", 0) == -1 && errno == EBUSY);
+                errno = 0;
+                TEST_ASSERT(csv_reader_set_allocator(control.reader, NULL, NULL, NULL) == -1 && errno == EBUSY);
+                status = csv_reader_resume(control.reader);
+        }
+        TEST_ASSERT(status == CSV_END);
+        TEST_ASSERT(csv_reader_dictionary(control.reader, "name") != NULL);
+        TEST_ASSERT(csv_reader_dictionary(control.reader, "id") == NULL);
+        TEST_ASSERT(test_records_equal(&control.records, &expected));
+        test_records_free(&control.records);
+
+        // Fed input, until it is finished
+        control.pauseEvery = 0;
+        for (fed = 0; fed < len; fed += 4096) {
+                TEST_ASSERT(csv_reader_feed(control.reader, csv + fed, len - fed < 4096 ? len - fed : 4096) == CSV_END);
+                errno = 0;
+                TEST_ASSERT(csv_reader_intern_clear(control.reader) == -1 && errno == EBUSY);
+        }
+        TEST_ASSERT(csv_reader_finish(control.reader) == CSV_END);
+        TEST_ASSERT(test_records_equal(&control.records, &expected));
+        TEST_ASSERT(csv_reader_intern_clear(control.reader) == 0);
+        TEST_ASSERT(csv_reader_set_allocator(control.reader, NULL, NULL, NULL) == 0);
+
+        test_records_free(&control.records);
+        test_records_free(&expected);
+        csv_reader_free(control.reader);
+}
+
+void test_control(void)
+{
+        char *csv = malloc(64 * CONTROL_RECORDS);
+        size_t len = control_generate(csv, CONTROL_RECORDS);
+
+        control_skip(csv, len);
+        control_parallel(csv, len);
+        control_pause_filters(csv, len);
+        control_pause_interning(csv, len);
+        free(csv);
+}
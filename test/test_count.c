@@ -0,0 +1,222 @@
+//
+// Created by Davide on 17/10/2026.
+//
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "test.h"
+
+#define COUNT_PATH "c-csv-test-count.csv"
+#define COUNT_FILES 40
+#define COUNT_MAX_LENGTH (64 * 1024)
+
+static const size_t countBlockSizes[] = {0, 3, 63, 64, 65, 100, 4096};
+
+/**
+ * Generate a well formed csv file: unquoted fields, and quoted fields
+ * holding delimiters, escaped quotes, CR and LF, with lengths around the
+ * 64 bytes of the scan blocks. Records end with LF or CRLF, the last one
+ * may have no line ending
+ * @return the length of the file
+ */
+static size_t count_generate(char *csv, char delimiter)
+{
+        const char quoted[] = {'a', 'b', ',', '|', ';', '\n', '\r', '"', ' '};
+        size_t len = 0, records = 2 + test_random(300);
+        size_t fields = 1 + test_random(5);
+        size_t i, j, k, fieldLength;
+        char c;
+
+        for (i = 0; i < records && len + 1024 < COUNT_MAX_LENGTH; i++) {
+                for (j = 0; j < fields; j++) {
+                        if (j > 0)
+                                csv[len++] = delimiter;
+                        fieldLength = test_random(4) == 0 ? 50 + test_random(100) : test_random(8);
+                        // A record made of an empty field is an empty line
+                        if (fields == 1 && fieldLength == 0)
+                                fieldLength = 1;
+                        if (test_random(3) == 0) {
+                                csv[len++] = '"';
+                                for (k = 0; k < fieldLength; k++) {
+                                        c = quoted[test_random(sizeof quoted)];
+                                        if (c == '"')
+                                                csv[len++] = '"';
+                                        csv[len++] = c;
+                                }
+                                csv[len++] = '"';
+                        } else {
+                                for (k = 0; k < fieldLength; k++)
+                                        csv[len++] = (char) ('a' + test_random(26));
+                        }
+                }
+                if (i + 1 < records || test_random(2) == 0) {
+                        if (test_random(4) == 0)
+                                csv[len++] = '\r';
+                        csv[len++] = '\n';
+                }
+        }
+        return len;
+}
+
+/**
+ * The records of the file from the given record to the end, the header
+ * included
+ */
+static void count_suffix(const TestRecords *all, size_t start, TestRecords *suffix)
+{
+        size_t i = 0, record = 0, first = 0;
+
+        for (; i < all->length; i++) {
+                if (all->data[i] != TEST_RECORD_END)
+                        continue;
+                record++;
+                if (record == 1 || record > start + 1) {
+                        test_records_append_field(suffix, all->data + first, i - first);
+                        // The last separator of the fields is appended again
+                        suffix->length--;
+                        test_records_end(suffix);
+                }
+                first = i + 1;
+        }
+}
+
+static void count_collect_iterator(CsvIterator *iterator, TestRecords *records)
+{
+        RecordView *record;
+        test_records_append_view(records, csv_iterator_header(iterator));
+        while (csv_iterator_next(iterator, NULL, &record))
+                test_records_append_view(records, record);
+}
+
+/**
+ * Skip records with every kind of input and block size, and check that
+ * the records which follow are the right ones
+ */
+static void count_check(const char *csv, size_t len, const Dialect *dialect)
+{
+        TestRecords all, parsed = {0};
+        CsvReader *reader = csv_reader_alloc_view(&test_header_view, &test_record_view, &parsed);
+        size_t i, start, expected, count = 0, fed, chunk;
+        CsvIterator *iterator;
+        FILE *file;
+        int fd;
+
+        csv_reader_set_dialect(reader, dialect);
+        TEST_ASSERT(csv_reader_parse_memory(reader, csv, len) == 0);
+        all = parsed;
+        memset(&parsed, 0, sizeof(parsed));
+        expected = all.records > 0 ? all.records - 1 : 0;
+
+        TEST_ASSERT(csv_count_records_memory(reader, csv, len, &count) == 0 && count == expected);
+        TEST_ASSERT(test_write_file(COUNT_PATH, csv, len) == 0);
+        TEST_ASSERT(csv_count_records(reader, COUNT_PATH, &count) == 0 && count == expected);
+
+        for (i = 0; i < sizeof(countBlockSizes) / sizeof(countBlockSizes[0]); i++) {
+                TestRecords suffix = {0}, records = {0};
+                size_t skipped;
+
+                start = test_random((unsigned) expected + 2);
+                count_suffix(&all, start, &suffix);
+                csv_reader_set_block_size(reader, countBlockSizes[i]);
+
+                // Skipping with iterators
+                iterator = csv_iterator_open_memory(reader, csv, len);
+                skipped = csv_iterator_skip_records(iterator, start);
+                TEST_ASSERT(skipped == (start < expected ? start : expected));
+                count_collect_iterator(iterator, &records);
+                csv_iterator_close(iterator);
+                TEST_ASSERT(test_records_equal(&records, &suffix));
+                test_records_free(&records);
+
+                file = fopen(COUNT_PATH, "rb");
+                iterator = csv_iterator_open(reader, file);
+                TEST_ASSERT(csv_iterator_skip_records(iterator, start) == skipped);
+                count_collect_iterator(iterator, &records);
+                csv_iterator_close(iterator);
+                fclose(file);
+                TEST_ASSERT(test_records_equal(&records, &suffix));
+                test_records_free(&records);
+
+                fd = open(COUNT_PATH, O_RDONLY);
+                iterator = csv_iterator_open_fd(reader, fd);
+                TEST_ASSERT(csv_iterator_skip_records(iterator, start) == skipped);
+                count_collect_iterator(iterator, &records);
+                csv_iterator_close(iterator);
+                close(fd);
+                TEST_ASSERT(test_records_equal(&records, &suffix));
+                test_records_free(&records);
+
+                // Skipping to the starting record, without an index
+                if (start <= expected) {
+                        csv_reader_seek_record(reader, start);
+                        csv_reader_set_read_ahead(reader, countBlockSizes[i] >= 64 && i % 2 ? 2 : 0);
+
+                        TEST_ASSERT(csv_reader_parse_memory(reader, csv, len) == 0);
+                        TEST_ASSERT(test_records_equal(&parsed, &suffix));
+                        test_records_free(&parsed);
+
+                        file = fopen(COUNT_PATH, "rb");
+                        TEST_ASSERT(csv_reader_parse(reader, file) == 0);
+                        fclose(file);
+                        TEST_ASSERT(test_records_equal(&parsed, &suffix));
+                        test_records_free(&parsed);
+
+                        fd = open(COUNT_PATH, O_RDONLY);
+                        TEST_ASSERT(csv_reader_parse_fd(reader, fd) == 0);
+                        close(fd);
+                        TEST_ASSERT(test_records_equal(&parsed, &suffix));
+                        test_records_free(&parsed);
+
+                        // Fed input is always read from its beginning
+                        for (fed = 0; fed < len; fed += chunk) {
+                                chunk = 1 + test_random(200);
+                                chunk = chunk < len - fed ? chunk : len - fed;
+                                TEST_ASSERT(csv_reader_feed(reader, csv + fed, chunk) == 0);
+                        }
+                        TEST_ASSERT(csv_reader_finish(reader) == 0);
+                        TEST_ASSERT(test_records_equal(&parsed, &all));
+                        test_records_free(&parsed);
+
+                        csv_reader_seek_record(reader, 0);
+                        csv_reader_set_read_ahead(reader, 0);
+                }
+
+                test_records_free(&suffix);
+        }
+
+        remove(COUNT_PATH);
+        test_records_free(&all);
+        csv_reader_free(reader);
+}
+
+void test_count(void)
+{
+        char *csv = malloc(COUNT_MAX_LENGTH);
+        Dialect dialect;
+        size_t i, len;
+
+        test_random_seed(7);
+        for (i = 0; i < COUNT_FILES; i++) {
+                dialect_init(&dialect, i % 3 == 0 ? ',' : i % 3 == 1 ? '|' : ';');
+                len = count_generate(csv, dialect.delimiter);
+                count_check(csv, len, &dialect);
+        }
+
+        // Quotes and line endings exactly at the edges of the blocks
+        memset(csv, 'a', 256);
+        memcpy(csv, "h\n\"", 3);
+        csv[63] = '\n';
+        csv[127] = '"';
+        csv[128] = '\n';
+        csv[191] = '\r';
+        csv[192] = '\n';
+        csv[193] = '"';
+        csv[254] = '"';
+        csv[255] = '\n';
+        dialect_init(&dialect, ',');
+        count_check(csv, 256, &dialect);
+
+        free(csv);
+}
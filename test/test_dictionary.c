@@ -0,0 +1,72 @@
+//
+// Created by Davide on 17/10/2026.
+//
+
+#include <string.h>
+
+#include "test.h"
+
+#define DICTIONARY_RECORDS 8
+
+/**
+ * The values and codes of the two columns of each record
+ */
+typedef struct TestCodes_s {
+        char values[2][DICTIONARY_RECORDS][8];
+        uint32_t codes[2][DICTIONARY_RECORDS];
+        size_t records;
+} TestCodes;
+
+static void codes_record(void *context, Record *header, Record *record)
+{
+        TestCodes *codes = context;
+        size_t i;
+
+        if (codes->records >= DICTIONARY_RECORDS)
+                return;
+        for (i = 0; i < 2; i++) {
+                strncpy(codes->values[i][codes->records], record->fields[i], 7);
+                codes->codes[i][codes->records] = csv_record_code(record, i);
+        }
+        codes->records++;
+}
+
+void test_dictionary(void)
+{
+        const char *csv = "kind,mode\na,x\nb,y\nc,x\na,y\nb,x\nd,y\na,x\nc,y\n";
+        const char *kinds[] = {"a", "b", "c", "a", "b", "d", "a", "c"};
+        const char *modes[] = {"x", "y", "x", "y", "x", "y", "x", "y"};
+        const uint32_t kindCodes[] = {0, 1, 2, 0, 1, CSV_NO_CODE, CSV_NO_CODE, CSV_NO_CODE};
+        TestCodes codes = {0};
+        CsvReader *reader = csv_reader_alloc(NULL, &codes_record, &codes);
+        const Dictionary *kind, *mode;
+        size_t i, parsing;
+
+        TEST_ASSERT(csv_reader_intern_column(reader, "kind", 3) == 0);
+        TEST_ASSERT(csv_reader_intern_column(reader, "mode", 0) == 0);
+        kind = csv_reader_dictionary(reader, "kind");
+        mode = csv_reader_dictionary(reader, "mode");
+        TEST_ASSERT(kind != NULL && mode != NULL);
+        if (kind == NULL || mode == NULL) return;
+
+        // The codes are stable across parsings, a spilled column stays spilled
+        for (parsing = 0; parsing < 2; parsing++) {
+                memset(&codes, 0, sizeof(codes));
+                TEST_ASSERT(csv_reader_parse_memory(reader, csv, strlen(csv)) == 0);
+                TEST_ASSERT(codes.records == DICTIONARY_RECORDS);
+
+                for (i = 0; i < DICTIONARY_RECORDS; i++) {
+                        TEST_ASSERT(strcmp(codes.values[0][i], kinds[i]) == 0);
+                        TEST_ASSERT(strcmp(codes.values[1][i], modes[i]) == 0);
+                        // Once the fourth kind is found, no kind is looked up
+                        TEST_ASSERT(codes.codes[0][i] == (parsing == 0 ? kindCodes[i] : CSV_NO_CODE));
+                        TEST_ASSERT(codes.codes[1][i] == (uint32_t) (i % 2));
+                }
+        }
+
+        TEST_ASSERT(kind->spilled && kind->count == 3);
+        TEST_ASSERT(strcmp(kind->values[2], "c") == 0);
+        TEST_ASSERT(!mode->spilled && mode->count == 2);
+        TEST_ASSERT(strcmp(mode->values[1], "y") == 0 && mode->lengths[1] == 1);
+        csv_reader_free(reader);
+}
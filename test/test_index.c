@@ -0,0 +1,120 @@
+//
+// Created by Davide on 17/10/2026.
+//
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "test.h"
+
+#define INDEX_PATH "c-csv-test.idx"
+
+/**
+ * The records of a file from a starting record, the header included
+ */
+typedef struct TestSuffix_s {
+        TestRecords records;
+        size_t start;
+        size_t seen;
+} TestSuffix;
+
+static void suffix_header(void *context, RecordView *header)
+{
+        test_records_append_view(&((TestSuffix *) context)->records, header);
+}
+
+static void suffix_record(void *context, RecordView *header, RecordView *record)
+{
+        TestSuffix *suffix = context;
+        if (suffix->seen++ >= suffix->start)
+                test_records_append_view(&suffix->records, record);
+}
+
+void test_index(void)
+{
+        const char *path = "../test/test2.csv", *other = "../test/test.csv";
+        const size_t starts[] = {1, 99, 100, 101, 4321, 8613};
+        TestRecords records = {0};
+        CsvReader *reader = csv_reader_alloc_view(&test_header_view, &test_record_view, &records);
+        RecordIndex *index = csv_index_build(reader, path, 100);
+        RecordIndex *loaded;
+        CsvIterator *iterator;
+        size_t i, len;
+        char *data = test_read_file(path, &len);
+        FILE *csv;
+        int fd;
+
+        TEST_ASSERT(index != NULL && data != NULL);
+        if (index == NULL || data == NULL) return;
+        TEST_ASSERT(csv_index_save(index, INDEX_PATH) == 0);
+        loaded = csv_index_load(INDEX_PATH);
+        remove(INDEX_PATH);
+        TEST_ASSERT(loaded != NULL);
+        if (loaded == NULL) return;
+        csv_index_free(index);
+        csv_reader_set_index(reader, loaded);
+
+        for (i = 0; i < sizeof(starts) / sizeof(starts[0]); i++) {
+                TestSuffix suffix = {{0}, starts[i], 0};
+                CsvReader *full = csv_reader_alloc_view(&suffix_header, &suffix_record, &suffix);
+                TEST_ASSERT(csv_reader_parse_memory(full, data, len) == 0);
+                csv_reader_free(full);
+
+                TEST_ASSERT(csv_reader_seek_record(reader, starts[i]) == 0);
+                TEST_ASSERT(csv_reader_parse_path(reader, path) == 0);
+                TEST_ASSERT(test_records_equal(&records, &suffix.records));
+                test_records_free(&records);
+
+                TEST_ASSERT(csv_reader_parse_memory(reader, data, len) == 0);
+                TEST_ASSERT(test_records_equal(&records, &suffix.records));
+                test_records_free(&records);
+
+                csv = fopen(path, "rb");
+                TEST_ASSERT(csv_reader_parse(reader, csv) == 0);
+                fclose(csv);
+                TEST_ASSERT(test_records_equal(&records, &suffix.records));
+                test_records_free(&records);
+
+                fd = open(path, O_RDONLY);
+                TEST_ASSERT(csv_reader_parse_fd(reader, fd) == 0);
+                close(fd);
+                TEST_ASSERT(test_records_equal(&records, &suffix.records));
+                test_records_free(&records);
+
+                test_records_free(&suffix.records);
+        }
+
+        // An index built on another file is rejected, whatever the input
+        TEST_ASSERT(csv_reader_seek_record(reader, 1) == 0);
+        errno = 0;
+        TEST_ASSERT(csv_reader_parse_path(reader, other) == -1 && errno == EINVAL);
+        free(data);
+        data = test_read_file(other, &len);
+        errno = 0;
+        TEST_ASSERT(csv_reader_parse_memory(reader, data, len) == -1 && errno == EINVAL);
+        csv = fopen(other, "rb");
+        errno = 0;
+        TEST_ASSERT(csv_reader_parse(reader, csv) == -1 && errno == EINVAL);
+        fclose(csv);
+        fd = open(other, O_RDONLY);
+        errno = 0;
+        TEST_ASSERT(csv_reader_parse_fd(reader, fd) == -1 && errno == EINVAL);
+        close(fd);
+        TEST_ASSERT(records.records == 0);
+
+        iterator = csv_iterator_open_path(reader, other);
+        errno = 0;
+        TEST_ASSERT(csv_iterator_seek_record(iterator, 1) == -1 && errno == EINVAL);
+        csv_iterator_close(iterator);
+
+        // The index is not used, nor checked, without a starting record
+        TEST_ASSERT(csv_reader_seek_record(reader, 0) == 0);
+        TEST_ASSERT(csv_reader_parse_memory(reader, data, len) == 0);
+        TEST_ASSERT(records.records == 3);
+
+        test_records_free(&records);
+        free(data);
+        csv_reader_free(reader);
+        csv_index_free(loaded);
+}
@@ -0,0 +1,66 @@
+//
+// Created by Davide on 17/10/2026.
+//
+
+#include "test.h"
+
+/**
+ * Collect the records of an iterator, header included
+ */
+static void test_iterator_collect(CsvIterator *iterator, TestRecords *records)
+{
+        RecordView *header, *record;
+        int first = 1;
+
+        while (csv_iterator_next(iterator, &header, &record)) {
+                if (first)
+                        test_records_append_view(records, header);
+                test_records_append_view(records, record);
+                first = 0;
+        }
+}
+
+void test_iterator(void)
+{
+        const char *paths[] = {"../test/test.csv", "../test/test2.csv"};
+        size_t i, len;
+
+        for (i = 0; i < sizeof(paths) / sizeof(paths[0]); i++) {
+                TestRecords parsed = {0}, fromPath = {0}, fromStream = {0};
+                CsvReader *reader = csv_reader_alloc_view(&test_header_view, &test_record_view, &parsed);
+                char *data = test_read_file(paths[i], &len);
+                CsvIterator *iterator;
+                FILE *csv;
+
+                TEST_ASSERT(data != NULL);
+                if (data == NULL) break;
+                TEST_ASSERT(csv_reader_parse_memory(reader, data, len) == 0);
+
+                // The iterator owns the file it opens, and releases it when closed
+                iterator = csv_iterator_open_path(reader, paths[i]);
+                TEST_ASSERT(iterator != NULL);
+                if (iterator != NULL) {
+                        test_iterator_collect(iterator, &fromPath);
+                        csv_iterator_close(iterator);
+                }
+                TEST_ASSERT(test_records_equal(&parsed, &fromPath));
+
+                csv = fopen(paths[i], "rb");
+                iterator = csv_iterator_open(reader, csv);
+                TEST_ASSERT(iterator != NULL);
+                if (iterator != NULL) {
+                        test_iterator_collect(iterator, &fromStream);
+                        csv_iterator_close(iterator);
+                }
+                fclose(csv);
+                TEST_ASSERT(test_records_equal(&parsed, &fromStream));
+
+                TEST_ASSERT(csv_iterator_open_path(reader, "../test/missing.csv") == NULL);
+
+                csv_reader_free(reader);
+                test_records_free(&parsed);
+                test_records_free(&fromPath);
+                test_records_free(&fromStream);
+                free(data);
+        }
+}
@@ -0,0 +1,276 @@
+//
+// Created by Davide on 17/10/2026.
+//
+
+#include <errno.h>
+#include <float.h>
+#include <inttypes.h>
+#include <locale.h>
+#include <math.h>
+#include <string.h>
+
+#include "test.h"
+#include "utils.h"
+
+#define NUMBER_CASES 100000
+#define NUMBER_BUFFER 1024
+
+static uint64_t numberSeed = 88172645463325252ULL;
+
+static uint64_t number_random(void)
+{
+        numberSeed ^= numberSeed << 13;
+        numberSeed ^= numberSeed >> 7;
+        numberSeed ^= numberSeed << 17;
+        return numberSeed;
+}
+
+/**
+ * Compare string_to_double with strtod, in the C locale: both must accept
+ * the string and return the same value, or both must find it out of range.
+ * Values which underflow to subnormals are accepted by string_to_double
+ */
+static void number_check_double(const char *str)
+{
+        size_t len = strlen(str);
+        double expected, value = 0;
+        char *end;
+        int expectedResult, result;
+
+        errno = 0;
+        expected = strtod(str, &end);
+        expectedResult = errno == ERANGE && (expected == 0 || isinf(expected)) ? -1 : 0;
+        // string_to_double also accepts trailing spaces
+        while (*end == ' ')
+                end++;
+        TEST_ASSERT(*end == 0);
+
+        errno = 0;
+        result = string_to_double(str, len, &value);
+        if (result != expectedResult || (result == 0 && memcmp(&value, &expected, sizeof(double)) != 0) ||
+            (result < 0 && errno != ERANGE)) {
+                fprintf(stderr, "string_to_double(\"%.80s\") = %d %.17g, strtod %d %.17g\n", str, result, value,
+                        expectedResult, expected);
+                testFailures++;
+        }
+
+        if (result == 0) {
+                TEST_ASSERT(string_type_len(str, len) == STRING_TYPE_INT || string_type_len(str, len) == STRING_TYPE_FLOAT);
+        }
+}
+
+/**
+ * Compare string_to_int64 with strtoll, in the C locale
+ */
+static void number_check_int(const char *str)
+{
+        int64_t value = 0;
+        long long expected;
+        char *end;
+        int expectedResult, result;
+
+        errno = 0;
+        expected = strtoll(str, &end, 10);
+        expectedResult = errno == ERANGE ? -1 : 0;
+        TEST_ASSERT(*end == 0);
+
+        errno = 0;
+        result = string_to_int64(str, strlen(str), &value);
+        if (result != expectedResult || (result == 0 && value != expected) || (result < 0 && errno != ERANGE)) {
+                fprintf(stderr, "string_to_int64(\"%.80s\") = %d %" PRId64 ", strtoll %d %lld\n", str, result, value,
+                        expectedResult, expected);
+                testFailures++;
+        }
+}
+
+/**
+ * Write a random string of digits
+ * @return the number of digits
+ */
+static size_t number_digits(char *str, size_t count)
+{
+        size_t i;
+        for (i = 0; i < count; i++)
+                str[i] = (char) ('0' + number_random() % 10);
+        return count;
+}
+
+/**
+ * The exact decimal expansion of the value halfway between a double and
+ * the next one, and the values just below and above it: the hardest cases
+ * to round, with hundreds of significant digits
+ */
+static void number_check_halfway(double value)
+{
+        char str[NUMBER_BUFFER];
+        char *exponent;
+        uint64_t bits;
+        double next;
+        long double halfway;
+        size_t len;
+
+        if (!(LDBL_MANT_DIG > DBL_MANT_DIG) || value <= 0 || isinf(value) || value >= DBL_MAX)
+                return;
+
+        memcpy(&bits, &value, sizeof(double));
+        bits++;
+        memcpy(&next, &bits, sizeof(double));
+        halfway = ((long double) value + (long double) next) / 2;
+
+        // The digits are exact: the halfway value is a dyadic rational
+        snprintf(str, sizeof str, "%.780Le", halfway);
+        number_check_double(str);
+
+        exponent = strchr(str, 'e');
+        if (exponent == NULL)
+                return;
+        len = (size_t) (exponent - str);
+        // Strip the trailing zeros, then move slightly below and above
+        while (str[len - 1] == '0')
+                len--;
+        memmove(str + len, exponent, strlen(exponent) + 1);
+        number_check_double(str);
+
+        memmove(str + len + 3, str + len, strlen(str + len) + 1);
+        memcpy(str + len, "001", 3);
+        number_check_double(str);
+
+        if (str[len - 1] > '1') {
+                str[len - 1]--;
+                memcpy(str + len, "999", 3);
+                number_check_double(str);
+        }
+}
+
+/**
+ * The numbers which are converted by the C library are read with the
+ * decimal point '.' whatever the locale
+ */
+static void number_check_locale(void)
+{
+        static const char *doubles[] = {"0.1000000000000000055511", "2.2250738585072011e-308", "1.5",
+                                        "123456789012345678901234567890.5", "9007199254740993.0000000000001",
+                                        "4.9406564584124654e-324"};
+        double expected[sizeof(doubles) / sizeof(doubles[0])];
+        double value;
+        size_t i;
+
+        for (i = 0; i < sizeof(doubles) / sizeof(doubles[0]); i++)
+                expected[i] = strtod(doubles[i], NULL);
+
+        // Only checked where such a locale is installed
+        if (!test_comma_locale())
+                return;
+
+        for (i = 0; i < sizeof(doubles) / sizeof(doubles[0]); i++) {
+                value = 0;
+                TEST_ASSERT(string_to_double(doubles[i], strlen(doubles[i]), &value) == 0 && value == expected[i]);
+        }
+        // The decimal point of the locale is not one
+        TEST_ASSERT(string_to_double("0,1000000000000000055511", 24, &value) == -1);
+
+        setlocale(LC_NUMERIC, "C");
+}
+
+void test_number(void)
+{
+        static const char *doubles[] = {"0", "-0", "0.0", "1e308", "1.7976931348623157e308", "1.7976931348623158e308",
+                                        "1.8e308", "4.9406564584124654e-324", "2.4703282292062327e-324",
+                                        "2.4703282292062328e-324", "2.2250738585072011e-308", "2.2250738585072014e-308",
+                                        "9007199254740993", "9007199254740992.5", "1e23", "8.98846567431158e307",
+                                        "36.47058868", "10.30000019", "0.000000000000000000000000000001",
+                                        "123456789012345678901234567890", "1e-400", "1e400", "0e999999999999",
+                                        "1.5e+0010", ".5", "5.", "  7.25  ", "-2.5E-3", "00000000000000000000000001.5",
+                                        "0.1", "0.2", "0.3", "3.14159265358979323846", "7.3177701707893310e+15",
+                                        "9007199254740993.0000000000001"};
+        static const char *ints[] = {"9223372036854775807", "9223372036854775808", "-9223372036854775808",
+                                     "-9223372036854775809", "18446744073709551616", "000000000000000000000000042",
+                                     "-0", "+5", "99999999999999999999", "0",
+                                     "0000000000000000000000000000000000000000000000000000000000000000000000000007"};
+        static const char *invalid[] = {"", " ", "abc", "1.2.3", "1e", "1e+", "--1", "1x", ".", "e5", "inf", "nan",
+                                        "0x10", "1 2"};
+        char str[NUMBER_BUFFER];
+        size_t i, len;
+        uint64_t bits;
+        double value;
+        int64_t integer;
+
+        for (i = 0; i < sizeof(doubles) / sizeof(doubles[0]); i++)
+                number_check_double(doubles[i]);
+        for (i = 0; i < sizeof(ints) / sizeof(ints[0]); i++)
+                number_check_int(ints[i]);
+        for (i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+                errno = 0;
+                TEST_ASSERT(string_to_double(invalid[i], strlen(invalid[i]), &value) < 0 && errno == EINVAL);
+                TEST_ASSERT(string_to_int64(invalid[i], strlen(invalid[i]), &integer) < 0 && errno == EINVAL);
+        }
+
+        // Mantissas of 64 digits or more, which used to be rejected
+        memset(str, '0', 70);
+        strcpy(str + 70, "1.5");
+        number_check_double(str);
+        strcpy(str, "0.");
+        memset(str + 2, '3', 100);
+        str[102] = 0;
+        number_check_double(str);
+        strcpy(str, "-1");
+        memset(str + 2, '0', 400);
+        str[402] = 0;
+        number_check_double(str);
+        strcpy(str + 402, "e-300");
+        number_check_double(str);
+        strcpy(str, "1.");
+        memset(str + 2, '0', 500);
+        strcpy(str + 502, "1e5");
+        number_check_double(str);
+        memset(str, '9', 900);
+        strcpy(str + 900, "e-1000");
+        number_check_double(str);
+        memset(str, '1', 64);
+        str[64] = 0;
+        number_check_double(str);
+        number_check_int(str);
+
+        for (i = 0; i < NUMBER_CASES; i++) {
+                bits = number_random();
+                memcpy(&value, &bits, sizeof(double));
+                if (isnan(value) || isinf(value))
+                        continue;
+
+                snprintf(str, sizeof str, "%.*g", (int) (number_random() % 17) + 1, value);
+                number_check_double(str);
+                snprintf(str, sizeof str, "%.17g", value);
+                number_check_double(str);
+                snprintf(str, sizeof str, "%" PRIu64 "e%d", number_random() >> (number_random() % 64),
+                         (int) (number_random() % 700) - 350);
+                number_check_double(str);
+                snprintf(str, sizeof str, "%" PRIu64 ".%" PRIu64, number_random() % 100000,
+                         number_random() % 100000000);
+                number_check_double(str);
+                snprintf(str, sizeof str, "%" PRId64,
+                         (int64_t) (number_random() >> (number_random() % 64)) * (number_random() & 1 ? -1 : 1));
+                number_check_int(str);
+                number_check_double(str);
+
+                // Long mantissas, with and without a decimal point and an exponent
+                if (i % 16 == 0) {
+                        len = number_digits(str, 1 + number_random() % 300);
+                        if (number_random() & 1) {
+                                str[len++] = '.';
+                                len += number_digits(str + len, number_random() % 300);
+                        }
+                        snprintf(str + len, sizeof str - len, "e%d", (int) (number_random() % 800) - 400);
+                        number_check_double(str);
+                        str[len] = 0;
+                        number_check_double(str);
+                }
+
+                if (i % 64 == 0) {
+                        number_check_halfway(value < 0 ? -value : value);
+                        // Integers too
+                        number_check_halfway((double) (number_random() >> (number_random() % 64)));
+                }
+        }
+
+        number_check_locale();
+}
@@ -0,0 +1,130 @@
+//
+// Created by Davide on 17/10/2026.
+//
+
+#include <string.h>
+
+#include "test.h"
+#include "schema.h"
+#include "utils.h"
+
+#define SCHEMA_PATH "c-csv-test-schema.csv"
+
+// Records 2 and 5 have fields past the header, records 3 and 4 are shorter
+static const char schemaCsv[] = "id,price,name,empty\n"
+                                "1,1.5,\"a\",\n"
+                                "2,,bb,\n"
+                                "3,2,\"c\"\"c\",,x\n"
+                                "4,-3.25,dddd\n"
+                                "5,7,e,\n"
+                                "6,8,ffffff,,,y\n";
+
+/**
+ * Check the inferred schema of a column
+ * @return 1 if it is the expected one, 0 otherwise
+ */
+static int schema_column(const Schema *schema, size_t column, char type, size_t nullCount, size_t minWidth,
+                         size_t maxWidth)
+{
+        const ColumnSchema *inferred;
+
+        if (column >= schema->columnCount)
+                return 0;
+        inferred = &schema->columns[column];
+        if (inferred->type == type && inferred->nullCount == nullCount && inferred->minWidth == minWidth &&
+            inferred->maxWidth == maxWidth && column_schema_nullable(inferred) == (nullCount > 0))
+                return 1;
+        fprintf(stderr, "column %zu: type %d, %zu nulls, width from %zu to %zu\n", column, inferred->type,
+                inferred->nullCount, inferred->minWidth, inferred->maxWidth);
+        return 0;
+}
+
+/**
+ * Infer the schema of schemaCsv with an iterator
+ */
+static Schema *schema_infer(size_t samples, size_t stride)
+{
+        CsvReader *reader = csv_reader_alloc_view(NULL, NULL, NULL);
+        CsvIterator *iterator = csv_iterator_open_memory(reader, schemaCsv, sizeof schemaCsv - 1);
+        Schema *result = NULL;
+
+        TEST_ASSERT(iterator != NULL);
+        if (iterator != NULL) {
+                result = csv_iterator_infer_schema(iterator, samples, stride);
+                csv_iterator_close(iterator);
+        }
+        csv_reader_free(reader);
+        TEST_ASSERT(result != NULL);
+        return result;
+}
+
+/**
+ * Sample every record of the file
+ */
+static void schema_check_all(const Schema *schema)
+{
+        TEST_ASSERT(schema->sampledRecords == 6 && schema->columnCount == 6);
+        TEST_ASSERT(schema->names->arraySize == 4 && strcmp(schema->names->fields[2], "name") == 0);
+        TEST_ASSERT(schema_column(schema, 0, STRING_TYPE_INT, 0, 1, 1));
+        TEST_ASSERT(schema_column(schema, 1, STRING_TYPE_FLOAT, 1, 1, 5));
+        // Fields are measured once unescaped
+        TEST_ASSERT(schema_column(schema, 2, STRING_TYPE_TEXT, 0, 1, 6));
+        // Both empty and missing fields are null
+        TEST_ASSERT(schema_column(schema, 3, STRING_TYPE_EMPTY, 6, 0, 0));
+        // The columns past the header are null in the records sampled before
+        TEST_ASSERT(schema_column(schema, 4, STRING_TYPE_TEXT, 5, 1, 1));
+        TEST_ASSERT(schema_column(schema, 5, STRING_TYPE_TEXT, 5, 1, 1));
+}
+
+void test_schema(void)
+{
+        CsvReader *reader = csv_reader_alloc_view(NULL, NULL, NULL);
+        Schema *schema;
+
+        TEST_ASSERT(test_write_file(SCHEMA_PATH, schemaCsv, sizeof schemaCsv - 1) == 0);
+        schema = csv_reader_infer_schema(reader, SCHEMA_PATH, 0, 1);
+        TEST_ASSERT(schema != NULL);
+        if (schema != NULL)
+                schema_check_all(schema);
+        schema_free(schema);
+
+        schema = schema_infer(0, 0);
+        if (schema != NULL)
+                schema_check_all(schema);
+        schema_free(schema);
+
+        // Records 0, 2 and 4
+        schema = schema_infer(0, 2);
+        if (schema != NULL) {
+                TEST_ASSERT(schema->sampledRecords == 3 && schema->columnCount == 5);
+                TEST_ASSERT(schema_column(schema, 0, STRING_TYPE_INT, 0, 1, 1));
+                TEST_ASSERT(schema_column(schema, 1, STRING_TYPE_FLOAT, 0, 1, 3));
+                TEST_ASSERT(schema_column(schema, 2, STRING_TYPE_TEXT, 0, 1, 3));
+                TEST_ASSERT(schema_column(schema, 3, STRING_TYPE_EMPTY, 3, 0, 0));
+                TEST_ASSERT(schema_column(schema, 4, STRING_TYPE_TEXT, 2, 1, 1));
+        }
+        schema_free(schema);
+
+        // Records 0 and 3
+        schema = schema_infer(2, 3);
+        if (schema != NULL) {
+                TEST_ASSERT(schema->sampledRecords == 2 && schema->columnCount == 4);
+                TEST_ASSERT(schema_column(schema, 0, STRING_TYPE_INT, 0, 1, 1));
+                TEST_ASSERT(schema_column(schema, 1, STRING_TYPE_FLOAT, 0, 3, 5));
+                TEST_ASSERT(schema_column(schema, 2, STRING_TYPE_TEXT, 0, 1, 4));
+                TEST_ASSERT(schema_column(schema, 3, STRING_TYPE_EMPTY, 2, 0, 0));
+        }
+        schema_free(schema);
+
+        // Only the first record
+        schema = schema_infer(1, 1);
+        if (schema != NULL) {
+                TEST_ASSERT(schema->sampledRecords == 1 && schema->columnCount == 4);
+                TEST_ASSERT(schema_column(schema, 1, STRING_TYPE_FLOAT, 0, 3, 3));
+                TEST_ASSERT(schema_column(schema, 2, STRING_TYPE_TEXT, 0, 1, 1));
+        }
+        schema_free(schema);
+
+        remove(SCHEMA_PATH);
+        csv_reader_free(reader);
+}
@@ -0,0 +1,132 @@
+//
+// Created by Davide on 17/10/2026.
+//
+
+#include <string.h>
+
+#include "test.h"
+
+#define STATS_RECORDS 20000
+
+// The longest record is the multiline one, 12 bytes with its line ending
+static const char statsCsv[] = "id,name\n1,\"a\r\nb, c\"\n2,\"x\"\"y\"\n3,plain\n4,\n";
+
+static void stats_record(void *context, RecordView *header, RecordView *record)
+{
+        *(size_t *) context += 1;
+}
+
+#ifdef CSV_STATS
+
+/**
+ * Check the statistics of a parsing of statsCsv
+ * @param times how many times statsCsv has been parsed
+ * @param delivered the records delivered, the others have been skipped
+ */
+static void stats_check(const CsvStats *stats, size_t times, size_t delivered)
+{
+        TEST_ASSERT(stats->bytes == times * (sizeof statsCsv - 1));
+        TEST_ASSERT(stats->records == times * 5);
+        TEST_ASSERT(stats->skippedRecords == times * 4 - delivered);
+        TEST_ASSERT(stats->fields == times * 10);
+        TEST_ASSERT(stats->quotedFields == times * 2);
+        TEST_ASSERT(stats->multilineRecords == times);
+        TEST_ASSERT(stats->largestRecord == 12);
+}
+
+/**
+ * Compare the statistics of two parsings of the same input
+ */
+static int stats_equal(const CsvStats *a, const CsvStats *b)
+{
+        return a->bytes == b->bytes && a->records == b->records && a->skippedRecords == b->skippedRecords &&
+               a->fields == b->fields && a->quotedFields == b->quotedFields &&
+               a->multilineRecords == b->multilineRecords && a->largestRecord == b->largestRecord;
+}
+
+/**
+ * The statistics of the workers of a parallel parsing, and those of an
+ * iterator when it is closed, are added to those of the reader
+ */
+static void stats_merge(void)
+{
+        char *csv = malloc(64 * STATS_RECORDS);
+        size_t len = (size_t) sprintf(csv, "id,name,\"quoted\"\n");
+        size_t i, records = 0;
+        CsvReader *reader = csv_reader_alloc_view(NULL, &stats_record, &records);
+        CsvStats sequential, stats;
+        CsvIterator *iterator;
+        RecordView *record;
+
+        for (i = 0; i < STATS_RECORDS; i++)
+                len += (size_t) sprintf(csv + len, "%zu,name %zu,\"a,\"\"%zu\"\"\nb\"\n", i, i % 97, i);
+
+        TEST_ASSERT(csv_reader_parse_memory(reader, csv, len) == CSV_END);
+        csv_reader_stats(reader, &sequential);
+        TEST_ASSERT(sequential.bytes == len && sequential.records == STATS_RECORDS + 1);
+        TEST_ASSERT(sequential.quotedFields == STATS_RECORDS + 1 && sequential.multilineRecords == STATS_RECORDS);
+
+        csv_reader_stats_reset(reader);
+        csv_reader_parse_memory_parallel(reader, csv, len, 4, 1);
+        csv_reader_stats(reader, &stats);
+        TEST_ASSERT(stats_equal(&stats, &sequential));
+
+        csv_reader_stats_reset(reader);
+        iterator = csv_iterator_open_memory(reader, csv, len);
+        TEST_ASSERT(iterator != NULL);
+        if (iterator != NULL) {
+                while (csv_iterator_next(iterator, NULL, &record));
+                // Nothing is added until the iterator is closed
+                csv_reader_stats(reader, &stats);
+                TEST_ASSERT(stats.records == 0);
+                csv_iterator_close(iterator);
+        }
+        csv_reader_stats(reader, &stats);
+        TEST_ASSERT(stats_equal(&stats, &sequential));
+
+        csv_reader_free(reader);
+        free(csv);
+}
+
+#endif
+
+void test_stats(void)
+{
+        size_t records = 0;
+        CsvReader *reader = csv_reader_alloc_view(NULL, &stats_record, &records);
+        CsvStats stats;
+
+#ifdef CSV_STATS
+        TEST_ASSERT(csv_reader_parse_memory(reader, statsCsv, sizeof statsCsv - 1) == CSV_END);
+        csv_reader_stats(reader, &stats);
+        stats_check(&stats, 1, 4);
+        TEST_ASSERT(stats.totalTime == 0 && stats.callbackTime == 0);
+
+        // The statistics accumulate until they are reset
+        TEST_ASSERT(csv_reader_parse_memory(reader, statsCsv, sizeof statsCsv - 1) == CSV_END);
+        csv_reader_stats(reader, &stats);
+        stats_check(&stats, 2, 8);
+
+        csv_reader_stats_reset(reader);
+        csv_reader_stats(reader, &stats);
+        TEST_ASSERT(stats.bytes == 0 && stats.records == 0 && stats.fields == 0 && stats.largestRecord == 0);
+
+        // The records rejected by the predicates are skipped
+        TEST_ASSERT(csv_reader_filter_equals(reader, "name", "plain") == 0);
+        csv_reader_stats_timing(reader, 1);
+        records = 0;
+        TEST_ASSERT(csv_reader_parse_memory(reader, statsCsv, sizeof statsCsv - 1) == CSV_END);
+        TEST_ASSERT(records == 1);
+        csv_reader_stats(reader, &stats);
+        stats_check(&stats, 1, 1);
+        TEST_ASSERT(stats.totalTime > 0 && stats.callbackTime >= 0 && stats.callbackTime <= stats.totalTime);
+
+        stats_merge();
+#else
+        TEST_ASSERT(csv_reader_parse_memory(reader, statsCsv, sizeof statsCsv - 1) == CSV_END);
+        csv_reader_stats(reader, &stats);
+        TEST_ASSERT(stats.bytes == 0 && stats.records == 0);
+#endif
+
+        csv_reader_free(reader);
+}
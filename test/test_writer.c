@@ -0,0 +1,257 @@
+//
+// Created by Davide on 17/10/2026.
+//
+
+#include <errno.h>
+#include <fcntl.h>
+#include <locale.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "test.h"
+
+#define WRITER_PATH "c-csv-test-writer.csv"
+#define WRITER_RECORDS 300
+#define WRITER_LONG_FIELD ((1 << 20) + 4321)
+
+#define OUTPUT_FILE 0
+#define OUTPUT_FD 1
+#define OUTPUT_PATH 2
+#define OUTPUTS 3
+
+/**
+ * Generate random records whose fields are made of the given characters:
+ * records are separated by TEST_RECORD_END and fields by TEST_FIELD_END,
+ * as in TestRecords. Every record has the same number of fields, so that
+ * the first one can be read as a header; a few fields are longer than the
+ * buffer of the writer
+ */
+static void writer_generate(TestRecords *records, const char *alphabet, int longFields)
+{
+        size_t alphabetLength = strlen(alphabet);
+        size_t fields = 1 + test_random(6);
+        size_t i, j, k, len;
+        char *field = malloc(WRITER_LONG_FIELD);
+
+        for (i = 0; i < WRITER_RECORDS; i++) {
+                for (j = 0; j < fields; j++) {
+                        switch (test_random(8)) {
+                        case 0:
+                                len = 0;
+                                break;
+                        case 1:
+                                len = 64 + test_random(200);
+                                break;
+                        default:
+                                len = test_random(12);
+                                break;
+                        }
+                        if (longFields && i % 100 == 50 && j == 0)
+                                len = WRITER_LONG_FIELD;
+                        for (k = 0; k < len; k++)
+                                field[k] = alphabet[test_random((unsigned) alphabetLength)];
+                        // A record made of an empty field is an empty line, which is not a record
+                        if (fields == 1 && len == 0)
+                                field[len++] = 'x';
+                        test_records_append_field(records, field, len);
+                }
+                test_records_end(records);
+        }
+        free(field);
+}
+
+/**
+ * Write the generated records with a writer on the given output
+ * @return the result of csv_writer_close
+ */
+static int writer_write(const TestRecords *records, const Dialect *dialect, int output)
+{
+        CsvWriter *writer;
+        FILE *file = NULL;
+        size_t start = 0, i;
+        int result, fd = -1;
+
+        switch (output) {
+        case OUTPUT_FILE:
+                file = fopen(WRITER_PATH, "wb");
+                writer = csv_writer_open(file);
+                break;
+        case OUTPUT_FD:
+                fd = open(WRITER_PATH, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+                writer = csv_writer_open_fd(fd);
+                break;
+        default:
+                writer = csv_writer_open_path(WRITER_PATH);
+                break;
+        }
+
+        TEST_ASSERT(writer != NULL);
+        TEST_ASSERT(csv_writer_set_dialect(writer, dialect) == 0);
+        for (i = 0; i < records->length; i++) {
+                if (records->data[i] == TEST_FIELD_END) {
+                        csv_writer_field(writer, records->data + start, i - start);
+                        start = i + 1;
+                } else if (records->data[i] == TEST_RECORD_END) {
+                        csv_writer_end_record(writer);
+                        start = i + 1;
+                }
+        }
+
+        // The writer closes only the files it opens
+        result = csv_writer_close(writer);
+        if (fd >= 0)
+                close(fd);
+        if (file != NULL)
+                fclose(file);
+        return result;
+}
+
+/**
+ * Write random records with a dialect, on every kind of output, and read
+ * them back with the same dialect
+ */
+static void writer_round_trip(const Dialect *dialect, const char *alphabet, int longFields)
+{
+        TestRecords records = {0};
+        int output;
+
+        writer_generate(&records, alphabet, longFields);
+
+        for (output = 0; output < OUTPUTS; output++) {
+                TestRecords read = {0};
+                CsvReader *reader = csv_reader_alloc_view(&test_header_view, &test_record_view, &read);
+
+                TEST_ASSERT(writer_write(&records, dialect, output) == 0);
+                TEST_ASSERT(csv_reader_set_dialect(reader, dialect) == 0);
+                TEST_ASSERT(csv_reader_parse_path(reader, WRITER_PATH) == 0);
+                csv_reader_free(reader);
+
+                if (!test_records_equal(&records, &read)) {
+                        fprintf(stderr, "round trip with delimiter %d, quote %d, escape %d, line ending %d, trim %d "
+                                        "on output %d differs\n", dialect->delimiter, dialect->quote,
+                                dialect->escape, dialect->lineEnding, dialect->trim, output);
+                        testFailures++;
+                }
+                test_records_free(&read);
+        }
+
+        remove(WRITER_PATH);
+        test_records_free(&records);
+}
+
+static void writer_dialect(Dialect *dialect, char delimiter, char quote, char escape, char lineEnding, char trim)
+{
+        dialect->delimiter = delimiter;
+        dialect->quote = quote;
+        dialect->escape = escape;
+        dialect->lineEnding = lineEnding;
+        dialect->trim = trim;
+}
+
+/**
+ * Check that a field which a dialect cannot represent fails the writer
+ */
+static void writer_reject(const Dialect *dialect, const char *field)
+{
+        CsvWriter *writer = csv_writer_open_path(WRITER_PATH);
+
+        TEST_ASSERT(csv_writer_set_dialect(writer, dialect) == 0);
+        TEST_ASSERT(csv_writer_field(writer, "a", 1) == 0);
+        errno = 0;
+        TEST_ASSERT(csv_writer_field(writer, field, strlen(field)) == -1 && errno == EINVAL);
+        TEST_ASSERT(csv_writer_end_record(writer) == -1);
+        errno = 0;
+        TEST_ASSERT(csv_writer_close(writer) == -1 && errno == EINVAL);
+        remove(WRITER_PATH);
+}
+
+/**
+ * Write numbers with the formatting paths of the writer
+ * @return the content of the file, to be freed
+ */
+static char *writer_numbers(size_t *len)
+{
+        static const double values[] = {0.1, 1.5, -2.25, 1e300, -1e-300, 123456789.123456789, 3.14159265358979};
+        CsvWriter *writer = csv_writer_open_path(WRITER_PATH);
+        char *data;
+        size_t i;
+
+        for (i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+                // Shortest, fast fixed point and fixed point beyond the exact integers
+                TEST_ASSERT(csv_writer_field_double(writer, values[i], -1) == 0);
+                TEST_ASSERT(csv_writer_field_double(writer, values[i], 3) == 0);
+                TEST_ASSERT(csv_writer_field_double(writer, values[i] * 1e20, 2) == 0);
+                TEST_ASSERT(csv_writer_end_record(writer) == 0);
+        }
+        TEST_ASSERT(csv_writer_close(writer) == 0);
+        data = test_read_file(WRITER_PATH, len);
+        remove(WRITER_PATH);
+        return data;
+}
+
+/**
+ * Numbers are written with the decimal point '.' whatever the locale, so
+ * that they are not quoted and read back as numbers
+ */
+static void writer_locale(void)
+{
+        size_t len, localeLength;
+        char *expected = writer_numbers(&len);
+        char *written;
+
+        TEST_ASSERT(expected != NULL && memchr(expected, '"', len) == NULL);
+        // Only checked where such a locale is installed
+        if (expected == NULL || !test_comma_locale()) {
+                free(expected);
+                return;
+        }
+
+        written = writer_numbers(&localeLength);
+        setlocale(LC_NUMERIC, "C");
+        TEST_ASSERT(written != NULL && localeLength == len && memcmp(written, expected, len) == 0);
+        free(written);
+        free(expected);
+}
+
+void test_writer(void)
+{
+        Dialect dialect;
+
+        test_random_seed(42);
+        dialect_init(&dialect, ',');
+        writer_round_trip(&dialect, "ab ,\"\r\n\t", 1);
+        dialect_init(&dialect, '\t');
+        writer_round_trip(&dialect, "ab \t\"\r\n,", 0);
+        dialect_init(&dialect, '|');
+        writer_round_trip(&dialect, "ab |\"\r\n", 0);
+
+        // Escape other than the quote, trimming, line endings
+        writer_dialect(&dialect, ';', '"', '\\', DIALECT_LINE_ANY, 0);
+        writer_round_trip(&dialect, "ab ;\"\\\r\n", 1);
+        writer_dialect(&dialect, ',', '\'', '\'', DIALECT_LINE_LF, 1);
+        writer_round_trip(&dialect, "ab ,'\"\r\n\t", 0);
+        writer_dialect(&dialect, ',', '"', '"', DIALECT_LINE_CR, 0);
+        writer_round_trip(&dialect, "ab ,\"\r\n", 0);
+        writer_dialect(&dialect, ',', '"', '\\', DIALECT_LINE_LF, 1);
+        writer_round_trip(&dialect, "ab ,\"\\\r\n\t", 0);
+
+        // Without quotes the special characters are escaped
+        writer_dialect(&dialect, ',', 0, '\\', DIALECT_LINE_LF, 0);
+        writer_round_trip(&dialect, "ab ,\\\r\n\"", 1);
+        writer_dialect(&dialect, '\t', 0, '\\', DIALECT_LINE_ANY, 1);
+        writer_round_trip(&dialect, "ab \t\\\r\n", 0);
+
+        // Without escape, fields cannot contain quotes, nor special
+        // characters if there is no quote
+        writer_dialect(&dialect, ',', '"', 0, DIALECT_LINE_ANY, 0);
+        writer_round_trip(&dialect, "ab ,\r\n", 0);
+        writer_reject(&dialect, "a\"b");
+        writer_dialect(&dialect, ',', 0, 0, DIALECT_LINE_ANY, 0);
+        writer_round_trip(&dialect, "ab\"", 0);
+        writer_reject(&dialect, "a,b");
+        writer_reject(&dialect, "a\nb");
+        writer_dialect(&dialect, ',', 0, 0, DIALECT_LINE_LF, 1);
+        writer_reject(&dialect, " a");
+
+        writer_locale();
+}